@@ -0,0 +1,33 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include <gauge/gauge.hpp>
+
+// Every thread increments a counter shared by all threads
+std::atomic<uint64_t> shared_counter(0);
+
+BENCHMARK_THREADS(MultipleThreads, SharedAtomic, 10, 2)
+{
+    RUN
+    {
+        shared_counter.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::mutex counter_mutex;
+uint64_t locked_counter = 0;
+
+BENCHMARK_THREADS(MultipleThreads, SharedMutex, 10, 2)
+{
+    RUN
+    {
+        std::lock_guard<std::mutex> lock(counter_mutex);
+        ++locked_counter;
+    }
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/gauge.hpp>
+#include <cstdint>
+
+// Compare the times of these benchmarks to see what the optimization
+// barriers do. In an optimized build the unused squares are removed and
+// only the RUN loop is left, which is reported as optimized away, while
+// the squares kept by the barrier are computed in every iteration.
+
+BENCHMARK(Barriers, UnusedSquare, 10)
+{
+    uint32_t value = 3;
+    RUN
+    {
+        for (uint32_t i = 0; i < 4; ++i)
+            value = value * value + 1;
+    }
+}
+
+BENCHMARK(Barriers, KeptSquare, 10)
+{
+    uint32_t value = 3;
+    RUN
+    {
+        for (uint32_t i = 0; i < 4; ++i)
+            value = value * value + 1;
+
+        gauge::do_not_optimize(value);
+    }
+}
+
+// The barriers emit no instructions, so a dependency chain takes about
+// as long with a barrier in every step as without it
+
+BENCHMARK(Barriers, Chain, 10)
+{
+    RUN
+    {
+        uint64_t x = 3;
+        for (uint32_t i = 0; i < 1000; ++i)
+            x = x * x + i;
+
+        gauge::do_not_optimize(x);
+    }
+}
+
+BENCHMARK(Barriers, ChainWithBarrier, 10)
+{
+    RUN
+    {
+        uint64_t x = 3;
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            x = x * x + i;
+            gauge::do_not_optimize(x);
+        }
+    }
+}
@@ -24,6 +24,10 @@ uint32_t max_container(const Container& one)
             if (*it > max)
                 max = *it;
         }
+
+        // Without the barrier the compiler sees that the loop gives the
+        // same result every time and only runs it once
+        gauge::do_not_optimize(max);
     }
     return max;
 }
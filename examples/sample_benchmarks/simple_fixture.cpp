@@ -27,15 +27,12 @@ public:
 
     void test_body()
     {
-        volatile uint32_t max_value;
-
         RUN
         {
-            max_value = *std::max_element(std::begin(m_container),
-                                          std::end(m_container));
+            uint32_t max_value = *std::max_element(std::begin(m_container),
+                                                   std::end(m_container));
+            gauge::do_not_optimize(max_value);
         }
-
-        (void) max_value;
     }
 
 protected:
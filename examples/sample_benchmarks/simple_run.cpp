@@ -32,6 +32,10 @@ BENCHMARK(SimpleRun, MaxArray, 100)
         y[i] = rand();
     }
 
+    // Every run reads two arrays and writes one, the throughput is
+    // stored next to the time
+    set_bytes_processed(3 * elements * sizeof(double));
+
     // This is where the clock runs
     RUN
     {
@@ -68,3 +72,20 @@ BENCHMARK(SimpleRun, MaxArrayOpt, 100)
         max_array_opt(&x[0], &y[0], &z[0], elements);
     }
 }
+
+BENCHMARK(SimpleRun, TableLookup, 10)
+{
+    std::vector<uint8_t> table(256);
+    for (uint32_t i = 0; i < table.size(); ++i)
+        table[i] = static_cast<uint8_t>(rand());
+
+    uint8_t value = 0;
+
+    // A single lookup takes a few nanoseconds, so we run it in batches
+    // to keep the cost of the RUN loop out of the measurement
+    RUN_BATCH(16)
+    {
+        value = table[value];
+        gauge::do_not_optimize(value);
+    }
+}
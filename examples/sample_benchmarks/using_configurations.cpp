@@ -44,12 +44,11 @@ public:
 
     void test_body()
     {
-        volatile uint32_t sum;
         RUN
         {
-            sum = std::accumulate(m_vector.begin(), m_vector.end(), 0);
+            uint32_t sum = std::accumulate(m_vector.begin(), m_vector.end(), 0);
+            gauge::do_not_optimize(sum);
         }
-        (void)sum; // Suppress warning about unused variable
     }
 
     void tear_down()
@@ -89,26 +89,24 @@ inline uint32_t count_naive(uint32_t v)
 
 BENCHMARK_F_INLINE(using_options, CountBits, count_bk, 10)
 {
-    volatile uint32_t sum = 0;
-
     RUN
     {
+        uint32_t sum = 0;
         for (auto v: m_vector)
             sum += count_bk(v);
-    }
 
-    (void) sum; // Suppress warning about unused variable
+        gauge::do_not_optimize(sum);
+    }
 }
 
 BENCHMARK_F_INLINE(using_options, CountBits, count_naive, 10)
 {
-    volatile uint32_t sum = 0;
-
     RUN
     {
+        uint32_t sum = 0;
         for (auto v: m_vector)
             sum += count_naive(v);
-    }
 
-    (void) sum; // Suppress warning about unused variable
+        gauge::do_not_optimize(sum);
+    }
 }
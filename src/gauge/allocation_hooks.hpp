@@ -0,0 +1,208 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+// Replaces the global operator new and delete to count the heap
+// allocations for the --track_allocations option. Include this file in
+// exactly one translation unit of the benchmark program, e.g. the one
+// defining main(). Allocations made with malloc() directly are not
+// counted, see gauge/malloc_hooks.hpp for that. The over-aligned
+// operator new and delete are replaced too when the compiler supports
+// them (C++17 or -faligned-new).
+
+#include <cstdlib>
+#include <new>
+
+#include "allocation_tracker.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// Tells the tracker that the hooks are compiled into the program
+struct allocation_hooks_installer
+{
+    allocation_hooks_installer()
+    {
+        allocation_tracker::set_available();
+    }
+} allocation_hooks_installer_instance;
+
+/// Allocates and records the allocation
+inline void* allocate_tracked(std::size_t size)
+{
+    allocation_tracker::record_allocation(size);
+
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr)
+        throw std::bad_alloc();
+
+    return pointer;
+}
+
+/// Frees and records the free
+inline void free_tracked(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        allocation_tracker::record_free();
+
+    std::free(pointer);
+}
+
+#if defined(__cpp_aligned_new)
+/// Allocates with the given alignment and records the allocation
+inline void* allocate_aligned_tracked(std::size_t size, std::size_t alignment)
+{
+    allocation_tracker::record_allocation(size);
+
+    if (size == 0)
+        size = 1;
+
+    #if defined(_WIN32)
+    void* pointer = _aligned_malloc(size, alignment);
+    #else
+    // posix_memalign() requires at least the alignment of a pointer
+    if (alignment < sizeof(void*))
+        alignment = sizeof(void*);
+
+    void* pointer = nullptr;
+    if (posix_memalign(&pointer, alignment, size) != 0)
+        pointer = nullptr;
+    #endif
+
+    return pointer;
+}
+
+/// Frees an aligned allocation and records the free
+inline void free_aligned_tracked(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        allocation_tracker::record_free();
+
+    #if defined(_WIN32)
+    _aligned_free(pointer);
+    #else
+    std::free(pointer);
+    #endif
+}
+#endif
+}
+}
+
+void* operator new(std::size_t size)
+{
+    return gauge::allocate_tracked(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return gauge::allocate_tracked(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    gauge::allocation_tracker::record_allocation(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    gauge::allocation_tracker::record_allocation(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    gauge::free_tracked(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    gauge::free_tracked(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    gauge::free_tracked(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    gauge::free_tracked(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    gauge::free_tracked(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    gauge::free_tracked(pointer);
+}
+
+#if defined(__cpp_aligned_new)
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    void* pointer = gauge::allocate_aligned_tracked(
+        size, static_cast<std::size_t>(alignment));
+    if (pointer == nullptr)
+        throw std::bad_alloc();
+
+    return pointer;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept
+{
+    return gauge::allocate_aligned_tracked(
+        size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept
+{
+    return gauge::allocate_aligned_tracked(
+        size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    gauge::free_aligned_tracked(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+    gauge::free_aligned_tracked(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    gauge::free_aligned_tracked(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    gauge::free_aligned_tracked(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t,
+                     const std::nothrow_t&) noexcept
+{
+    gauge::free_aligned_tracked(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t,
+                       const std::nothrow_t&) noexcept
+{
+    gauge::free_aligned_tracked(pointer);
+}
+#endif
@@ -0,0 +1,93 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <atomic>
+
+#include "allocation_tracker.hpp"
+
+namespace gauge
+{
+namespace
+{
+// The state is constant initialized so the hooks may use it before
+// the static constructors have run. The hooks must not allocate.
+std::atomic<bool> available(false);
+
+/// The tracking state of a thread
+struct thread_state
+{
+    bool m_started;
+    bool m_tracking;
+    uint64_t m_allocations;
+    uint64_t m_frees;
+    uint64_t m_bytes;
+};
+
+// Every thread counts its own allocations, so other threads e.g. the
+// printer thread do not disturb the counts of the measuring thread
+thread_local thread_state state = { false, false, 0, 0, 0 };
+}
+
+bool allocation_tracker::is_available()
+{
+    return available.load(std::memory_order_relaxed);
+}
+
+void allocation_tracker::start()
+{
+    state.m_allocations = 0;
+    state.m_frees = 0;
+    state.m_bytes = 0;
+    state.m_started = true;
+    state.m_tracking = true;
+}
+
+void allocation_tracker::stop()
+{
+    state.m_started = false;
+    state.m_tracking = false;
+}
+
+void allocation_tracker::pause()
+{
+    state.m_tracking = false;
+}
+
+void allocation_tracker::resume()
+{
+    state.m_tracking = state.m_started;
+}
+
+allocation_counts allocation_tracker::counts()
+{
+    allocation_counts c;
+    c.m_allocations = state.m_allocations;
+    c.m_frees = state.m_frees;
+    c.m_bytes = state.m_bytes;
+    return c;
+}
+
+void allocation_tracker::set_available()
+{
+    available.store(true, std::memory_order_relaxed);
+}
+
+void allocation_tracker::record_allocation(std::size_t size)
+{
+    if (!state.m_tracking)
+        return;
+
+    ++state.m_allocations;
+    state.m_bytes += size;
+}
+
+void allocation_tracker::record_free()
+{
+    if (!state.m_tracking)
+        return;
+
+    ++state.m_frees;
+}
+}
@@ -0,0 +1,73 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gauge
+{
+/// The heap allocations counted by the allocation tracker
+struct allocation_counts
+{
+    /// The number of allocations
+    uint64_t m_allocations;
+
+    /// The number of frees
+    uint64_t m_frees;
+
+    /// The number of bytes allocated
+    uint64_t m_bytes;
+};
+
+/// Counts the heap allocations of the program while tracking is active.
+///
+/// The allocations are reported by hooks which must be compiled into the
+/// benchmark program by including either gauge/allocation_hooks.hpp,
+/// which replaces the global operator new and delete, or
+/// gauge/malloc_hooks.hpp, which interposes malloc and free on glibc, in
+/// exactly one translation unit. The tracking and the counts belong to
+/// the calling thread: only the allocations and frees of the thread that
+/// called start() are counted, those of other threads e.g. the printer
+/// thread or a thread started by the benchmark are not.
+class allocation_tracker
+{
+public:
+
+    /// @return true if the allocation hooks are compiled into the program
+    static bool is_available();
+
+    /// Resets the counts of the calling thread and starts tracking its
+    /// allocations
+    static void start();
+
+    /// Ends the tracking window, the counts are kept until the next
+    /// start() and a resume() no longer continues the tracking
+    static void stop();
+
+    /// Suspends tracking within the window without resetting the counts
+    static void pause();
+
+    /// Continues tracking after a pause() unless the window was stopped
+    static void resume();
+
+    /// @return the counts of the calling thread since its last start()
+    static allocation_counts counts();
+
+public:
+    // Called by the hooks
+
+    /// Marks the hooks as compiled into the program
+    static void set_available();
+
+    /// Records an allocation
+    /// @param bytes The size of the allocation
+    static void record_allocation(std::size_t bytes);
+
+    /// Records a free
+    static void record_free();
+};
+}
@@ -0,0 +1,416 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "baseline.hpp"
+#include "statistics.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// A JSON value. Scalars keep their text, arrays their elements and
+/// objects their members in order.
+struct json_value
+{
+    enum class kind { scalar, array, object };
+
+    kind m_kind = kind::scalar;
+    std::string m_text;
+    std::vector<json_value> m_elements;
+    std::vector<std::pair<std::string, json_value>> m_members;
+};
+
+/// Minimal recursive descent parser for the output of the json printer
+class json_parser
+{
+public:
+
+    explicit json_parser(const std::string& text) :
+        m_text(text),
+        m_position(0)
+    { }
+
+    /// Parses a JSON document or a sequence of them e.g. JSON Lines
+    std::vector<json_value> parse()
+    {
+        std::vector<json_value> values;
+
+        skip_space();
+        while (m_position != m_text.size())
+        {
+            values.push_back(parse_value());
+            skip_space();
+        }
+
+        return values;
+    }
+
+private:
+
+    json_value parse_value()
+    {
+        skip_space();
+        if (m_position == m_text.size())
+            fail();
+
+        json_value value;
+        char c = m_text[m_position];
+
+        if (c == '[')
+        {
+            value.m_kind = json_value::kind::array;
+            ++m_position;
+
+            if (!consume(']'))
+            {
+                do
+                {
+                    value.m_elements.push_back(parse_value());
+                }
+                while (consume(','));
+
+                expect(']');
+            }
+        }
+        else if (c == '{')
+        {
+            value.m_kind = json_value::kind::object;
+            ++m_position;
+
+            if (!consume('}'))
+            {
+                do
+                {
+                    skip_space();
+                    std::string name = parse_string();
+                    expect(':');
+                    value.m_members.emplace_back(name, parse_value());
+                }
+                while (consume(','));
+
+                expect('}');
+            }
+        }
+        else if (c == '"')
+        {
+            value.m_text = parse_string();
+        }
+        else
+        {
+            // Numbers, true, false and null are kept as their text
+            std::size_t start = m_position;
+            while (m_position < m_text.size() &&
+                   m_text[m_position] != ',' && m_text[m_position] != ']' &&
+                   m_text[m_position] != '}' &&
+                   !std::isspace(static_cast<unsigned char>(m_text[m_position])))
+            {
+                ++m_position;
+            }
+
+            value.m_text = m_text.substr(start, m_position - start);
+            if (value.m_text == "null")
+                value.m_text.clear();
+        }
+
+        return value;
+    }
+
+    std::string parse_string()
+    {
+        expect('"');
+
+        std::string result;
+        while (m_position < m_text.size() && m_text[m_position] != '"')
+        {
+            char c = m_text[m_position++];
+            if (c == '\\' && m_position < m_text.size())
+                c = m_text[m_position++];
+
+            result += c;
+        }
+
+        expect('"');
+        return result;
+    }
+
+    void skip_space()
+    {
+        while (m_position < m_text.size() &&
+               std::isspace(static_cast<unsigned char>(m_text[m_position])))
+        {
+            ++m_position;
+        }
+    }
+
+    bool consume(char c)
+    {
+        skip_space();
+        if (m_position < m_text.size() && m_text[m_position] == c)
+        {
+            ++m_position;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c)
+    {
+        if (!consume(c))
+            fail();
+    }
+
+    void fail() const
+    {
+        throw std::runtime_error("Error malformed json in baseline at "
+                                 "offset " + std::to_string(m_position));
+    }
+
+private:
+
+    const std::string& m_text;
+    std::size_t m_position;
+};
+
+/// Expands a table written by the json printer into rows
+void add_json_table(const json_value& table, std::vector<result_row>& rows)
+{
+    if (table.m_kind != json_value::kind::object)
+        throw std::runtime_error("Error baseline json tables must be objects");
+
+    std::size_t count = 1;
+    for (const auto& m : table.m_members)
+    {
+        if (m.second.m_kind == json_value::kind::array)
+            count = std::max(count, m.second.m_elements.size());
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        result_row row;
+        for (const auto& m : table.m_members)
+        {
+            if (m.second.m_kind != json_value::kind::array)
+                row[m.first] = m.second.m_text;
+            else if (i < m.second.m_elements.size())
+                row[m.first] = m.second.m_elements[i].m_text;
+        }
+        rows.push_back(row);
+    }
+}
+
+/// Splits a line of the csv output into its fields
+std::vector<std::string> split_csv(const std::string& line)
+{
+    std::vector<std::string> fields;
+    std::string field;
+    bool quoted = false;
+
+    for (std::size_t i = 0; i < line.size(); ++i)
+    {
+        char c = line[i];
+
+        if (c == '"')
+        {
+            if (quoted && i + 1 < line.size() && line[i + 1] == '"')
+                field += line[++i];
+            else
+                quoted = !quoted;
+        }
+        else if (c == ',' && !quoted)
+        {
+            fields.push_back(field);
+            field.clear();
+        }
+        else if (c != '\r')
+        {
+            field += c;
+        }
+    }
+
+    fields.push_back(field);
+    return fields;
+}
+
+/// @return true if the text is a number and stores it in value
+bool parse_number(const std::string& text, double& value)
+{
+    if (text.empty())
+        return false;
+
+    std::istringstream stream(text);
+    stream >> value;
+    return stream && stream.peek() == std::istringstream::traits_type::eof();
+}
+}
+
+std::vector<result_row> read_result_file(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if (!file)
+        throw std::runtime_error("Error cannot open baseline '" +
+                                 filename + "'");
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    std::vector<result_row> rows;
+
+    auto first = std::find_if(text.begin(), text.end(), [](char c)
+        { return !std::isspace(static_cast<unsigned char>(c)); });
+
+    if (first != text.end() && (*first == '[' || *first == '{'))
+    {
+        for (const auto& value : json_parser(text).parse())
+        {
+            if (value.m_kind == json_value::kind::array)
+            {
+                for (const auto& table : value.m_elements)
+                    add_json_table(table, rows);
+            }
+            else
+            {
+                add_json_table(value, rows);
+            }
+        }
+
+        return rows;
+    }
+
+    std::istringstream lines(text);
+    std::string line;
+
+    if (!std::getline(lines, line))
+        return rows;
+
+    auto header = split_csv(line);
+
+    while (std::getline(lines, line))
+    {
+        if (line.empty())
+            continue;
+
+        auto fields = split_csv(line);
+        result_row row;
+        for (std::size_t i = 0; i < header.size() && i < fields.size(); ++i)
+        {
+            if (!header[i].empty())
+                row[header[i]] = fields[i];
+        }
+        rows.push_back(row);
+    }
+
+    return rows;
+}
+
+std::vector<double> baseline_values(const std::vector<result_row>& rows,
+                                    const result_row& key,
+                                    const std::string& column)
+{
+    std::vector<double> values;
+
+    for (const auto& row : rows)
+    {
+        bool match = true;
+        for (const auto& k : key)
+        {
+            auto it = row.find(k.first);
+            if (it == row.end() || it->second != k.second)
+            {
+                match = false;
+                break;
+            }
+        }
+
+        if (!match)
+            continue;
+
+        auto it = row.find(column);
+        double value;
+        if (it != row.end() && parse_number(it->second, value))
+            values.push_back(value);
+    }
+
+    return values;
+}
+
+comparison compare_samples(const std::vector<double>& baseline,
+                           const std::vector<double>& current)
+{
+    assert(!baseline.empty());
+    assert(!current.empty());
+
+    comparison c;
+
+    std::vector<double> copy = baseline;
+    double baseline_median = median(copy);
+    copy = current;
+    double current_median = median(copy);
+
+    c.m_ratio = baseline_median != 0 ?
+        current_median / baseline_median : 1.0;
+
+    // Rank the combined samples, ties get the average of their ranks
+    std::vector<std::pair<double, bool>> all;
+    all.reserve(baseline.size() + current.size());
+    for (auto v : baseline)
+        all.emplace_back(v, false);
+    for (auto v : current)
+        all.emplace_back(v, true);
+
+    std::sort(all.begin(), all.end());
+
+    double n1 = static_cast<double>(baseline.size());
+    double n2 = static_cast<double>(current.size());
+    double n = n1 + n2;
+
+    double rank_sum = 0;
+    double ties = 0;
+    for (std::size_t i = 0; i < all.size();)
+    {
+        std::size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first)
+            ++j;
+
+        double t = static_cast<double>(j - i);
+        double rank = (i + j + 1) / 2.0;
+        ties += t * t * t - t;
+
+        for (std::size_t k = i; k < j; ++k)
+        {
+            if (all[k].second)
+                rank_sum += rank;
+        }
+
+        i = j;
+    }
+
+    double u = rank_sum - n2 * (n2 + 1) / 2.0;
+    double mean_u = n1 * n2 / 2.0;
+    double variance = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1)));
+
+    if (variance <= 0)
+    {
+        c.m_p_value = 1.0;
+        return c;
+    }
+
+    // Continuity corrected normal approximation
+    double z = (std::fabs(u - mean_u) - 0.5) / std::sqrt(variance);
+    c.m_p_value = std::min(1.0, std::erfc(std::max(z, 0.0) / std::sqrt(2.0)));
+
+    return c;
+}
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace gauge
+{
+/// A row of a result file, the values are kept as the text they were
+/// written as
+typedef std::map<std::string, std::string> result_row;
+
+/// Reads the results written by the json, jsonl, csv or csv_stream
+/// printer. The format is detected from the content. Constant columns of
+/// the json output are copied into every row.
+/// @param filename The name of the file
+/// @return the rows of all the benchmarks in the file
+std::vector<result_row> read_result_file(const std::string& filename);
+
+/// Collects the values of a column from the rows of a benchmark
+/// @param rows The rows of a result file
+/// @param key The columns identifying the benchmark e.g. the testcase,
+///        the benchmark and the configuration
+/// @param column The column to collect
+/// @return the numeric values of the column in the matching rows
+std::vector<double> baseline_values(const std::vector<result_row>& rows,
+                                    const result_row& key,
+                                    const std::string& column);
+
+/// The comparison of the current results of a benchmark with a baseline
+struct comparison
+{
+    /// The current median divided by the baseline median
+    double m_ratio;
+
+    /// The two-sided p-value of the Mann-Whitney U test of the hypothesis
+    /// that both samples come from the same distribution
+    double m_p_value;
+};
+
+/// Compares two samples with the Mann-Whitney U test using the normal
+/// approximation with tie correction
+/// @param baseline The baseline sample
+/// @param current The current sample
+/// @return the comparison
+comparison compare_samples(const std::vector<double>& baseline,
+                           const std::vector<double>& current);
+}
@@ -11,10 +11,13 @@
 #include <tables/table.hpp>
 
 #include <cassert>
+#include <map>
 #include <vector>
 #include <string>
 
 #include "config_set.hpp"
+#include "resource_usage.hpp"
+#include "run_quality.hpp"
 #include "results.hpp"
 
 namespace gauge
@@ -22,13 +25,29 @@ namespace gauge
 
 namespace po = boost::program_options;
 
+/// How a user counter is turned into a result column
+enum class counter_mode
+{
+    /// The value counted during the measurement
+    total,
+
+    /// The value per run of the body of the RUN loop
+    average,
+
+    /// The value per second of the measurement
+    rate
+};
+
 /// Base class for all benchmark.
 class benchmark
 {
 public:
 
     /// Constructor
-    benchmark()
+    benchmark() :
+        m_batch_size(1),
+        m_bytes_processed(0),
+        m_items_processed(0)
     { }
 
     /// Destructor
@@ -47,6 +66,21 @@ public:
         return m_id;
     }
 
+    /// @param batch_size the number of times the body of the RUN loop is
+    ///        run in every iteration, set by the iteration controller
+    void set_batch_size(uint32_t batch_size)
+    {
+        assert(batch_size > 0);
+        m_batch_size = batch_size;
+    }
+
+    /// @return the number of times the body of the RUN loop is run in
+    ///         every iteration. One unless RUN_BATCH is used.
+    uint32_t batch_size() const
+    {
+        return m_batch_size;
+    }
+
     /// Store the results of the test run in the result table
     /// @param results The table containing the results
     virtual void store_run(tables::table& results) = 0;
@@ -59,6 +93,14 @@ public:
         (void) results;
     }
 
+    /// Allows the benchmark to store the results which are computed
+    /// from all the runs, called once after the last run.
+    /// @param results The table containing the results
+    virtual void finish_table(tables::table& results)
+    {
+        (void) results;
+    }
+
     /// Add options to the available commandline arguments
     virtual void get_options(po::variables_map& options)
     {
@@ -84,6 +126,13 @@ public:
     /// @return the number of runs to be completed for this benchmark
     virtual uint32_t runs() const = 0;
 
+    /// @return the number of threads running the body of the RUN loop
+    ///         at the same time, see thread_benchmark
+    virtual uint32_t threads() const
+    {
+        return 1;
+    }
+
     /// Reset the state of a measurement controller
     virtual void init()
     { }
@@ -95,6 +144,14 @@ public:
         return 1;
     };
 
+    /// @return the number of iterations of the last measurement. After
+    ///         a measurement is accepted iteration_count() may already
+    ///         return the count for the next measurement.
+    virtual uint64_t run_iterations() const
+    {
+        return iteration_count();
+    }
+
     /// @return the number of configurations create for this
     ///         benchmark
     uint32_t configuration_count() const
@@ -147,6 +204,42 @@ public:
     /// Stops a measurement
     virtual void stop() = 0;
 
+    /// Pauses the measurement inside the RUN loop, the work done until
+    /// resume() is called is not measured
+    virtual void pause()
+    { }
+
+    /// Resumes a measurement paused with pause()
+    virtual void resume()
+    { }
+
+    /// @return the interval in iterations at which the iteration
+    ///         controller should sample the latency of a single
+    ///         iteration. Zero disables the sampling, one samples every
+    ///         iteration.
+    virtual uint64_t sample_interval() const
+    {
+        return 0;
+    }
+
+    /// Called by the iteration controller at the end of an iteration
+    /// when sampling iteration latencies.
+    /// @param record True if the iteration which just ended should be
+    ///        recorded. False if this only marks the start of the next
+    ///        iteration which is the one to be sampled.
+    virtual void sample_iteration(bool record)
+    {
+        (void) record;
+    }
+
+    /// @return the relative slowdown compared to the --baseline results
+    ///         above which the benchmark counts as regressed e.g. 0.1
+    ///         for 10%. A negative value uses --regression_threshold.
+    virtual double regression_threshold() const
+    {
+        return -1;
+    }
+
     /// @return true if a warm-up iteration is needed
     virtual bool needs_warmup_iteration() { return false; }
 
@@ -156,6 +249,146 @@ public:
     /// Returns the unit we are measuring
     virtual std::string unit_text() const = 0;
 
+    /// Returns the unit of a specific result column. Benchmarks storing
+    /// results in other units than unit_text() should override this.
+    /// @param column The name of the result column
+    /// @return the unit of the column
+    virtual std::string column_unit(const std::string& column) const
+    {
+        if (column == "throughput" && m_bytes_processed > 0)
+            return "megabytes/second";
+
+        if (column == "items_per_second" && m_items_processed > 0)
+            return "items/second";
+
+        std::string resource_unit = resource_usage_unit(column);
+        if (!resource_unit.empty())
+            return resource_unit;
+
+        std::string noise_unit = run_noise_unit(column);
+        if (!noise_unit.empty())
+            return noise_unit;
+
+        auto it = m_counters.find(column);
+        if (it != m_counters.end())
+        {
+            switch (it->second.m_mode)
+            {
+            case counter_mode::total:
+                return column;
+            case counter_mode::average:
+                return column + "/iteration";
+            case counter_mode::rate:
+                return column + "/second";
+            }
+        }
+
+        return unit_text();
+    }
+
+    /// @return the duration of the last measurement in seconds, used to
+    ///         calculate the rates. Zero if the benchmark does not
+    ///         measure time in which case no rates are stored.
+    virtual double elapsed_seconds() const
+    {
+        return 0;
+    }
+
+    /// Declares the number of bytes processed by every run of the body
+    /// of the RUN loop. The throughput is stored in megabytes per second
+    /// in the "throughput" column.
+    /// @param bytes The number of bytes
+    void set_bytes_processed(uint64_t bytes)
+    {
+        m_bytes_processed = bytes;
+    }
+
+    /// Declares the number of items e.g. packets processed by every run
+    /// of the body of the RUN loop. The rate is stored in the
+    /// "items_per_second" column.
+    /// @param items The number of items
+    void set_items_processed(uint64_t items)
+    {
+        m_items_processed = items;
+    }
+
+    /// Returns a named user counter which is stored in a column of the
+    /// same name. The counter is reset before every measurement.
+    ///
+    /// The counter is looked up by its name, so get it once outside the
+    /// RUN loop. The returned reference stays valid for the lifetime of
+    /// the benchmark.
+    ///
+    /// Example:
+    ///
+    ///    double& packets = counter("packets", gauge::counter_mode::rate);
+    ///
+    ///    RUN
+    ///    {
+    ///        packets += receive();
+    ///    }
+    ///
+    /// @param name The name of the counter and its column
+    /// @param mode How the counted value is stored
+    /// @return a reference to the value of the counter
+    double& counter(const std::string& name,
+                    counter_mode mode = counter_mode::total)
+    {
+        auto& c = m_counters[name];
+        c.m_mode = mode;
+        return c.m_value;
+    }
+
+    /// Resets the values of the user counters before a measurement
+    virtual void reset_counters()
+    {
+        for (auto& c : m_counters)
+            c.second.m_value = 0;
+    }
+
+    /// Stores the throughput, item rate and user counters of the last
+    /// measurement in the results
+    /// @param results The table containing the results
+    /// @param iterations The number of runs of the body of the RUN loop
+    void store_counters(tables::table& results, uint64_t iterations) const
+    {
+        assert(iterations > 0);
+        double seconds = elapsed_seconds();
+
+        if (m_bytes_processed > 0 && seconds > 0)
+        {
+            double bytes = static_cast<double>(m_bytes_processed) * iterations;
+            set_counter_value(results, "throughput", bytes / seconds / 1e6);
+        }
+
+        if (m_items_processed > 0 && seconds > 0)
+        {
+            double items = static_cast<double>(m_items_processed) * iterations;
+            set_counter_value(results, "items_per_second", items / seconds);
+        }
+
+        for (const auto& c : m_counters)
+        {
+            switch (c.second.m_mode)
+            {
+            case counter_mode::total:
+                set_counter_value(results, c.first, c.second.m_value);
+                break;
+            case counter_mode::average:
+                set_counter_value(results, c.first,
+                                  c.second.m_value / iterations);
+                break;
+            case counter_mode::rate:
+                if (seconds > 0)
+                {
+                    set_counter_value(results, c.first,
+                                      c.second.m_value / seconds);
+                }
+                break;
+            }
+        }
+    }
+
     /// Implemented by the user contains the actual test
     /// When a user uses the BENCHMARK{ code-section } the
     /// code-section contains the guts of the test_body
@@ -178,6 +411,30 @@ public:
         return false;
     }
 
+private:
+
+    /// Stores a counter value, creating its column if needed
+    static void set_counter_value(tables::table& results,
+                                  const std::string& column, double value)
+    {
+        if (!results.has_column(column))
+            results.add_column(column);
+
+        results.set_value(column, value);
+    }
+
+private:
+
+    /// A named user counter
+    struct user_counter
+    {
+        /// The value counted in the current measurement
+        double m_value = 0;
+
+        /// How the value is stored
+        counter_mode m_mode = counter_mode::total;
+    };
+
 private:
     /// The benchmark id given by the static call to
     /// register_id in the runner
@@ -186,6 +443,18 @@ private:
     /// Stores the current configuration index
     uint32_t m_config_index;
 
+    /// The number of times the body is run in every iteration
+    uint32_t m_batch_size;
+
+    /// The number of bytes processed by every run of the body
+    uint64_t m_bytes_processed;
+
+    /// The number of items processed by every run of the body
+    uint64_t m_items_processed;
+
+    /// The user counters
+    std::map<std::string, user_counter> m_counters;
+
     /// Stores the different configurations
     std::vector<config_set> m_configurations;
 };
@@ -0,0 +1,129 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cassert>
+#include <map>
+#include <string>
+
+#include <tables/table.hpp>
+
+#include "benchmark.hpp"
+
+namespace gauge
+{
+/// An immutable copy of what the printers need to know about a benchmark
+/// whose results are printed: its names, units, configuration, thread
+/// count, regression threshold and duration. The printers may run on
+/// another thread while the benchmark itself moves on to its next
+/// configuration, so they are given a snapshot instead of the benchmark.
+class benchmark_snapshot : public benchmark
+{
+public:
+
+    /// Takes the snapshot
+    /// @param info The benchmark
+    /// @param results The results of the benchmark, the units of all its
+    ///        columns are kept
+    /// @param duration The time the benchmark took in microseconds
+    benchmark_snapshot(const benchmark& info, const tables::table& results,
+                       double duration) :
+        m_testcase_name(info.testcase_name()),
+        m_benchmark_name(info.benchmark_name()),
+        m_unit_text(info.unit_text()),
+        m_runs(info.runs()),
+        m_threads(info.threads()),
+        m_regression_threshold(info.regression_threshold()),
+        m_duration(duration)
+    {
+        for (const auto& column : results.columns())
+            m_column_units[column] = info.column_unit(column);
+
+        if (info.has_configurations())
+        {
+            add_configuration(info.get_current_configuration());
+            set_current_configuration(0);
+        }
+    }
+
+    /// @return the time the benchmark took in microseconds, measured on
+    ///         the thread running the benchmark
+    double duration() const
+    {
+        return m_duration;
+    }
+
+public:
+    // From benchmark
+
+    std::string testcase_name() const
+    {
+        return m_testcase_name;
+    }
+
+    std::string benchmark_name() const
+    {
+        return m_benchmark_name;
+    }
+
+    std::string unit_text() const
+    {
+        return m_unit_text;
+    }
+
+    std::string column_unit(const std::string& column) const
+    {
+        auto it = m_column_units.find(column);
+        return it != m_column_units.end() ? it->second : m_unit_text;
+    }
+
+    uint32_t runs() const
+    {
+        return m_runs;
+    }
+
+    uint32_t threads() const
+    {
+        return m_threads;
+    }
+
+    double regression_threshold() const
+    {
+        return m_regression_threshold;
+    }
+
+    void store_run(tables::table& /*results*/)
+    {
+        assert(0 && "a snapshot cannot be run");
+    }
+
+    void start()
+    {
+        assert(0 && "a snapshot cannot be run");
+    }
+
+    void stop()
+    {
+        assert(0 && "a snapshot cannot be run");
+    }
+
+    void test_body()
+    {
+        assert(0 && "a snapshot cannot be run");
+    }
+
+private:
+
+    std::string m_testcase_name;
+    std::string m_benchmark_name;
+    std::string m_unit_text;
+    uint32_t m_runs;
+    uint32_t m_threads;
+    double m_regression_threshold;
+    double m_duration;
+    std::map<std::string, std::string> m_column_units;
+};
+}
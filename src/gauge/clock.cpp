@@ -0,0 +1,213 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cassert>
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "clock.hpp"
+#include "tsc_clock.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// Clock using one of the std::chrono clocks
+template<class Clock>
+class chrono_clock : public clock
+{
+public:
+
+    explicit chrono_clock(const std::string& name) :
+        m_name(name)
+    { }
+
+    std::string name() const
+    {
+        return m_name;
+    }
+
+    uint64_t start()
+    {
+        return Clock::now().time_since_epoch().count();
+    }
+
+    uint64_t stop()
+    {
+        return Clock::now().time_since_epoch().count();
+    }
+
+    double nanoseconds(uint64_t ticks) const
+    {
+        using period = typename Clock::period;
+        return static_cast<double>(ticks) * 1e9 * period::num / period::den;
+    }
+
+private:
+
+    std::string m_name;
+};
+
+#if defined(__unix__)
+/// Clock using one of the POSIX clock_gettime() clocks. The ticks
+/// are nanoseconds.
+class posix_clock : public clock
+{
+public:
+
+    posix_clock(const std::string& name, clockid_t clock_id) :
+        m_name(name),
+        m_clock_id(clock_id)
+    { }
+
+    std::string name() const
+    {
+        return m_name;
+    }
+
+    uint64_t start()
+    {
+        return read();
+    }
+
+    uint64_t stop()
+    {
+        return read();
+    }
+
+    double nanoseconds(uint64_t ticks) const
+    {
+        return static_cast<double>(ticks);
+    }
+
+private:
+
+    uint64_t read() const
+    {
+        timespec ts;
+        ::clock_gettime(m_clock_id, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL +
+               static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+private:
+
+    std::string m_name;
+    clockid_t m_clock_id;
+};
+#endif
+}
+
+const clock_properties& measure_clock(clock& c)
+{
+    static std::map<std::string, clock_properties> cache;
+
+    auto it = cache.find(c.name());
+    if (it != cache.end())
+        return it->second;
+
+    clock_properties p;
+
+    // The resolution is the smallest step we observe when spinning on
+    // the clock until its value changes
+    uint64_t resolution = 0;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        uint64_t first = c.start();
+        uint64_t next = c.start();
+        while (next <= first)
+            next = c.start();
+
+        uint64_t step = next - first;
+        if (resolution == 0 || step < resolution)
+            resolution = step;
+    }
+    p.m_resolution = c.nanoseconds(resolution);
+
+    // The read cost is the fastest of a number of trials each reading
+    // the clock a fixed number of times
+    const uint32_t reads = 1000;
+    p.m_read_cost = 0;
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        uint64_t start = c.start();
+        for (uint32_t j = 0; j < reads; ++j)
+            c.start();
+        uint64_t stop = c.stop();
+
+        double cost = c.nanoseconds(stop - start) / reads;
+        if (i == 0 || cost < p.m_read_cost)
+            p.m_read_cost = cost;
+    }
+
+    assert(p.m_resolution > 0);
+    return cache[c.name()] = p;
+}
+
+std::shared_ptr<clock> make_clock(const std::string& name)
+{
+    if (name == "high_resolution")
+    {
+        return std::make_shared<
+            chrono_clock<std::chrono::high_resolution_clock>>(name);
+    }
+
+    if (name == "steady")
+    {
+        return std::make_shared<
+            chrono_clock<std::chrono::steady_clock>>(name);
+    }
+
+#if defined(__linux__)
+    if (name == "monotonic_raw")
+    {
+        return std::make_shared<posix_clock>(name, CLOCK_MONOTONIC_RAW);
+    }
+#endif
+
+#if defined(__unix__)
+    if (name == "thread_cputime")
+    {
+        return std::make_shared<posix_clock>(name, CLOCK_THREAD_CPUTIME_ID);
+    }
+
+    if (name == "process_cputime")
+    {
+        return std::make_shared<posix_clock>(name, CLOCK_PROCESS_CPUTIME_ID);
+    }
+#endif
+
+    if (name == "tsc" && tsc_clock::is_available())
+    {
+        return std::make_shared<tsc_clock>();
+    }
+
+    throw std::runtime_error("Error clock '" + name + "' is not available");
+}
+
+std::vector<std::string> clock_names()
+{
+    std::vector<std::string> names = { "high_resolution", "steady" };
+
+#if defined(__linux__)
+    names.push_back("monotonic_raw");
+#endif
+
+#if defined(__unix__)
+    names.push_back("thread_cputime");
+    names.push_back("process_cputime");
+#endif
+
+    if (tsc_clock::is_available())
+        names.push_back("tsc");
+
+    return names;
+}
+}
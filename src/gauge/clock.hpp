@@ -0,0 +1,73 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gauge
+{
+/// Interface for the clocks used by the time_benchmark. A clock
+/// returns raw ticks when read, the ticks are only converted to
+/// nanoseconds once the measurement is complete. This keeps the
+/// conversion cost out of the measured interval.
+class clock
+{
+public:
+
+    /// Destructor
+    virtual ~clock()
+    { }
+
+    /// @return the name of the clock e.g. "tsc". This is the name
+    ///         used with the --clock option and stored in the results.
+    virtual std::string name() const = 0;
+
+    /// Reads the clock when starting a measurement. Clocks which
+    /// need to serialize the instruction stream should make sure
+    /// that no prior instructions leak into the measured interval.
+    /// @return the current tick count
+    virtual uint64_t start() = 0;
+
+    /// Reads the clock when stopping a measurement. Clocks which
+    /// need to serialize the instruction stream should make sure
+    /// that all measured instructions have completed.
+    /// @return the current tick count
+    virtual uint64_t stop() = 0;
+
+    /// @param ticks The number of ticks elapsed between two reads
+    /// @return the elapsed ticks converted to nanoseconds
+    virtual double nanoseconds(uint64_t ticks) const = 0;
+};
+
+/// The properties of a clock measured on the current machine
+struct clock_properties
+{
+    /// The smallest observed non-zero difference in nanoseconds
+    /// between two consecutive reads of the clock
+    double m_resolution;
+
+    /// The cost in nanoseconds of reading the clock
+    double m_read_cost;
+};
+
+/// Measures the resolution and read cost of a clock. The measurement
+/// runs once for every clock name and the result is cached.
+/// @param c The clock to measure
+/// @return the properties of the clock
+const clock_properties& measure_clock(clock& c);
+
+/// Creates a clock by its name.
+/// @param name The name of the clock e.g. "steady" or "tsc"
+/// @return the clock, throws std::runtime_error if the clock is
+///         unknown or not available on this platform
+std::shared_ptr<clock> make_clock(const std::string& name);
+
+/// @return the names of the clocks available on this platform
+std::vector<std::string> clock_names();
+}
@@ -5,16 +5,22 @@
 
 #pragma once
 
+#include <algorithm>
 #include <iomanip>
 #include <chrono>
+#include <map>
+#include <set>
 #include <vector>
 #include <string>
 
 #include <tables/format.hpp>
 
+#include "benchmark_snapshot.hpp"
+#include "outliers.hpp"
 #include "printer.hpp"
 #include "statistics.hpp"
 #include "console_colors.hpp"
+#include "topdown.hpp"
 
 namespace gauge
 {
@@ -49,16 +55,6 @@ public:
                   << console::textdefault << std::endl;
     }
 
-    void start_benchmark()
-    {
-        m_benchmark_start = std::chrono::high_resolution_clock::now();
-    }
-
-    void end_benchmark()
-    {
-        m_benchmark_stop = std::chrono::high_resolution_clock::now();
-    }
-
 
     void benchmark_result(const benchmark& info,
                           const tables::table& results)
@@ -69,6 +65,12 @@ public:
         statistics iter =
             calculate_statistics(iterations.cbegin(), iterations.cend());
 
+        // The columns shown on the RUN line and the dedicated lines below
+        // are not printed again. The run indices are not results, and the
+        // unit is printed next to every result.
+        std::set<std::string> shown = { "testcase", "benchmark", "unit",
+                                        "iterations", "run_number", "copy" };
+
         // Describe the beginning of the run.
         std::cout << std::fixed << console::textgreen << "[ RUN      ]"
                   << console::textdefault << " "
@@ -77,8 +79,60 @@ public:
                   << " (" << results.rows()
                   << (results.rows() == 1 ? " run " : " runs ")
                   << "/ " << iter.m_mean << " "
-                  << (iter.m_mean == 1 ? "iteration" : "iterations")
-                  << ")" << std::endl;
+                  << (iter.m_mean == 1 ? "iteration" : "iterations");
+
+        if (results.has_column("batch_size") &&
+            results.is_column<uint32_t>("batch_size"))
+        {
+            shown.insert("batch_size");
+            std::cout << " / batch "
+                      << results.values_as<uint32_t>("batch_size").front();
+        }
+
+        if (results.has_column("threads") &&
+            results.is_column<uint32_t>("threads"))
+        {
+            shown.insert("threads");
+            uint32_t threads =
+                results.values_as<uint32_t>("threads").front();
+            std::cout << " / " << threads
+                      << (threads == 1 ? " thread" : " threads");
+        }
+
+        if (results.has_column("copies") &&
+            results.is_column<uint32_t>("copies"))
+        {
+            shown.insert("copies");
+            std::cout << " / "
+                      << results.values_as<uint32_t>("copies").front()
+                      << " copies";
+        }
+
+        if (results.has_column("rejected_runs") &&
+            results.is_column<uint32_t>("rejected_runs"))
+        {
+            shown.insert("rejected_runs");
+            std::cout << " / "
+                      << results.values_as<uint32_t>("rejected_runs").front()
+                      << " rejected";
+        }
+
+        if (results.has_column("rel_ci") &&
+            results.has_column("target_rel_ci"))
+        {
+            shown.insert("rel_ci");
+            shown.insert("target_rel_ci");
+            double rel_ci = results.values_as<double>("rel_ci").front();
+            double target =
+                results.values_as<double>("target_rel_ci").front();
+
+            std::cout << std::setprecision(2) << " / CI +-"
+                      << rel_ci * 100.0 << " %"
+                      << (rel_ci <= target ? "" : " above target")
+                      << std::setprecision(6);
+        }
+
+        std::cout << ")" << std::endl;
 
         if (info.has_configurations())
         {
@@ -100,48 +154,355 @@ public:
             std::cout << std::endl;
         }
 
-        double time = static_cast<double>(
-            std::chrono::duration_cast<std::chrono::microseconds>(
-                m_benchmark_stop-m_benchmark_start).count());
+        // The printer may run after the next benchmark started, so the
+        // duration is taken on the measuring thread
+        double time = 0;
+        auto snapshot = dynamic_cast<const benchmark_snapshot*>(&info);
+        if (snapshot)
+            time = snapshot->duration();
 
         std::cout << std::fixed << console::textyellow << "[   TIME   ]"
                   << console::textdefault << " " << (time / 1000)
                   << " milliseconds" << std::endl;
 
+        print_scaling(results, shown);
+        print_outliers(results);
+        print_baseline(results, shown);
+        print_speedup(results, shown);
+        print_rate(results, shown);
+
+        auto topdown = topdown_columns();
+        bool topdown_printed = false;
+
         for (const auto& c_name : results.columns())
         {
-            if (c_name == "iterations")
+            if (shown.count(c_name))
                 continue;
-            if (c_name == "run_number")
+
+            // The configuration is printed above
+            if (info.has_configurations() &&
+                info.get_current_configuration().m_values.count(c_name))
+            {
                 continue;
-            if (print_column<double>(c_name,info.unit_text(),results))
+            }
+            // The top-down breakdown is printed next to the time
+            if (std::find(topdown.begin(), topdown.end(), c_name) !=
+                topdown.end())
+            {
                 continue;
-            if (print_column<float>(c_name,info.unit_text(),results))
+            }
+
+            std::string unit = info.column_unit(c_name);
+
+            // A constant column describes the benchmark or its setup, e.g.
+            // the calibrated overhead, rather than a measurement
+            if (results.is_constant(c_name))
+            {
+                print_constant(c_name, unit, results);
+                continue;
+            }
+
+            if (c_name == "time")
+            {
+                print_column<double>(c_name, unit, results);
+                topdown_printed = print_topdown(results);
+                continue;
+            }
+
+            if (print_column<double>(c_name, unit, results))
                 continue;
-            if (print_column<uint64_t>(c_name,info.unit_text(),results))
+            if (print_column<float>(c_name, unit, results))
                 continue;
-            if (print_column<int64_t>(c_name,info.unit_text(),results))
+            if (print_column<uint64_t>(c_name, unit, results))
                 continue;
-            if (print_column<int32_t>(c_name,info.unit_text(),results))
+            if (print_column<int64_t>(c_name, unit, results))
                 continue;
-            if (print_column<uint32_t>(c_name,info.unit_text(),results))
+            if (print_column<int32_t>(c_name, unit, results))
                 continue;
-            if (print_column<int16_t>(c_name,info.unit_text(),results))
+            if (print_column<uint32_t>(c_name, unit, results))
                 continue;
-            if (print_column<uint16_t>(c_name,info.unit_text(),results))
+            if (print_column<int16_t>(c_name, unit, results))
                 continue;
-            if (print_column<int8_t>(c_name,info.unit_text(),results))
+            if (print_column<uint16_t>(c_name, unit, results))
                 continue;
-            if (print_column<uint8_t>(c_name,info.unit_text(),results))
+            if (print_column<int8_t>(c_name, unit, results))
+                continue;
+            if (print_column<uint8_t>(c_name, unit, results))
                 continue;
         }
 
+        if (!topdown_printed)
+            print_topdown(results);
+
         std::cout << console::textgreen << "[----------] "
                   << console::textdefault << std::endl;
     }
 
 private:
 
+    /// Prints a warning if the measured time did not grow linearly with
+    /// the number of iterations
+    /// @param results The results of the benchmark
+    /// @param shown The columns printed so far, extended with the ones
+    ///        used here
+    void print_scaling(const tables::table& results,
+                       std::set<std::string>& shown)
+    {
+        if (!results.has_column("scaling") ||
+            !results.is_column<std::string>("scaling"))
+        {
+            return;
+        }
+
+        shown.insert("scaling");
+        shown.insert("linearity");
+
+        auto scaling = results.values_as<std::string>("scaling");
+        if (scaling.empty() || scaling.front() == "linear")
+            return;
+
+        std::cout << console::textred << "[ WARNING  ] "
+                  << console::textdefault;
+
+        if (scaling.front() == "optimized_away")
+        {
+            std::cout << "The time grows no faster than the RUN loop, the "
+                      << "benchmark was probably optimized away "
+                      << "(see gauge::do_not_optimize)";
+        }
+        else
+        {
+            std::cout << "The time is dominated by constant overhead or "
+                      << "the RUN loop";
+        }
+
+        if (results.is_column<double>("linearity"))
+        {
+            auto linearity = results.values_as<double>("linearity");
+            std::cout << std::setprecision(2) << " (linearity "
+                      << linearity.front() << ")" << std::setprecision(6);
+        }
+
+        std::cout << std::endl;
+    }
+
+    /// Prints the number of outlying runs and how much they move the
+    /// mean of the column by which they were found
+    void print_outliers(const tables::table& results)
+    {
+        if (!results.has_column("outlier") ||
+            !results.has_column(m_outlier_column) ||
+            !results.is_column<double>(m_outlier_column))
+        {
+            return;
+        }
+
+        auto outliers = outlier_rows(results);
+        auto tags = results.values_as<std::string>("outlier");
+        auto column_values = results.values(m_outlier_column);
+
+        std::map<std::string, uint32_t> counts;
+        std::vector<double> all;
+        std::vector<double> kept;
+
+        for (uint64_t row = 0; row < column_values.size(); ++row)
+        {
+            if (column_values[row].empty())
+                continue;
+
+            double value = boost::any_cast<double>(column_values[row]);
+            all.push_back(value);
+
+            if (outliers[row])
+                ++counts[tags[row]];
+            else
+                kept.push_back(value);
+        }
+
+        if (counts.empty() || kept.empty())
+            return;
+
+        std::cout << console::textyellow << "[ OUTLIERS ] "
+                  << console::textdefault << (all.size() - kept.size())
+                  << " of " << all.size() << " runs (";
+
+        bool first = true;
+        for (const auto& c : counts)
+        {
+            std::string name = c.first;
+            std::replace(name.begin(), name.end(), '_', ' ');
+
+            std::cout << (first ? "" : ", ") << c.second << " " << name;
+            first = false;
+        }
+
+        double with = mean(all.cbegin(), all.cend());
+        double without = mean(kept.cbegin(), kept.cend());
+
+        std::cout << "), the mean of " << m_outlier_column
+                  << (m_exclude_outliers ? " excludes them" : " includes them")
+                  << ", they move it by " << std::setprecision(2)
+                  << (with < without ? "" : "+")
+                  << (with - without) * 100.0 / without << " %"
+                  << std::setprecision(6) << std::endl;
+    }
+
+    /// Prints the speedup or slowdown compared to the baseline
+    /// @param results The results of the benchmark
+    /// @param shown The columns printed so far, extended with the ones
+    ///        used here
+    void print_baseline(const tables::table& results,
+                        std::set<std::string>& shown)
+    {
+        if (!results.has_column("baseline_verdict") ||
+            !results.is_column<std::string>("baseline_verdict"))
+        {
+            return;
+        }
+
+        shown.insert("baseline_verdict");
+        shown.insert("baseline_ratio");
+        shown.insert("baseline_p_value");
+
+        auto verdict =
+            results.values_as<std::string>("baseline_verdict").front();
+        double ratio = results.values_as<double>("baseline_ratio").front();
+        double p_value =
+            results.values_as<double>("baseline_p_value").front();
+
+        std::cout << (verdict == "regressed" ? console::textred :
+                      verdict == "improved" ? console::textgreen :
+                      console::textyellow)
+                  << "[ BASELINE ] " << console::textdefault
+                  << std::setprecision(3);
+
+        if (ratio > 1.0)
+            std::cout << ratio << "x slower";
+        else if (ratio > 0.0)
+            std::cout << 1.0 / ratio << "x faster";
+
+        std::cout << " than the baseline (p " << p_value << "), "
+                  << verdict << std::setprecision(6) << std::endl;
+    }
+
+    /// Prints the speedup of a step of a thread scaling sweep
+    /// @param results The results of the benchmark
+    /// @param shown The columns printed so far, extended with the ones
+    ///        used here
+    void print_speedup(const tables::table& results,
+                       std::set<std::string>& shown)
+    {
+        if (!results.has_column("speedup") ||
+            !results.is_column<double>("speedup") ||
+            !results.has_column("threads"))
+        {
+            return;
+        }
+
+        shown.insert("speedup");
+        shown.insert("efficiency");
+        shown.insert("serial_fraction");
+
+        double speedup = results.values_as<double>("speedup").front();
+        double efficiency = results.values_as<double>("efficiency").front();
+
+        uint32_t threads = results.values_as<uint32_t>("threads").front();
+
+        std::cout << console::textyellow << "[ SPEEDUP  ] "
+                  << console::textdefault << std::setprecision(2)
+                  << speedup << "x on " << threads
+                  << (threads == 1 ? " thread" : " threads")
+                  << ", efficiency " << efficiency * 100.0 << " %";
+
+        if (results.has_column("serial_fraction"))
+        {
+            std::cout << std::setprecision(3) << ", serial fraction "
+                      << results.values_as<double>("serial_fraction").front();
+        }
+
+        std::cout << std::setprecision(6) << std::endl;
+    }
+
+    /// Prints the aggregate rate of the copies of the rate mode and their
+    /// slowdown compared to the single copy
+    /// @param results The results of the benchmark
+    /// @param shown The columns printed so far, extended with the ones
+    ///        used here
+    void print_rate(const tables::table& results,
+                    std::set<std::string>& shown)
+    {
+        if (!results.has_column("rate") || !results.is_column<double>("rate"))
+            return;
+
+        shown.insert("rate");
+        shown.insert("rate_single");
+        shown.insert("degradation");
+        shown.insert("degradation_max");
+
+        double rate = results.values_as<double>("rate").front();
+
+        std::cout << console::textyellow << "[   RATE   ] "
+                  << console::textdefault << std::setprecision(2)
+                  << rate << " iterations/second";
+
+        if (results.has_column("rate_single"))
+        {
+            double single = results.values_as<double>("rate_single").front();
+            std::cout << ", " << rate / single << "x the single copy";
+        }
+
+        if (results.has_column("degradation"))
+        {
+            std::cout << ", slowdown per copy "
+                      << results.values_as<double>("degradation").front()
+                      << " % mean, "
+                      << results.values_as<double>("degradation_max").front()
+                      << " % worst";
+        }
+
+        std::cout << std::setprecision(6) << std::endl;
+    }
+
+    /// Prints the average top-down breakdown on a single line
+    /// @return true if the results contain a breakdown
+    bool print_topdown(const tables::table& results)
+    {
+        auto columns = topdown_columns();
+        const char* labels[] = { "frontend", "bad speculation", "backend",
+                                 "retiring" };
+
+        std::vector<double> averages;
+        for (const auto& c : columns)
+        {
+            if (!results.has_column(c) || !results.is_column<double>(c))
+                return false;
+
+            std::vector<double> values;
+            for (const auto& v : results.values(c))
+            {
+                if (!v.empty())
+                    values.push_back(boost::any_cast<double>(v));
+            }
+
+            if (values.empty())
+                return false;
+
+            averages.push_back(mean(values.cbegin(), values.cend()));
+        }
+
+        std::cout << console::textgreen << "[ TOPDOWN  ] "
+                  << console::textdefault << std::setprecision(1);
+
+        for (uint32_t i = 0; i < averages.size(); ++i)
+        {
+            std::cout << (i == 0 ? "" : " | ") << labels[i] << " "
+                      << averages[i] << " %";
+        }
+
+        std::cout << std::setprecision(6) << std::endl;
+        return true;
+    }
+
     template<class T>
     bool print_column(const std::string& column,
                       const std::string& unit,
@@ -150,14 +511,36 @@ private:
         if (!results.is_column<T>(column))
             return false;
 
-        if (results.empty_rows(column) > 0)
-            return false;
+        // Columns may have empty rows e.g. when the events of a perf
+        // counter benchmark are measured in turn, so we only use the
+        // rows with a value. Excluded outliers are left out as well.
+        auto excluded = excluded_rows(results);
+        auto column_values = results.values(column);
 
-        auto values = results.values_as<T>(column);
+        std::vector<T> values;
+        for (uint64_t row = 0; row < column_values.size(); ++row)
+        {
+            if (!column_values[row].empty() && !excluded[row])
+                values.push_back(boost::any_cast<T>(column_values[row]));
+        }
+
+        if (values.empty())
+            return false;
 
         statistics res =
             calculate_statistics(values.cbegin(), values.cend());
 
+        // Without a spread there is nothing to summarize
+        if (res.m_min == res.m_max)
+        {
+            std::cout << console::textgreen << "[   RESULT ] "
+                      << console::textdefault << column << " "
+                      << res.m_mean << " " << unit
+                      << (res.m_count > 1 ? " in every run" : "")
+                      << std::endl;
+            return true;
+        }
+
         std::cout << console::textgreen << "[   RESULT ] "
                   << console::textdefault;
 
@@ -170,6 +553,30 @@ private:
 
         print("Max:", unit, res.m_max, res.m_mean);
         print("Min:", unit, res.m_min, res.m_mean);
+        print("Median:", unit, res.m_median, res.m_mean);
+
+        if (res.m_count < 2)
+            return true;
+
+        std::cout << console::textgreen << "[          ] "
+                  << console::textdefault
+                  << std::setw(11) << "Std dev:" << " " << res.m_std_dev
+                  << " " << unit;
+
+        if (res.m_mean != 0)
+            std::cout << " (CV " << res.m_cv * 100.0 << " %, MAD ";
+        else
+            std::cout << " (MAD ";
+
+        std::cout << res.m_mad << " " << unit << ")" << std::endl;
+
+        std::cout << console::textgreen << "[          ] "
+                  << console::textdefault
+                  << std::setw(11) << "95% CI:" << " mean ["
+                  << res.m_mean_ci_low << ", " << res.m_mean_ci_high
+                  << "] / median ["
+                  << res.m_median_ci_low << ", " << res.m_median_ci_high
+                  << "] " << unit << std::endl;
 
         return true;
     }
@@ -184,10 +591,43 @@ private:
                   << " ("
                   << (value < mean ? console::textred : console::textgreen)
                   << (value < mean ? "" : "+") << value - mean
-                  << " " << unit << " / "
-                  << (value < mean ? "" : "+")
-                  << ((value-mean) * 100.0 / mean) << " %"
-                  << console::textdefault << ")" << std::endl;
+                  << " " << unit;
+
+        // The difference of a zero mean has no percentage
+        if (mean != 0)
+        {
+            std::cout << " / " << (value < mean ? "" : "+")
+                      << ((value-mean) * 100.0 / mean) << " %";
+        }
+
+        std::cout << console::textdefault << ")" << std::endl;
+    }
+
+    /// Prints a constant column on a single line. Only floating-point
+    /// values have a unit, the others are counts, indices or text.
+    /// @param column The name of the column
+    /// @param unit The unit of the column
+    /// @param results The results of the benchmark
+    void print_constant(const std::string& column, const std::string& unit,
+                        const tables::table& results)
+    {
+        auto values = results.values(column);
+        if (values.empty() || values.front().empty())
+            return;
+
+        std::cout << console::textyellow << "[ CONSTANT ] "
+                  << console::textdefault << column << " ";
+
+        tables::format f;
+        f.print(std::cout, values.front());
+
+        if (results.is_column<double>(column) ||
+            results.is_column<float>(column))
+        {
+            std::cout << " " << unit;
+        }
+
+        std::cout << std::endl;
     }
 
 private:
@@ -197,11 +637,5 @@ private:
 
     /// The stop time
     std::chrono::high_resolution_clock::time_point m_total_stop;
-
-    /// The start time
-    std::chrono::high_resolution_clock::time_point m_benchmark_start;
-
-    /// The stop time
-    std::chrono::high_resolution_clock::time_point m_benchmark_stop;
 };
 }
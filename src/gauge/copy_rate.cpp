@@ -0,0 +1,50 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "copy_rate.hpp"
+
+namespace gauge
+{
+bool calculate_copy_rate(const std::vector<double>& times, double single_time,
+                         copy_rate& result)
+{
+    result.m_rate = 0;
+    result.m_has_single = false;
+    result.m_rate_single = 0;
+    result.m_degradation = 0;
+    result.m_degradation_max = 0;
+
+    std::vector<double> slowdowns;
+    for (double time : times)
+    {
+        if (time <= 0)
+            continue;
+
+        result.m_rate += 1e6 / time;
+
+        if (single_time > 0)
+            slowdowns.push_back(time / single_time - 1.0);
+    }
+
+    if (result.m_rate <= 0)
+        return false;
+
+    if (!slowdowns.empty())
+    {
+        result.m_has_single = true;
+        result.m_rate_single = 1e6 / single_time;
+        result.m_degradation = std::accumulate(
+            slowdowns.begin(), slowdowns.end(), 0.0) / slowdowns.size() * 100.0;
+        result.m_degradation_max =
+            *std::max_element(slowdowns.begin(), slowdowns.end()) * 100.0;
+    }
+
+    return true;
+}
+}
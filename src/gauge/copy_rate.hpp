@@ -0,0 +1,45 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <vector>
+
+namespace gauge
+{
+/// The throughput of copies of a benchmark running at the same time,
+/// see the --copies option
+struct copy_rate
+{
+    /// The runs per second of all the copies together
+    double m_rate;
+
+    /// True if the time of the single copy is known, which the other
+    /// members below need
+    bool m_has_single;
+
+    /// The runs per second of the single copy running alone
+    double m_rate_single;
+
+    /// The mean slowdown of a copy relative to the single copy in percent
+    double m_degradation;
+
+    /// The largest slowdown of a copy relative to the single copy in
+    /// percent
+    double m_degradation_max;
+};
+
+/// Calculates the rate of copies from their times. The rate of a copy is
+/// the inverse of its time.
+/// @param times The median time of a run of every copy in microseconds,
+///        copies without a positive time are left out
+/// @param single_time The median time of a run of the single copy in
+///        microseconds, not positive if unknown
+/// @param result The calculated rate
+/// @return true if the rate could be calculated i.e. a copy has a
+///         positive time
+bool calculate_copy_rate(const std::vector<double>& times, double single_time,
+                         copy_rate& result);
+}
@@ -0,0 +1,250 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#include "cpu_topology.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// @return true if the CPU is the lowest allowed hardware thread of its
+///         physical core, which then represents the core
+bool is_first_sibling(uint32_t cpu, const std::vector<uint32_t>& allowed)
+{
+    for (uint32_t sibling : smt_siblings(cpu))
+    {
+        if (sibling < cpu &&
+            std::find(allowed.begin(), allowed.end(), sibling) !=
+            allowed.end())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @return the CPUs the calling thread is allowed to run on
+std::vector<uint32_t> read_allowed_cpus()
+{
+    std::vector<uint32_t> cpus;
+
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    {
+        for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &allowed))
+                cpus.push_back(cpu);
+        }
+    }
+#endif
+
+    if (cpus.empty())
+    {
+        uint32_t count = std::max(1U, std::thread::hardware_concurrency());
+        for (uint32_t cpu = 0; cpu < count; ++cpu)
+            cpus.push_back(cpu);
+    }
+
+    return cpus;
+}
+}
+
+std::vector<uint32_t> parse_cpu_list(const std::string& list)
+{
+    std::vector<uint32_t> cpus;
+
+    std::istringstream ranges(list);
+    std::string range;
+    while (std::getline(ranges, range, ','))
+    {
+        std::istringstream bounds(range);
+        uint32_t first = 0;
+        if (!(bounds >> first))
+            continue;
+
+        uint32_t last = first;
+        char dash = 0;
+        if (bounds >> dash && dash == '-')
+            bounds >> last;
+
+        for (uint32_t cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+
+    return cpus;
+}
+
+std::vector<uint32_t> allowed_cpus()
+{
+    static const std::vector<uint32_t> cpus = read_allowed_cpus();
+    return cpus;
+}
+
+std::vector<uint32_t> isolated_cpus()
+{
+    std::ifstream file("/sys/devices/system/cpu/isolated");
+
+    std::string list;
+    if (std::getline(file, list))
+        return parse_cpu_list(list);
+
+    return std::vector<uint32_t>();
+}
+
+std::vector<uint32_t> smt_siblings(uint32_t cpu)
+{
+    std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                       "/topology/thread_siblings_list");
+
+    std::string list;
+    std::vector<uint32_t> siblings;
+    if (std::getline(file, list))
+        siblings = parse_cpu_list(list);
+
+    if (std::find(siblings.begin(), siblings.end(), cpu) == siblings.end())
+        siblings = { cpu };
+
+    return siblings;
+}
+
+std::vector<uint32_t> cpu_order()
+{
+    auto allowed = allowed_cpus();
+
+    std::vector<uint32_t> primary;
+    std::vector<uint32_t> secondary;
+
+    for (uint32_t cpu : allowed)
+    {
+        if (is_first_sibling(cpu, allowed))
+            primary.push_back(cpu);
+        else
+            secondary.push_back(cpu);
+    }
+
+    primary.insert(primary.end(), secondary.begin(), secondary.end());
+    return primary;
+}
+
+uint32_t physical_core_count()
+{
+    auto allowed = allowed_cpus();
+
+    uint32_t cores = 0;
+    for (uint32_t cpu : allowed)
+    {
+        if (is_first_sibling(cpu, allowed))
+            ++cores;
+    }
+
+    return std::max(1U, cores);
+}
+
+uint32_t select_measurement_cpu()
+{
+    auto allowed = allowed_cpus();
+    auto isolated = isolated_cpus();
+
+    // Only the isolated CPUs the process may run on
+    std::vector<uint32_t> candidates;
+    for (uint32_t cpu : isolated)
+    {
+        if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end())
+            candidates.push_back(cpu);
+    }
+
+    for (uint32_t cpu : candidates)
+    {
+        bool whole_core = true;
+        for (uint32_t sibling : smt_siblings(cpu))
+        {
+            if (std::find(isolated.begin(), isolated.end(), sibling) ==
+                isolated.end())
+            {
+                whole_core = false;
+            }
+        }
+
+        if (whole_core)
+            return cpu;
+    }
+
+    if (!candidates.empty())
+        return candidates.front();
+
+    auto order = cpu_order();
+    return order[physical_core_count() - 1];
+}
+
+int pin_thread(uint32_t cpu)
+{
+#if defined(__linux__)
+    if (cpu >= CPU_SETSIZE)
+        return EINVAL;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void) cpu;
+    return ENOSYS;
+#endif
+}
+
+bool unpin_thread()
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (uint32_t cpu : allowed_cpus())
+    {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+
+    if (CPU_COUNT(&set) == 0)
+        return false;
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+std::vector<uint32_t> scaling_thread_counts(uint32_t cores, uint32_t cpus)
+{
+    assert(cores > 0);
+
+    std::vector<uint32_t> counts;
+    for (uint32_t n = 1; n < cores; n *= 2)
+        counts.push_back(n);
+
+    counts.push_back(cores);
+
+    if (cpus > cores)
+        counts.push_back(cpus);
+
+    return counts;
+}
+}
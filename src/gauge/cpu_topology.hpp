@@ -0,0 +1,66 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gauge
+{
+/// Parses a Linux CPU list such as "0-3,8,10-11"
+/// @param list The list
+/// @return the CPUs in the list
+std::vector<uint32_t> parse_cpu_list(const std::string& list);
+
+/// @return the CPUs the process is allowed to run on. The CPUs are read
+///         once, so pinning a thread later does not change them.
+std::vector<uint32_t> allowed_cpus();
+
+/// @return the CPUs isolated from the scheduler with the isolcpus kernel
+///         parameter, empty if none or unknown
+std::vector<uint32_t> isolated_cpus();
+
+/// @param cpu The CPU
+/// @return the hardware threads sharing the physical core of the CPU,
+///         including the CPU itself. Only the CPU itself if the topology
+///         is unknown.
+std::vector<uint32_t> smt_siblings(uint32_t cpu);
+
+/// @return the allowed CPUs in the order threads should be placed on
+///         them: the first hardware thread of every physical core, then
+///         the SMT siblings
+std::vector<uint32_t> cpu_order();
+
+/// @return the number of physical cores among the allowed CPUs
+uint32_t physical_core_count();
+
+/// Selects the allowed CPU to run the measurements on: an isolated CPU
+/// whose SMT siblings are isolated as well, or else any isolated CPU.
+/// Without isolated CPUs the first hardware thread of the last physical
+/// core is used, since the first CPUs usually serve most of the
+/// interrupts.
+/// @return the CPU
+uint32_t select_measurement_cpu();
+
+/// Pins the calling thread to a CPU. Only supported on Linux.
+/// @param cpu The CPU
+/// @return zero if the thread was pinned otherwise the error number
+int pin_thread(uint32_t cpu);
+
+/// Allows the calling thread to run on all the allowed CPUs, undoing the
+/// pinning it inherited from the thread which created it. Only supported
+/// on Linux.
+/// @return true if the affinity was changed
+bool unpin_thread();
+
+/// @param cores The number of physical cores
+/// @param cpus The number of hardware threads
+/// @return the thread counts of a scaling sweep: the powers of two below
+///         the number of cores, the number of cores and then the number
+///         of hardware threads if SMT adds any
+std::vector<uint32_t> scaling_thread_counts(uint32_t cores, uint32_t cpus);
+}
@@ -25,7 +25,7 @@ void csv_printer::print_to_stream(std::ostream& s)
     tables::table combined_results;
     for (auto i = m_tables.begin(); i != m_tables.end(); ++i)
     {
-        combined_results.merge(*i);
+        combined_results.merge(**i);
     }
 
     tables::csv_format format;
@@ -0,0 +1,139 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "csv_stream_printer.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// @return the field quoted if it contains separators or quotes
+std::string quote(const std::string& field)
+{
+    if (field.find_first_of(",\"\n\r") == std::string::npos)
+        return field;
+
+    std::string quoted = "\"";
+    for (char c : field)
+    {
+        if (c == '"')
+            quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+/// Reads a record, which spans several lines if a quoted field contains
+/// a newline. A quote inside a quoted field is doubled, so the record
+/// ends at a newline after an even number of quotes.
+/// @param in The stream
+/// @param record The record without its final newline
+/// @return true if a record was read
+bool read_record(std::istream& in, std::string& record)
+{
+    record.clear();
+
+    std::string line;
+    bool quoted = false;
+    while (std::getline(in, line))
+    {
+        record += line;
+
+        quoted ^= std::count(line.begin(), line.end(), '"') % 2 == 1;
+        if (!quoted)
+            return true;
+
+        record += "\n";
+    }
+
+    return !record.empty();
+}
+
+std::string header_line(const std::vector<std::string>& header)
+{
+    std::string line;
+    for (uint32_t i = 0; i < header.size(); ++i)
+        line += (i == 0 ? "" : ",") + quote(header[i]);
+    return line + "\n";
+}
+}
+
+csv_stream_printer::csv_stream_printer(const std::string& default_filename) :
+    stream_printer("csv_stream", default_filename)
+{ }
+
+void csv_stream_printer::start()
+{
+    stream_printer::start();
+    m_header.clear();
+}
+
+void csv_stream_printer::write_results(const tables::table& results)
+{
+    auto columns = results.columns();
+
+    uint32_t previous = static_cast<uint32_t>(m_header.size());
+    for (const auto& c : columns)
+    {
+        if (std::find(m_header.begin(), m_header.end(), c) == m_header.end())
+            m_header.push_back(c);
+    }
+
+    uint32_t added = static_cast<uint32_t>(m_header.size()) - previous;
+
+    if (previous == 0)
+    {
+        replace(header_line(m_header));
+    }
+    else if (added > 0)
+    {
+        // The earlier rows get empty fields for the new columns. The file
+        // is copied record by record, so only one record is in memory.
+        std::string padding(added, ',');
+        std::string header = header_line(m_header);
+
+        replace([&](std::ostream& out)
+        {
+            std::ifstream old(m_filename);
+            std::string record;
+
+            out << header;
+            read_record(old, record);
+
+            while (read_record(old, record))
+                out << record << padding << "\n";
+        });
+    }
+
+    std::vector<std::vector<boost::any>> values(m_header.size());
+    for (uint32_t i = 0; i < m_header.size(); ++i)
+    {
+        if (results.has_column(m_header[i]))
+            values[i] = results.values(m_header[i]);
+    }
+
+    std::ostringstream lines;
+    for (uint64_t row = 0; row < results.rows(); ++row)
+    {
+        for (uint32_t i = 0; i < m_header.size(); ++i)
+        {
+            if (i > 0)
+                lines << ",";
+
+            if (!values[i].empty())
+                lines << quote(to_text(values[i][row]));
+        }
+        lines << "\n";
+    }
+
+    append(lines.str());
+}
+}
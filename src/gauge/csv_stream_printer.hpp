@@ -0,0 +1,46 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "stream_printer.hpp"
+
+namespace gauge
+{
+/// A csv result printer writing the runs of every benchmark as soon as
+/// it completes. The header is the union of the columns of all the
+/// benchmarks written so far. When a benchmark brings new columns the
+/// file is rewritten once with the extended header and empty fields in
+/// the earlier rows, so the file is always a valid csv file.
+class csv_stream_printer : public stream_printer
+{
+public:
+
+    /// Create a new streaming csv printer
+    /// @param default_filename The default name of the outputted file
+    explicit csv_stream_printer(
+        const std::string& default_filename = "out_stream.csv");
+
+public:
+    // From stream_printer
+
+    /// @see stream_printer::start()
+    void start();
+
+protected:
+    // From stream_printer
+
+    /// @see stream_printer::write_results(const tables::table&)
+    void write_results(const tables::table& results);
+
+private:
+
+    /// The columns of the header
+    std::vector<std::string> m_header;
+};
+}
@@ -0,0 +1,17 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include "do_not_optimize.hpp"
+
+namespace gauge
+{
+namespace detail
+{
+void use_char_pointer(const volatile char* pointer)
+{
+    (void) pointer;
+}
+}
+}
@@ -0,0 +1,160 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <type_traits>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace gauge
+{
+/// Optimization barriers keeping the compiler from removing the code
+/// measured in a benchmark. Unlike storing the result in a volatile
+/// variable the barriers emit no instructions, they only tell the
+/// compiler that the value is used and possibly changed. Only
+/// clobber_memory() makes the compiler write back and reload the other
+/// values in memory, so do_not_optimize() of a pointer does not keep
+/// the writes through it unless it is followed by clobber_memory().
+///
+/// Example:
+///
+///    BENCHMARK(vector, accumulate, 10)
+///    {
+///        std::vector<uint32_t> values(1000, 1);
+///
+///        RUN
+///        {
+///            uint32_t sum = std::accumulate(values.begin(),
+///                                           values.end(), 0U);
+///            gauge::do_not_optimize(sum);
+///        }
+///    }
+///
+namespace detail
+{
+/// Takes the address of a value in a different translation unit, used
+/// where the compiler does not support inline assembly
+void use_char_pointer(const volatile char* pointer);
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+
+/// Forces the compiler to compute the value, it may be kept in a
+/// register. Values which do not fit a register are kept in memory.
+/// @param value The value which must be computed
+template<class T>
+inline typename std::enable_if<std::is_trivially_copyable<T>::value &&
+                               !std::is_floating_point<T>::value &&
+                               (sizeof(T) <= sizeof(T*))>::type
+do_not_optimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value));
+}
+
+/// Forces the compiler to compute the floating-point value, it may be
+/// kept in a vector register rather than moved to a general-purpose one.
+/// @param value The value which must be computed
+template<class T>
+inline typename std::enable_if<std::is_floating_point<T>::value &&
+                               (sizeof(T) <= sizeof(T*))>::type
+do_not_optimize(const T& value)
+{
+#if defined(__SSE2__)
+    asm volatile("" : : "x,m"(value));
+#elif defined(__aarch64__)
+    asm volatile("" : : "w,m"(value));
+#else
+    asm volatile("" : : "m"(value));
+#endif
+}
+
+/// @copydoc do_not_optimize(const T&)
+template<class T>
+inline typename std::enable_if<!std::is_trivially_copyable<T>::value ||
+                               (sizeof(T) > sizeof(T*))>::type
+do_not_optimize(const T& value)
+{
+    asm volatile("" : : "m"(value));
+}
+
+/// Forces the compiler to compute the value and to assume that it was
+/// changed afterwards, so a computation based on it cannot be hoisted
+/// out of the RUN loop.
+/// @param value The value which must be computed
+template<class T>
+inline typename std::enable_if<std::is_trivially_copyable<T>::value &&
+                               !std::is_floating_point<T>::value &&
+                               (sizeof(T) <= sizeof(T*))>::type
+do_not_optimize(T& value)
+{
+    // GCC does not handle alternatives for in-out operands reliably
+#if defined(__clang__)
+    asm volatile("" : "+r,m"(value));
+#else
+    asm volatile("" : "+r"(value));
+#endif
+}
+
+/// Forces the compiler to compute the floating-point value and to assume
+/// that it was changed afterwards. The value stays in a vector register,
+/// a general-purpose register would cost two moves in every iteration.
+/// @param value The value which must be computed
+template<class T>
+inline typename std::enable_if<std::is_floating_point<T>::value &&
+                               (sizeof(T) <= sizeof(T*))>::type
+do_not_optimize(T& value)
+{
+#if defined(__SSE2__)
+    asm volatile("" : "+x"(value));
+#elif defined(__aarch64__)
+    asm volatile("" : "+w"(value));
+#else
+    asm volatile("" : "+m"(value));
+#endif
+}
+
+/// @copydoc do_not_optimize(T&)
+template<class T>
+inline typename std::enable_if<!std::is_trivially_copyable<T>::value ||
+                               (sizeof(T) > sizeof(T*))>::type
+do_not_optimize(T& value)
+{
+    asm volatile("" : "+m"(value));
+}
+
+/// Forces the compiler to perform all pending writes to memory and to
+/// read memory again afterwards
+inline void clobber_memory()
+{
+    asm volatile("" : : : "memory");
+}
+
+#else
+
+/// Forces the compiler to compute the value
+/// @param value The value which must be computed
+template<class T>
+inline void do_not_optimize(const T& value)
+{
+    detail::use_char_pointer(&reinterpret_cast<const volatile char&>(value));
+#if defined(_MSC_VER)
+    _ReadWriteBarrier();
+#endif
+}
+
+/// Forces the compiler to perform all pending writes to memory and to
+/// read memory again afterwards
+inline void clobber_memory()
+{
+#if defined(_MSC_VER)
+    _ReadWriteBarrier();
+#endif
+}
+
+#endif
+}
@@ -0,0 +1,264 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+    #include <sys/resource.h>
+#endif
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/prctl.h>
+#endif
+
+#include <tables/table.hpp>
+
+#include "cpu_topology.hpp"
+#include "environment.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// Warns that a requested setting could not be applied
+void warn(const std::string& setting, int error)
+{
+    std::cerr << "Warning: could not " << setting << ": "
+              << std::strerror(error) << std::endl;
+}
+
+/// @return the CPUs the calling thread is allowed to run on, empty if
+///         not known
+std::vector<uint32_t> thread_cpus()
+{
+    std::vector<uint32_t> cpus;
+
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        return cpus;
+
+    for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &set))
+            cpus.push_back(cpu);
+    }
+#endif
+
+    return cpus;
+}
+}
+
+environment apply_environment(const environment_request& request,
+                              previous_environment& previous)
+{
+    environment effective;
+    previous = previous_environment();
+
+    if (request.m_cpu >= 0)
+    {
+        previous.m_cpus = thread_cpus();
+
+        int error = pin_thread(request.m_cpu);
+        if (error == 0)
+        {
+            effective.m_cpu = request.m_cpu;
+            previous.m_pinned = true;
+        }
+        else
+        {
+            warn("pin the thread to CPU " + std::to_string(request.m_cpu),
+                 error);
+        }
+    }
+
+#if defined(__linux__)
+    if (request.m_fifo_priority > 0)
+    {
+        int policy = 0;
+        sched_param param;
+        if (pthread_getschedparam(pthread_self(), &policy, &param) == 0)
+        {
+            previous.m_policy = policy;
+            previous.m_priority = param.sched_priority;
+        }
+
+        param.sched_priority = request.m_fifo_priority;
+
+        int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (error == 0)
+        {
+            effective.m_scheduler =
+                "fifo " + std::to_string(request.m_fifo_priority);
+            previous.m_scheduled = true;
+        }
+        else
+        {
+            warn("use SCHED_FIFO", error);
+        }
+    }
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+    // A real-time policy already takes precedence over the nice value
+    if (request.m_set_nice && effective.m_scheduler == "default")
+    {
+        // The nice value may be -1, so errno tells the errors apart
+        errno = 0;
+        int nice = getpriority(PRIO_PROCESS, 0);
+        bool known = errno == 0;
+
+        // On Linux this only changes the calling thread
+        if (setpriority(PRIO_PROCESS, 0, request.m_nice) == 0)
+        {
+            effective.m_scheduler = "nice " + std::to_string(request.m_nice);
+            previous.m_niced = known;
+            previous.m_nice = nice;
+        }
+        else
+        {
+            warn("set the nice value", errno);
+        }
+    }
+
+    if (request.m_lock_memory)
+    {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+        {
+            effective.m_memory_locked = true;
+            previous.m_memory_locked = true;
+        }
+        else
+        {
+            warn("lock the memory", errno);
+        }
+    }
+#endif
+
+#if defined(__linux__)
+    if (request.m_timer_slack > 0)
+    {
+        int slack = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+
+        if (prctl(PR_SET_TIMERSLACK, request.m_timer_slack, 0, 0, 0) != 0)
+        {
+            warn("set the timer slack", errno);
+        }
+        else if (slack > 0)
+        {
+            previous.m_slack_changed = true;
+            previous.m_timer_slack = static_cast<uint64_t>(slack);
+        }
+    }
+
+    // Real-time threads have no timer slack, recent kernels report zero
+    int slack = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+    if (slack >= 0)
+        effective.m_timer_slack = static_cast<uint64_t>(slack);
+#endif
+
+    return effective;
+}
+
+void restore_environment(const previous_environment& previous)
+{
+#if defined(__linux__)
+    if (previous.m_slack_changed)
+        prctl(PR_SET_TIMERSLACK, previous.m_timer_slack, 0, 0, 0);
+
+    if (previous.m_scheduled)
+    {
+        sched_param param;
+        param.sched_priority = previous.m_priority;
+        pthread_setschedparam(pthread_self(), previous.m_policy, &param);
+    }
+
+    // Without the previous affinity all the allowed CPUs are used
+    if (previous.m_pinned && previous.m_cpus.empty())
+    {
+        unpin_thread();
+    }
+    else if (previous.m_pinned)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (uint32_t cpu : previous.m_cpus)
+            CPU_SET(cpu, &set);
+
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+    // Raising the nice value back may need privileges, so it is only
+    // tried and an error is ignored like for the other settings
+    if (previous.m_niced)
+        setpriority(PRIO_PROCESS, 0, previous.m_nice);
+
+    if (previous.m_memory_locked)
+        munlockall();
+#else
+    (void) previous;
+#endif
+}
+
+bool reset_scheduling()
+{
+#if defined(__linux__)
+    sched_param param;
+    param.sched_priority = 0;
+    return pthread_setschedparam(pthread_self(), SCHED_OTHER, &param) == 0;
+#else
+    return false;
+#endif
+}
+
+void store_environment(tables::table& results,
+                       const environment_request& request,
+                       const environment& effective)
+{
+    if (request.m_cpu >= 0)
+        results.add_const_column("pinned_cpu", effective.m_cpu);
+
+    if (request.m_fifo_priority > 0 || request.m_set_nice)
+        results.add_const_column("scheduler", effective.m_scheduler);
+
+    if (request.m_lock_memory)
+    {
+        results.add_const_column(
+            "memory_locked",
+            std::string(effective.m_memory_locked ? "yes" : "no"));
+    }
+
+    if (request.m_timer_slack > 0)
+        results.add_const_column("timer_slack", effective.m_timer_slack);
+}
+
+void start_fresh_quantum()
+{
+    std::this_thread::yield();
+}
+
+void spin_cpu(double microseconds)
+{
+    if (microseconds <= 0)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    auto spin = std::chrono::duration<double, std::micro>(microseconds);
+
+    while (std::chrono::steady_clock::now() - start < spin)
+    { }
+}
+}
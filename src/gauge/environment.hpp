@@ -0,0 +1,135 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tables
+{
+class table;
+}
+
+namespace gauge
+{
+/// The execution environment requested for the measuring thread
+struct environment_request
+{
+    /// The CPU to pin the measuring thread to, negative to not pin it
+    int32_t m_cpu = -1;
+
+    /// The SCHED_FIFO priority, zero to keep the scheduling policy
+    int32_t m_fifo_priority = 0;
+
+    /// True if the nice value should be set
+    bool m_set_nice = false;
+
+    /// The nice value
+    int32_t m_nice = 0;
+
+    /// True if all memory of the process should be locked
+    bool m_lock_memory = false;
+
+    /// The timer slack in nanoseconds, zero to keep the timer slack
+    uint64_t m_timer_slack = 0;
+};
+
+/// The execution environment in effect, the requested settings which
+/// were not permitted are not in effect
+struct environment
+{
+    /// The CPU the measuring thread is pinned to, negative if not pinned
+    int32_t m_cpu = -1;
+
+    /// The scheduling of the measuring thread e.g. "fifo 10", "nice -5"
+    /// or "default"
+    std::string m_scheduler = "default";
+
+    /// True if all memory of the process is locked
+    bool m_memory_locked = false;
+
+    /// The timer slack of the measuring thread in nanoseconds, zero if
+    /// unknown or for a real-time thread
+    uint64_t m_timer_slack = 0;
+};
+
+/// The settings of the calling thread from before apply_environment()
+/// changed them, only the changed ones are restored
+struct previous_environment
+{
+    /// True if the affinity was changed
+    bool m_pinned = false;
+
+    /// The CPUs the thread was allowed to run on, empty if not known
+    std::vector<uint32_t> m_cpus;
+
+    /// True if the scheduling policy was changed
+    bool m_scheduled = false;
+
+    /// The scheduling policy
+    int32_t m_policy = 0;
+
+    /// The priority of the scheduling policy
+    int32_t m_priority = 0;
+
+    /// True if the nice value was changed
+    bool m_niced = false;
+
+    /// The nice value
+    int32_t m_nice = 0;
+
+    /// True if the memory was locked
+    bool m_memory_locked = false;
+
+    /// True if the timer slack was changed
+    bool m_slack_changed = false;
+
+    /// The timer slack in nanoseconds
+    uint64_t m_timer_slack = 0;
+};
+
+/// Applies the requested environment to the calling thread. Settings
+/// which are not permitted e.g. SCHED_FIFO without the CAP_SYS_NICE
+/// capability are skipped with a warning. Only supported on Linux.
+/// @param request The requested settings
+/// @param previous Set to the settings changed and their previous values
+/// @return the settings in effect
+environment apply_environment(const environment_request& request,
+                              previous_environment& previous);
+
+/// Restores the settings of the calling thread changed by
+/// apply_environment() and unlocks the memory if it was locked
+/// @param previous The settings from before apply_environment()
+void restore_environment(const previous_environment& previous);
+
+/// Restores the default scheduling policy SCHED_OTHER of the calling
+/// thread, undoing a real-time policy it inherited from the thread which
+/// created it. Only supported on Linux.
+/// @return true if the policy was changed
+bool reset_scheduling();
+
+/// Stores the settings in effect of the requested environment in
+/// constant columns: "pinned_cpu", "scheduler", "memory_locked" and
+/// "timer_slack"
+/// @param results The result table
+/// @param request The requested settings, only the requested ones are
+///        stored
+/// @param effective The settings in effect
+void store_environment(tables::table& results,
+                       const environment_request& request,
+                       const environment& effective);
+
+/// Gives up the CPU, so a run starts at the beginning of a scheduler
+/// time slice. A yield which switches away is counted as an involuntary
+/// context switch on Linux, so this must happen before the noise
+/// snapshot of the run.
+void start_fresh_quantum();
+
+/// Keeps the CPU busy, so the run starts on a CPU which is not idle
+/// @param microseconds The time to spin
+void spin_cpu(double microseconds);
+}
@@ -38,17 +38,15 @@ file_printer::file_printer(const std::string& name,
 void file_printer::benchmark_result(const benchmark& info,
                                     const tables::table& results)
 {
-    tables::table output = results;
-    if (info.has_configurations())
-    {
-        const auto& c = info.get_current_configuration();
-        for (const auto& v : c)
-        {
-            output.add_const_column(v.first, v.second);
-        }
-    }
+    shared_benchmark_result(
+        info, std::make_shared<const tables::table>(results));
+}
 
-    m_tables.insert(m_tables.end(), output);
+void file_printer::shared_benchmark_result(
+    const benchmark& /*info*/,
+    const std::shared_ptr<const tables::table>& results)
+{
+    m_tables.push_back(with_summary(results));
 }
 
 void file_printer::end()
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <ostream>
@@ -34,6 +35,11 @@ public:
     virtual void benchmark_result(const benchmark& info,
                                   const tables::table& results);
 
+    /// @see printer::shared_benchmark_result()
+    virtual void shared_benchmark_result(
+        const benchmark& info,
+        const std::shared_ptr<const tables::table>& results);
+
     /// @see printer::end()
     virtual void end();
 
@@ -54,8 +60,10 @@ protected:
     /// Store the name of the filename option
     std::string m_filename_option;
 
-    /// The output tables
-    std::vector<tables::table> m_tables;
+protected:
+
+    /// The output tables, shared with the other printers
+    std::vector<std::shared_ptr<const tables::table>> m_tables;
 
 };
 
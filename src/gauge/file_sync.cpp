@@ -0,0 +1,39 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "file_sync.hpp"
+
+namespace gauge
+{
+void sync_file(const std::string& filename)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    ::fsync(fd);
+    ::close(fd);
+#else
+    (void) filename;
+#endif
+}
+
+void sync_parent_directory(const std::string& filename)
+{
+    auto slash = filename.rfind('/');
+    if (slash == std::string::npos)
+        sync_file(".");
+    else
+        sync_file(slash == 0 ? "/" : filename.substr(0, slash));
+}
+}
@@ -0,0 +1,20 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <string>
+
+namespace gauge
+{
+/// Flushes a file to the disk. Only supported on Unix.
+/// @param filename The name of the file
+void sync_file(const std::string& filename);
+
+/// Flushes the directory entries of the directory holding a file to the
+/// disk, e.g. after creating or renaming the file. Only supported on Unix.
+/// @param filename The name of the file
+void sync_parent_directory(const std::string& filename);
+}
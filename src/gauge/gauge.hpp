@@ -5,12 +5,17 @@
 
 #pragma once
 
+#include "do_not_optimize.hpp"
 #include "iteration_controller.hpp"
 #include "runner.hpp"
 #include "benchmark.hpp"
 #include "time_benchmark.hpp"
+#include "perf_counter_benchmark.hpp"
+#include "thread_benchmark.hpp"
+#include "untimed.hpp"
 
 #include <string>
+#include <type_traits>
 
 // This file contains a number of macros used to setup the the benchmarks
 // using gauge.
@@ -148,6 +153,25 @@
          virtual void test_body();                                            \
     };
 
+// This macro expands into a class that defines the
+// thread_benchmark::thread_body() function and the default number of
+// threads running it. Like BENCHMARK_TEST_BODY_CLASS_ it "opens" the
+// function definition.
+#define BENCHMARK_THREADS_BODY_CLASS_(testcase, benchmark, __threads)         \
+                                                                              \
+    class BENCHMARK_TEST_BODY_NAME_(testcase, benchmark) :                    \
+        public BENCHMARK_NAME_(testcase, benchmark)                           \
+    {                                                                         \
+    public:                                                                   \
+                                                                              \
+        virtual uint32_t default_threads() const                              \
+        {                                                                     \
+            assert(__threads > 0);                                            \
+            return __threads;                                                 \
+        }                                                                     \
+                                                                              \
+        virtual void thread_body();                                           \
+    };
 
 // Define a registration benchmark class that registers the benchmark class
 // not defining the benchmark::test_body() function.
@@ -206,6 +230,21 @@
     REG_BENCHMARK_TEST_BODY_CLASS_(testcase, benchmark)                       \
     void BENCHMARK_TEST_BODY_NAME_(testcase, benchmark)::test_body()
 
+/// Macro creating a benchmark running its body on a number of threads at
+/// the same time using a fixture class derived from
+/// gauge::thread_benchmark
+#define BENCHMARK_THREADS_F(fixture, testcase, benchmark, runs, threads)      \
+    BENCHMARK_CLASS_(testcase, benchmark, fixture, runs)                      \
+    BENCHMARK_THREADS_BODY_CLASS_(testcase, benchmark, threads)               \
+    REG_BENCHMARK_TEST_BODY_CLASS_(testcase, benchmark)                       \
+    void BENCHMARK_TEST_BODY_NAME_(testcase, benchmark)::thread_body()
+
+/// Macro creating a benchmark running its body on a number of threads at
+/// the same time, see gauge::thread_benchmark
+#define BENCHMARK_THREADS(testcase, benchmark, runs, threads)                 \
+    BENCHMARK_THREADS_F(gauge::thread_benchmark, testcase, benchmark, runs,   \
+                        threads)
+
 // Macro for starting the measurement, using the iteration controller.
 //
 // RUN
@@ -217,6 +256,54 @@
     for (gauge::iteration_controller __controller;                            \
          __controller.is_done() == false; __controller.next())
 
+// Macros for excluding work inside the RUN loop from the measurement.
+// The time spent paused is stored in the time_paused column. Outside the
+// scope of RUN use the gauge::untimed guard instead.
+//
+// RUN
+// {
+//     PAUSE_TIMING;
+//     reset_input();
+//     RESUME_TIMING;
+//
+//     test_something();
+// }
+//
+#define PAUSE_TIMING __controller.pause()
+#define RESUME_TIMING __controller.resume()
+
+// Unrolls the loop following the macro, the count must be an integer
+// literal
+#define GAUGE_STRINGIFY_(text) #text
+
+#if defined(__clang__)
+    #define GAUGE_UNROLL_(count)                                              \
+        _Pragma(GAUGE_STRINGIFY_(unroll count))
+#elif defined(__GNUC__) && (__GNUC__ >= 8)
+    #define GAUGE_UNROLL_(count)                                              \
+        _Pragma(GAUGE_STRINGIFY_(GCC unroll count))
+#else
+    #define GAUGE_UNROLL_(count)
+#endif
+
+// Macro for starting the measurement running the body in batches, which
+// makes the cost of the loop negligible for very small bodies. The body
+// is unrolled batch times inside every iteration of the measurement loop.
+// The batch size must be an integer literal. The results are reported per
+// run of the body.
+//
+// RUN_BATCH(8)
+// {
+//     test_something();
+// }
+//
+#define RUN_BATCH(batch)                                                      \
+    for (gauge::iteration_controller __controller(                            \
+             std::integral_constant<uint32_t, (batch)>::value);               \
+         __controller.is_done() == false; __controller.next())                \
+        GAUGE_UNROLL_(batch)                                                  \
+        for (uint32_t __batch = 0; __batch < (batch); ++__batch)
+
 // Define the name of the class used to register options
 #define BENCHMARK_OPTION_CLASS_NAME_(option_name)                             \
     opt_ ## option_name ## _Optionclass_
@@ -0,0 +1,708 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <ctime>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#elif defined(_WIN32)
+    #include <direct.h>
+    #include <fcntl.h>
+    #include <io.h>
+    #include <sys/stat.h>
+#endif
+
+#include "file_sync.hpp"
+#include "history.hpp"
+#include "statistics.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// Identifies a segment file
+const char segment_magic[4] = { 'G', 'H', 'S', '1' };
+
+void write_u32(std::ostream& out, uint32_t value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void write_u64(std::ostream& out, uint64_t value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void write_string(std::ostream& out, const std::string& value)
+{
+    write_u32(out, static_cast<uint32_t>(value.size()));
+    out.write(value.data(), value.size());
+}
+
+uint32_t read_u32(std::istream& in)
+{
+    uint32_t value = 0;
+    in.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+}
+
+uint64_t read_u64(std::istream& in)
+{
+    uint64_t value = 0;
+    in.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+}
+
+/// @param in The segment being read
+/// @param size The size of the segment
+/// @param bytes The number of bytes about to be read
+/// @return true if the bytes are left in the segment otherwise the
+///         stream is failed, so a corrupt length is never allocated
+bool fits(std::istream& in, uint64_t size, uint64_t bytes)
+{
+    auto position = in.tellg();
+    if (!in || position < 0 || static_cast<uint64_t>(position) > size ||
+        bytes > size - static_cast<uint64_t>(position))
+    {
+        in.setstate(std::ios::failbit);
+        return false;
+    }
+
+    return true;
+}
+
+std::string read_string(std::istream& in, uint64_t size)
+{
+    uint32_t length = read_u32(in);
+    if (!fits(in, size, length))
+        return std::string();
+
+    std::string value(length, '\0');
+    in.read(&value[0], value.size());
+    return value;
+}
+
+/// Escapes a field of the index, which is tab-separated with one line
+/// per entry, so a tab or newline in e.g. a configuration value cannot
+/// break up the line
+std::string escape_field(const std::string& field)
+{
+    std::string escaped;
+    for (char c : field)
+    {
+        switch (c)
+        {
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '\t':
+            escaped += "\\t";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        case '\r':
+            escaped += "\\r";
+            break;
+        default:
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+/// @return the field of the index as it was before escape_field()
+std::string unescape_field(const std::string& field)
+{
+    std::string value;
+    for (std::size_t i = 0; i < field.size(); ++i)
+    {
+        if (field[i] != '\\' || i + 1 == field.size())
+        {
+            value += field[i];
+            continue;
+        }
+
+        char c = field[++i];
+        value += c == 't' ? '\t' : c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+    }
+    return value;
+}
+
+/// @return true if the name matches the pattern in which "*" matches
+///         any sequence of characters
+bool matches(const std::string& pattern, const std::string& name)
+{
+    std::size_t p = 0;
+    std::size_t n = 0;
+    std::size_t star = std::string::npos;
+    std::size_t mark = 0;
+
+    while (n < name.size())
+    {
+        if (p < pattern.size() && pattern[p] == name[n])
+        {
+            ++p;
+            ++n;
+        }
+        else if (p < pattern.size() && pattern[p] == '*')
+        {
+            star = p++;
+            mark = n;
+        }
+        else if (star != std::string::npos)
+        {
+            p = star + 1;
+            n = ++mark;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while (p < pattern.size() && pattern[p] == '*')
+        ++p;
+
+    return p == pattern.size();
+}
+
+void make_directory(const std::string& directory)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    ::mkdir(directory.c_str(), 0755);
+#elif defined(_WIN32)
+    ::_mkdir(directory.c_str());
+#endif
+}
+
+/// Creates a file that must not exist yet
+/// @param path The path of the file
+/// @return true if the file was created, false if it exists or cannot be
+///         created
+bool create_exclusive(const std::string& path)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+        return false;
+
+    ::close(fd);
+    return true;
+#elif defined(_WIN32)
+    int fd = ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL,
+                     _S_IREAD | _S_IWRITE);
+    if (fd < 0)
+        return false;
+
+    ::_close(fd);
+    return true;
+#else
+    std::ifstream existing(path);
+    if (existing)
+        return false;
+
+    return static_cast<bool>(std::ofstream(path));
+#endif
+}
+
+/// @return true if the value is a non-empty decimal number which fits in
+///         64 bits
+bool is_number(const std::string& value)
+{
+    if (value.empty() || value.size() > 19)
+        return false;
+
+    return std::all_of(value.begin(), value.end(),
+                       [](char c) { return c >= '0' && c <= '9'; });
+}
+
+/// Removes an incomplete last line from a file, which a crash while the
+/// file was extended may have left. Ending the line instead would make
+/// the cut off line look complete.
+/// @param path The path of the file
+void remove_incomplete_line(const std::string& path)
+{
+    std::streamoff size = 0;
+    std::streamoff end = 0;
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            return;
+
+        size = file.tellg();
+        end = size;
+        while (end > 0)
+        {
+            file.seekg(end - 1);
+            if (file.get() == '\n')
+                break;
+            --end;
+        }
+    }
+
+    if (end == size)
+        return;
+
+#if defined(__unix__) || defined(__APPLE__)
+    bool removed = ::truncate(path.c_str(), end) == 0;
+#elif defined(_WIN32)
+    int fd = ::_open(path.c_str(), _O_WRONLY);
+    bool removed = fd >= 0 && ::_chsize_s(fd, end) == 0;
+    if (fd >= 0)
+        ::_close(fd);
+#else
+    std::string content(static_cast<std::size_t>(end), '\0');
+    {
+        std::ifstream file(path, std::ios::binary);
+        file.read(&content[0], end);
+    }
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), end);
+    file.close();
+    bool removed = static_cast<bool>(file);
+#endif
+
+    if (!removed)
+    {
+        throw std::runtime_error("Error cannot repair history index '" +
+                                 path + "'");
+    }
+}
+
+/// @return the 64 bit FNV-1a hash of a string, which unlike std::hash is
+///         the same for every build of the program
+uint64_t fnv1a(const std::string& value)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : value)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/// The entries of one benchmark configuration on one machine
+typedef std::map<std::string, std::vector<const history_entry*>> series_map;
+
+/// Groups the entries with a column into series
+series_map group_series(const std::vector<history_entry>& entries,
+                        const std::string& column)
+{
+    series_map series;
+    for (const auto& e : entries)
+    {
+        auto it = e.m_columns.find(column);
+        if (it == e.m_columns.end() || it->second.empty())
+            continue;
+
+        std::string name = e.m_benchmark;
+        if (!e.m_config.empty())
+            name += " (" + e.m_config + ")";
+        name += " on " + e.m_machine;
+
+        series[name].push_back(&e);
+    }
+    return series;
+}
+
+/// @return the median of a column of an entry
+double entry_median(const history_entry& e, const std::string& column)
+{
+    std::vector<double> values = e.m_columns.at(column);
+    return median(values);
+}
+
+/// @return the time as a date and time in UTC
+std::string format_time(uint64_t timestamp)
+{
+    std::time_t t = static_cast<std::time_t>(timestamp);
+    char text[32] = { 0 };
+    std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", std::gmtime(&t));
+    return text;
+}
+
+/// Splits the series [begin, end) recursively at the largest shift
+void segment(const std::vector<double>& series, uint32_t begin, uint32_t end,
+             double sigma, double min_change,
+             std::vector<uint32_t>& splits)
+{
+    if (end - begin < 2)
+        return;
+
+    // Prefix sums give the means of both sides of every split
+    std::vector<double> sums(end - begin + 1, 0.0);
+    for (uint32_t i = begin; i < end; ++i)
+        sums[i - begin + 1] = sums[i - begin] + series[i];
+
+    double best_score = 0;
+    uint32_t best_split = 0;
+
+    for (uint32_t k = begin + 1; k < end; ++k)
+    {
+        double left = k - begin;
+        double right = end - k;
+        double before = sums[k - begin] / left;
+        double after = (sums[end - begin] - sums[k - begin]) / right;
+
+        double shift = std::fabs(after - before);
+        if (before == 0 || shift / std::fabs(before) < min_change)
+            continue;
+
+        double error = sigma * std::sqrt(1.0 / left + 1.0 / right);
+        double score = error > 0 ? shift / error :
+                       std::numeric_limits<double>::max();
+
+        if (score > best_score)
+        {
+            best_score = score;
+            best_split = k;
+        }
+    }
+
+    if (best_split == 0 || best_score < 4.0)
+        return;
+
+    splits.push_back(best_split);
+    segment(series, begin, best_split, sigma, min_change, splits);
+    segment(series, best_split, end, sigma, min_change, splits);
+}
+}
+
+history_store::history_store(const std::string& directory) :
+    m_directory(directory)
+{ }
+
+void history_store::append(const std::vector<history_entry>& entries)
+{
+    if (entries.empty())
+        return;
+
+    make_directory(m_directory);
+
+    // The segment is named by the time of the append and a hash of the
+    // thread. It is created exclusively, so should another append pick
+    // the same name, e.g. in another process, a suffix is added instead
+    // of overwriting its segment
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    std::ostringstream base;
+    base << "segment-"
+         << std::chrono::duration_cast<std::chrono::microseconds>(now)
+            .count()
+         << "-" << std::hash<std::thread::id>()(std::this_thread::get_id())
+         % 100000;
+
+    std::string segment_name;
+    std::string segment_path;
+    for (uint32_t attempt = 0; attempt < 100; ++attempt)
+    {
+        segment_name = base.str() +
+            (attempt == 0 ? "" : "-" + std::to_string(attempt)) + ".bin";
+        segment_path = m_directory + "/" + segment_name;
+
+        if (create_exclusive(segment_path))
+            break;
+
+        segment_path.clear();
+    }
+
+    if (segment_path.empty())
+    {
+        throw std::runtime_error("Error cannot create a history segment "
+                                 "in '" + m_directory + "'");
+    }
+
+    std::ofstream segment_file(segment_path, std::ios::binary);
+    if (!segment_file)
+    {
+        throw std::runtime_error("Error cannot write history segment '" +
+                                 segment_path + "'");
+    }
+
+    segment_file.write(segment_magic, sizeof(segment_magic));
+
+    std::ostringstream index;
+    for (const auto& e : entries)
+    {
+        uint64_t offset = static_cast<uint64_t>(segment_file.tellp());
+
+        write_string(segment_file, e.m_benchmark);
+        write_string(segment_file, e.m_config);
+        write_string(segment_file, e.m_machine);
+        write_string(segment_file, e.m_revision);
+        write_u64(segment_file, e.m_timestamp);
+        write_u32(segment_file, static_cast<uint32_t>(e.m_columns.size()));
+
+        for (const auto& c : e.m_columns)
+        {
+            write_string(segment_file, c.first);
+            write_u32(segment_file, static_cast<uint32_t>(c.second.size()));
+            segment_file.write(
+                reinterpret_cast<const char*>(c.second.data()),
+                c.second.size() * sizeof(double));
+        }
+
+        index << escape_field(e.m_benchmark) << '\t'
+              << escape_field(e.m_config) << '\t'
+              << escape_field(e.m_machine) << '\t'
+              << escape_field(e.m_revision) << '\t'
+              << e.m_timestamp << '\t' << segment_name << '\t'
+              << offset << '\n';
+    }
+
+    segment_file.close();
+    if (!segment_file)
+    {
+        throw std::runtime_error("Error cannot write history segment '" +
+                                 segment_path + "'");
+    }
+
+    // The index is only extended once the segment and its directory
+    // entry are on the disk, so the index never refers to a segment which
+    // is lost in a crash
+    sync_file(segment_path);
+    sync_parent_directory(segment_path);
+
+    // A crash may have left an incomplete last line, which is removed so
+    // it is neither merged with our first line nor read as complete
+    std::string index_path = m_directory + "/index";
+    remove_incomplete_line(index_path);
+
+    std::ofstream index_file(index_path, std::ios::out | std::ios::app);
+    index_file << index.str();
+    index_file.close();
+
+    if (!index_file)
+    {
+        throw std::runtime_error("Error cannot write history index '" +
+                                 index_path + "'");
+    }
+
+    sync_file(index_path);
+}
+
+std::vector<history_entry> history_store::query(
+    const std::string& filter) const
+{
+    std::vector<history_entry> entries;
+
+    std::ifstream index(m_directory + "/index");
+    if (!index)
+        return entries;
+
+    std::string segment_name;
+    std::ifstream segment_file;
+    uint64_t segment_size = 0;
+
+    std::string line;
+    while (std::getline(index, line))
+    {
+        std::istringstream fields(line);
+        std::string benchmark;
+        std::string config;
+        std::string machine;
+        std::string revision;
+        std::string timestamp;
+        std::string segment;
+        std::string offset;
+
+        std::getline(fields, benchmark, '\t');
+        std::getline(fields, config, '\t');
+        std::getline(fields, machine, '\t');
+        std::getline(fields, revision, '\t');
+        std::getline(fields, timestamp, '\t');
+        std::getline(fields, segment, '\t');
+        std::getline(fields, offset, '\t');
+
+        // A line without a newline was cut short by a crash while the
+        // index was extended, e.g. in the middle of the offset
+        bool complete = !index.eof();
+
+        if (!fields || !complete || !is_number(timestamp) ||
+            !is_number(offset) || segment.empty())
+        {
+            continue;
+        }
+
+        if (!matches(filter, unescape_field(benchmark)))
+            continue;
+
+        if (segment != segment_name)
+        {
+            segment_file.close();
+            segment_file.clear();
+            segment_file.open(m_directory + "/" + segment,
+                              std::ios::binary | std::ios::ate);
+            segment_size = static_cast<uint64_t>(
+                std::max<std::streamoff>(segment_file.tellg(), 0));
+            segment_name = segment;
+        }
+
+        segment_file.seekg(std::stoull(offset));
+
+        history_entry e;
+        e.m_benchmark = read_string(segment_file, segment_size);
+        e.m_config = read_string(segment_file, segment_size);
+        e.m_machine = read_string(segment_file, segment_size);
+        e.m_revision = read_string(segment_file, segment_size);
+        e.m_timestamp = read_u64(segment_file);
+
+        uint32_t columns = read_u32(segment_file);
+        for (uint32_t i = 0; i < columns && segment_file; ++i)
+        {
+            std::string column = read_string(segment_file, segment_size);
+
+            uint32_t count = read_u32(segment_file);
+            if (!fits(segment_file, segment_size, count * sizeof(double)))
+                break;
+
+            std::vector<double> values(count);
+            segment_file.read(reinterpret_cast<char*>(values.data()),
+                              values.size() * sizeof(double));
+            e.m_columns[column] = values;
+        }
+
+        if (!segment_file)
+        {
+            throw std::runtime_error("Error corrupt history segment '" +
+                                     segment + "'");
+        }
+
+        entries.push_back(e);
+    }
+
+    return entries;
+}
+
+std::string machine_fingerprint()
+{
+    std::string description;
+
+#if defined(__unix__) || defined(__APPLE__)
+    char host[256] = { 0 };
+    if (::gethostname(host, sizeof(host) - 1) == 0)
+        description += host;
+#endif
+
+#if defined(__linux__)
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line))
+    {
+        if (line.compare(0, 10, "model name") == 0)
+        {
+            description += "/" + line.substr(line.find(':') + 1);
+            break;
+        }
+    }
+#endif
+
+    description += "/" + std::to_string(std::thread::hardware_concurrency());
+
+    std::ostringstream fingerprint;
+    fingerprint << std::hex << fnv1a(description);
+    return fingerprint.str();
+}
+
+std::vector<change_point> detect_change_points(
+    const std::vector<double>& series, double min_change)
+{
+    std::vector<change_point> points;
+
+    if (series.size() < 2)
+        return points;
+
+    // The noise is estimated from the differences of successive values,
+    // which a few shifts do not disturb
+    std::vector<double> differences;
+    for (uint32_t i = 1; i < series.size(); ++i)
+        differences.push_back(std::fabs(series[i] - series[i - 1]));
+
+    double sigma = 1.4826 * median(differences) / std::sqrt(2.0);
+
+    std::vector<uint32_t> splits;
+    segment(series, 0, static_cast<uint32_t>(series.size()), sigma,
+            min_change, splits);
+    std::sort(splits.begin(), splits.end());
+
+    for (uint32_t i = 0; i < splits.size(); ++i)
+    {
+        uint32_t begin = i == 0 ? 0 : splits[i - 1];
+        uint32_t end = i + 1 < splits.size() ? splits[i + 1] :
+                       static_cast<uint32_t>(series.size());
+
+        change_point p;
+        p.m_index = splits[i];
+        p.m_before = mean(series.begin() + begin, series.begin() + splits[i]);
+        p.m_after = mean(series.begin() + splits[i], series.begin() + end);
+        points.push_back(p);
+    }
+
+    return points;
+}
+
+void print_history(std::ostream& out,
+                   const std::vector<history_entry>& entries,
+                   const std::string& column)
+{
+    for (const auto& s : group_series(entries, column))
+    {
+        out << s.first << std::endl;
+
+        for (const auto* e : s.second)
+        {
+            out << "  " << format_time(e->m_timestamp) << "  "
+                << (e->m_revision.empty() ? "-" : e->m_revision) << "  "
+                << column << " median " << entry_median(*e, column)
+                << " (" << e->m_columns.at(column).size() << " runs)"
+                << std::endl;
+        }
+    }
+}
+
+void print_trend(std::ostream& out,
+                 const std::vector<history_entry>& entries,
+                 const std::string& column, double min_change)
+{
+    for (const auto& s : group_series(entries, column))
+    {
+        std::vector<double> medians;
+        for (const auto* e : s.second)
+            medians.push_back(entry_median(*e, column));
+
+        auto points = detect_change_points(medians, min_change);
+
+        out << s.first << ": " << s.second.size() << " entries, "
+            << points.size() << " change points" << std::endl;
+
+        for (const auto& p : points)
+        {
+            const auto* e = s.second[p.m_index];
+            out << "  " << (e->m_revision.empty() ? "-" : e->m_revision)
+                << " (" << format_time(e->m_timestamp) << "): " << column
+                << " " << p.m_before << " -> " << p.m_after << " ("
+                << (p.m_after > p.m_before ? "+" : "")
+                << (p.m_after - p.m_before) * 100.0 / p.m_before << " %)"
+                << std::endl;
+        }
+    }
+}
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace gauge
+{
+/// The results of one benchmark configuration from one invocation of
+/// the benchmark program
+struct history_entry
+{
+    /// The name of the benchmark e.g. "coder.decode"
+    std::string m_benchmark;
+
+    /// The configuration e.g. "symbols=16,type=x", empty if none
+    std::string m_config;
+
+    /// The fingerprint of the machine the results come from
+    std::string m_machine;
+
+    /// The user supplied revision e.g. a commit id
+    std::string m_revision;
+
+    /// The time of the invocation in seconds since the epoch
+    uint64_t m_timestamp;
+
+    /// The values of the numeric result columns of every run
+    std::map<std::string, std::vector<double>> m_columns;
+};
+
+/// An append-only store of benchmark results in a directory.
+///
+/// Every append writes one segment file in which the results are stored
+/// column by column, and adds a line per entry to the index file. The
+/// index is used to find the entries of a query, so only the matching
+/// entries are read from the segments. The segment is on the disk before
+/// the index refers to it, and an index line cut short by a crash is
+/// skipped.
+class history_store
+{
+public:
+
+    /// @param directory The directory of the store, it is created when
+    ///        the first results are appended
+    explicit history_store(const std::string& directory);
+
+    /// Appends the results of an invocation
+    /// @param entries The results
+    void append(const std::vector<history_entry>& entries);
+
+    /// Finds the entries of the benchmarks matching a filter
+    /// @param filter A filter like --gauge_filter e.g. "coder.*"
+    /// @return the matching entries in the order they were appended
+    std::vector<history_entry> query(const std::string& filter) const;
+
+private:
+
+    /// The directory of the store
+    std::string m_directory;
+};
+
+/// @return a short fingerprint of the machine from its host name, CPU
+///         model and number of CPUs
+std::string machine_fingerprint();
+
+/// A shift in a series of measurements
+struct change_point
+{
+    /// The index of the first value after the shift
+    uint32_t m_index;
+
+    /// The mean of the values from the previous change point
+    double m_before;
+
+    /// The mean of the values until the next change point
+    double m_after;
+};
+
+/// Finds the shifts in a series using binary segmentation. A split is
+/// accepted if the means on both sides differ by more than four times
+/// their standard error, estimated robustly from the differences of
+/// successive values, and by more than the relative change.
+/// @param series The series e.g. the medians of a benchmark per revision
+/// @param min_change The smallest relative shift reported e.g. 0.05
+/// @return the change points in the order of the series
+std::vector<change_point> detect_change_points(
+    const std::vector<double>& series, double min_change);
+
+/// Prints the entries grouped by benchmark, configuration and machine
+/// with the median of a column per entry
+/// @param out The stream to print to
+/// @param entries The entries e.g. from history_store::query()
+/// @param column The column to summarize
+void print_history(std::ostream& out,
+                   const std::vector<history_entry>& entries,
+                   const std::string& column);
+
+/// Prints the change points in the medians of a column of every series
+/// of entries with the revisions at which they occurred
+/// @param out The stream to print to
+/// @param entries The entries e.g. from history_store::query()
+/// @param column The column to analyze
+/// @param min_change The smallest relative shift reported
+void print_trend(std::ostream& out,
+                 const std::vector<history_entry>& entries,
+                 const std::string& column, double min_change);
+}
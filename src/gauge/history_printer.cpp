@@ -0,0 +1,109 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <ctime>
+#include <sstream>
+#include <string>
+
+#include <tables/format.hpp>
+#include <tables/table.hpp>
+
+#include "history_printer.hpp"
+#include "statistics.hpp"
+
+namespace gauge
+{
+history_printer::history_printer() :
+    printer("history", false),
+    m_timestamp(0)
+{ }
+
+void history_printer::set_options(const po::variables_map& options)
+{
+    printer::set_options(options);
+
+    m_directory = options["history_dir"].as<std::string>();
+    m_revision = options["revision"].as<std::string>();
+    m_machine = machine_fingerprint();
+    m_timestamp = static_cast<uint64_t>(std::time(0));
+}
+
+void history_printer::benchmark_result(const benchmark& info,
+                                       const tables::table& results)
+{
+    history_entry e;
+    e.m_benchmark = info.testcase_name() + "." + info.benchmark_name();
+    e.m_machine = m_machine;
+    e.m_revision = m_revision;
+    e.m_timestamp = m_timestamp;
+
+    if (info.has_configurations())
+    {
+        tables::format f;
+        std::ostringstream config;
+        for (const auto& v : info.get_current_configuration())
+        {
+            if (!config.str().empty())
+                config << ",";
+            config << v.first << "=";
+            f.print(config, v.second);
+        }
+        e.m_config = config.str();
+    }
+
+    // The steps of a thread scaling sweep and the rate mode are
+    // separate series
+    if (results.has_column("threads"))
+    {
+        e.m_config += (e.m_config.empty() ? "" : ",") +
+                      std::string("threads=") +
+                      std::to_string(info.threads());
+    }
+
+    if (results.has_column("copies") && results.is_column<uint32_t>("copies"))
+    {
+        e.m_config += (e.m_config.empty() ? "" : ",") +
+                      std::string("copies=") +
+                      std::to_string(
+                          results.values_as<uint32_t>("copies").front());
+    }
+
+    // Only the per-run numeric columns are kept, rows without a value
+    // and the excluded outliers are skipped
+    auto excluded = excluded_rows(results);
+
+    for (const auto& column : results.columns())
+    {
+        if (results.is_constant(column))
+            continue;
+
+        auto column_values = results.values(column);
+
+        std::vector<double> values;
+        bool numeric = true;
+        for (uint64_t row = 0; row < column_values.size() && numeric; ++row)
+        {
+            const auto& v = column_values[row];
+            if (v.empty() || excluded[row])
+                continue;
+
+            double value;
+            numeric = numeric_value(v, value);
+            values.push_back(value);
+        }
+
+        if (numeric && !values.empty())
+            e.m_columns[column] = values;
+    }
+
+    m_entries.push_back(e);
+}
+
+void history_printer::end()
+{
+    history_store(m_directory).append(m_entries);
+    m_entries.clear();
+}
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <tables/table.hpp>
+
+#include "benchmark.hpp"
+#include "history.hpp"
+#include "printer.hpp"
+
+namespace gauge
+{
+/// Appends the numeric results of every run to the history store in
+/// --history_dir, keyed by the benchmark, its configuration, the machine
+/// and the --revision. The stored results can be searched with
+/// --history_query and --history_trend.
+class history_printer : public printer
+{
+public:
+
+    /// Create a new history printer
+    history_printer();
+
+public:
+    // From printer
+
+    /// @see printer::set_options(po::variables_map&)
+    void set_options(const po::variables_map& options);
+
+    /// @see printer::benchmark_result(const benchmark&, const table&)
+    void benchmark_result(const benchmark& info,
+                          const tables::table& results);
+
+    /// @see printer::end()
+    void end();
+
+private:
+
+    /// The directory of the history store
+    std::string m_directory;
+
+    /// The revision of the results
+    std::string m_revision;
+
+    /// The machine fingerprint
+    std::string m_machine;
+
+    /// The time the benchmark program was started
+    uint64_t m_timestamp;
+
+    /// The results to append
+    std::vector<history_entry> m_entries;
+};
+}
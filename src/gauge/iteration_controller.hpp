@@ -21,26 +21,54 @@ public:
 
 public:
 
-    /// Create a new iteration controller for the benchmark
-    /// with a specific id.
+    /// Create a new iteration controller for the runner's current
+    /// benchmark.
     /// Starts the benchmark
-    /// @param benchmark_id the id of the benchmark
-    iteration_controller() :
+    /// @param batch_size the number of times the body is run in every
+    ///        iteration, see the RUN_BATCH macro
+    explicit iteration_controller(uint32_t batch_size = 1) :
+        iteration_controller(*gauge::runner::instance().current_benchmark(),
+                             batch_size)
+    { }
+
+    /// Create a new iteration controller for a specific benchmark.
+    /// Starts the benchmark
+    /// @param benchmark the benchmark to control
+    /// @param batch_size the number of times the body is run in every
+    ///        iteration
+    explicit iteration_controller(const benchmark_ptr& benchmark,
+                                  uint32_t batch_size = 1) :
+        iteration_controller(*benchmark, batch_size)
+    {
+        assert(benchmark);
+    }
+
+    /// Create a new iteration controller for a specific benchmark. The
+    /// benchmark must outlive the controller.
+    /// Starts the benchmark
+    /// @param benchmark the benchmark to control
+    /// @param batch_size the number of times the body is run in every
+    ///        iteration
+    iteration_controller(benchmark& benchmark, uint32_t batch_size) :
         m_iteration_count(0),
         m_total_iterations(0),
-        m_benchmark(gauge::runner::instance().current_benchmark())
+        m_sample_interval(0),
+        m_next_sample(1),
+        m_benchmark(benchmark)
     {
-        assert(m_benchmark);
+        assert(batch_size > 0);
 
-        m_total_iterations = m_benchmark->iteration_count();
+        m_benchmark.set_batch_size(batch_size);
+        m_total_iterations = m_benchmark.iteration_count();
+        m_sample_interval = m_benchmark.sample_interval();
 
-        m_benchmark->start();
+        m_benchmark.start();
     }
 
     /// Stops the benchmark
     ~iteration_controller()
     {
-        m_benchmark->stop();
+        m_benchmark.stop();
     }
 
     /// @return true if the required number of iterations has been
@@ -50,10 +78,39 @@ public:
         return !(m_iteration_count < m_total_iterations);
     }
 
+    /// Pauses the measurement until resume() is called
+    void pause()
+    {
+        m_benchmark.pause();
+    }
+
+    /// Resumes the measurement
+    void resume()
+    {
+        m_benchmark.resume();
+    }
+
     /// Increments the iteration counter
     void next()
     {
         ++m_iteration_count;
+
+        if (m_sample_interval == 0)
+            return;
+
+        // The first iteration is always sampled, it starts with the
+        // benchmark. Every following sampled iteration needs an extra
+        // mark at its start, unless it directly follows the previous
+        // sampled iteration.
+        if (m_iteration_count == m_next_sample)
+        {
+            m_benchmark.sample_iteration(true);
+            m_next_sample += m_sample_interval;
+        }
+        else if (m_iteration_count + 1 == m_next_sample)
+        {
+            m_benchmark.sample_iteration(false);
+        }
     }
 
 private:
@@ -64,7 +121,14 @@ private:
     /// The total number of iterations to perform
     uint64_t m_total_iterations;
 
-    /// Pointer to the benchmark
-    benchmark_ptr m_benchmark;
+    /// The iteration sampling interval, zero if disabled
+    uint64_t m_sample_interval;
+
+    /// The iteration count at the end of the next sampled iteration
+    uint64_t m_next_sample;
+
+    /// The benchmark, we do not hold a reference count since the runner
+    /// or the caller keeps the benchmark alive
+    benchmark& m_benchmark;
 };
 }
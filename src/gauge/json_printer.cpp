@@ -23,6 +23,6 @@ json_printer::json_printer(const std::string& default_filename) :
 void json_printer::print_to_stream(std::ostream& s)
 {
     tables::json_format format;
-    format.print(s, m_tables);
+    print_list(s, format, m_tables);
 }
 }
@@ -0,0 +1,99 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "jsonl_printer.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// Writes a string as a quoted and escaped JSON string
+void write_string(std::ostream& out, const std::string& text)
+{
+    out << '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        }
+        else
+        {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+/// @return false for a floating point value which JSON cannot represent,
+///         i.e. NaN or an infinity of either sign
+bool is_finite(const boost::any& value)
+{
+    if (value.type() == typeid(double))
+        return std::isfinite(boost::any_cast<double>(value));
+    if (value.type() == typeid(float))
+        return std::isfinite(boost::any_cast<float>(value));
+
+    return true;
+}
+}
+
+jsonl_printer::jsonl_printer(const std::string& default_filename) :
+    stream_printer("jsonl", default_filename)
+{ }
+
+void jsonl_printer::write_results(const tables::table& results)
+{
+    auto columns = results.columns();
+
+    std::vector<std::vector<boost::any>> values;
+    for (const auto& c : columns)
+        values.push_back(results.values(c));
+
+    std::ostringstream lines;
+    for (uint64_t row = 0; row < results.rows(); ++row)
+    {
+        lines << "{";
+
+        bool first = true;
+        for (uint32_t i = 0; i < columns.size(); ++i)
+        {
+            const auto& value = values[i][row];
+            if (value.empty())
+                continue;
+
+            lines << (first ? "" : ", ");
+            first = false;
+
+            write_string(lines, columns[i]);
+            lines << ": ";
+
+            if (!is_finite(value))
+                lines << "null";
+            else if (is_text(value))
+                write_string(lines, to_text(value));
+            else
+                lines << to_text(value);
+        }
+
+        lines << "}\n";
+    }
+
+    append(lines.str());
+}
+}
@@ -0,0 +1,31 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <string>
+
+#include "stream_printer.hpp"
+
+namespace gauge
+{
+/// A JSON Lines result printer. Every run is written as a JSON object
+/// on its own line as soon as its benchmark completes, with the
+/// constant columns repeated in every object.
+class jsonl_printer : public stream_printer
+{
+public:
+
+    /// Create a new JSON Lines printer
+    /// @param default_filename The default name of the outputted file
+    explicit jsonl_printer(const std::string& default_filename = "out.jsonl");
+
+protected:
+    // From stream_printer
+
+    /// @see stream_printer::write_results(const tables::table&)
+    void write_results(const tables::table& results);
+};
+}
@@ -0,0 +1,178 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace gauge
+{
+/// Log-linear histogram of latencies in the style of HdrHistogram.
+///
+/// Values below 2^precision_bits are counted exactly, larger values
+/// are counted in buckets which keep the precision_bits most
+/// significant bits of the value. The relative error of a reported
+/// value is therefore below 2^-(precision_bits - 1) over the whole
+/// 64 bit range. All buckets are allocated up front, so adding a
+/// value never allocates.
+class latency_histogram
+{
+public:
+
+    /// The number of significant bits kept for each value
+    static const uint32_t precision_bits = 8;
+
+public:
+
+    /// Creates an empty histogram
+    latency_histogram() :
+        m_counts(bucket_count(), 0)
+    {
+        reset();
+    }
+
+    /// Removes all values from the histogram
+    void reset()
+    {
+        std::fill(m_counts.begin(), m_counts.end(), 0);
+        m_count = 0;
+        m_min = std::numeric_limits<uint64_t>::max();
+        m_max = 0;
+    }
+
+    /// Adds a value to the histogram
+    /// @param value The value e.g. a latency in clock ticks
+    void add(uint64_t value)
+    {
+        ++m_counts[bucket(value)];
+        ++m_count;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    /// @return the number of values added
+    uint64_t count() const
+    {
+        return m_count;
+    }
+
+    /// @return the smallest value added
+    uint64_t min() const
+    {
+        assert(m_count > 0);
+        return m_min;
+    }
+
+    /// @return the largest value added
+    uint64_t max() const
+    {
+        assert(m_count > 0);
+        return m_max;
+    }
+
+    /// @param quantile The quantile in the range [0, 1] e.g. 0.99
+    /// @return the value below or at which the given fraction of the
+    ///         added values lie. The value is the upper bound of its
+    ///         bucket, but never larger than the largest value added.
+    uint64_t quantile(double quantile) const
+    {
+        assert(m_count > 0);
+        assert(quantile >= 0.0 && quantile <= 1.0);
+
+        uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * m_count));
+        rank = std::max<uint64_t>(rank, 1);
+
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < m_counts.size(); ++i)
+        {
+            seen += m_counts[i];
+            if (seen >= rank)
+                return std::min(upper_bound(i), m_max);
+        }
+
+        return m_max;
+    }
+
+public:
+
+    /// @return the number of buckets needed to cover 64 bit values
+    static uint32_t bucket_count()
+    {
+        return sub_count + (64 - precision_bits) * half_count;
+    }
+
+    /// @param value A value
+    /// @return the index of the bucket counting the value
+    static uint32_t bucket(uint64_t value)
+    {
+        if (value < sub_count)
+            return static_cast<uint32_t>(value);
+
+        uint32_t shift = most_significant_bit(value) - precision_bits + 1;
+        uint64_t mantissa = value >> shift;
+
+        assert(mantissa >= half_count && mantissa < sub_count);
+        return static_cast<uint32_t>(
+            sub_count + (shift - 1) * half_count + (mantissa - half_count));
+    }
+
+    /// @param index The index of a bucket
+    /// @return the largest value counted in the bucket
+    static uint64_t upper_bound(uint32_t index)
+    {
+        assert(index < bucket_count());
+
+        if (index < sub_count)
+            return index;
+
+        uint32_t offset = index - sub_count;
+        uint32_t shift = offset / half_count + 1;
+        uint64_t mantissa = offset % half_count + half_count;
+
+        return (mantissa << shift) + ((uint64_t(1) << shift) - 1);
+    }
+
+private:
+
+    /// @return the position of the most significant set bit
+    static uint32_t most_significant_bit(uint64_t value)
+    {
+        assert(value > 0);
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(value);
+#else
+        uint32_t bit = 0;
+        while (value >>= 1)
+            ++bit;
+        return bit;
+#endif
+    }
+
+private:
+
+    /// The number of exactly counted values
+    static const uint64_t sub_count = uint64_t(1) << precision_bits;
+
+    /// The number of buckets for each power of two above sub_count
+    static const uint64_t half_count = sub_count / 2;
+
+    /// The counts of the buckets
+    std::vector<uint64_t> m_counts;
+
+    /// The number of values added
+    uint64_t m_count;
+
+    /// The smallest value added
+    uint64_t m_min;
+
+    /// The largest value added
+    uint64_t m_max;
+};
+}
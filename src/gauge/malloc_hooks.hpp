@@ -0,0 +1,129 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+// Interposes malloc() and free() to count the heap allocations for the
+// --track_allocations option. Unlike gauge/allocation_hooks.hpp this also
+// counts the allocations of C code and, since the default operator new
+// uses malloc(), of C++ code. Include this file in exactly one
+// translation unit of the benchmark program and do not combine it with
+// gauge/allocation_hooks.hpp. The aligned allocation functions are
+// interposed too so that every counted free() has a counted allocation.
+// Only glibc is supported.
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+
+#if !defined(__GLIBC__)
+    #error "The malloc hooks require glibc, use gauge/allocation_hooks.hpp"
+#endif
+
+#include <malloc.h>
+
+#include "allocation_tracker.hpp"
+
+// The definitions must match the noexcept declarations of the C library
+extern "C"
+{
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* pointer, std::size_t size);
+void __libc_free(void* pointer);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void* __libc_valloc(std::size_t size);
+void* __libc_pvalloc(std::size_t size);
+
+void* malloc(std::size_t size) noexcept
+{
+    gauge::allocation_tracker::record_allocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) noexcept
+{
+    gauge::allocation_tracker::record_allocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, std::size_t size) noexcept
+{
+    // A reallocation is counted as a new allocation and a free
+    gauge::allocation_tracker::record_allocation(size);
+    if (pointer != nullptr)
+        gauge::allocation_tracker::record_free();
+
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        gauge::allocation_tracker::record_free();
+
+    __libc_free(pointer);
+}
+
+void* memalign(std::size_t alignment, std::size_t size) noexcept
+{
+    gauge::allocation_tracker::record_allocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+{
+    gauge::allocation_tracker::record_allocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** pointer, std::size_t alignment,
+                   std::size_t size) noexcept
+{
+    // The alignment must be a power of two multiple of sizeof(void*)
+    if (alignment % sizeof(void*) != 0 ||
+        (alignment & (alignment - 1)) != 0 || alignment == 0)
+    {
+        return EINVAL;
+    }
+
+    // Recorded before the call like the other allocation functions
+    gauge::allocation_tracker::record_allocation(size);
+
+    void* result = __libc_memalign(alignment, size);
+    if (result == nullptr)
+        return ENOMEM;
+
+    *pointer = result;
+    return 0;
+}
+
+void* valloc(std::size_t size) noexcept
+{
+    gauge::allocation_tracker::record_allocation(size);
+    return __libc_valloc(size);
+}
+
+void* pvalloc(std::size_t size) noexcept
+{
+    gauge::allocation_tracker::record_allocation(size);
+    return __libc_pvalloc(size);
+}
+}
+
+namespace gauge
+{
+namespace
+{
+/// Tells the tracker that the hooks are compiled into the program
+struct malloc_hooks_installer
+{
+    malloc_hooks_installer()
+    {
+        allocation_tracker::set_available();
+    }
+} malloc_hooks_installer_instance;
+}
+}
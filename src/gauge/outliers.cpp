@@ -0,0 +1,209 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/any.hpp>
+
+#include <tables/table.hpp>
+
+#include "outliers.hpp"
+#include "statistics.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// @return the class of a value given the fences around the center
+std::string classify(double value, double center, double mild,
+                     double severe)
+{
+    if (value < center - severe)
+        return "low_severe";
+    if (value < center - mild)
+        return "low_mild";
+    if (value > center + severe)
+        return "high_severe";
+    if (value > center + mild)
+        return "high_mild";
+
+    return "";
+}
+}
+
+outlier_method parse_outlier_method(const std::string& name)
+{
+    if (name == "tukey")
+        return outlier_method::tukey;
+    if (name == "mad")
+        return outlier_method::mad;
+
+    throw std::runtime_error("Error unknown outlier_method '" + name +
+                             "' (use tukey or mad)");
+}
+
+outlier_policy parse_outlier_policy(const std::string& name)
+{
+    if (name == "keep")
+        return outlier_policy::keep;
+    if (name == "flag")
+        return outlier_policy::flag;
+    if (name == "exclude")
+        return outlier_policy::exclude;
+
+    throw std::runtime_error("Error unknown outliers policy '" + name +
+                             "' (use keep, flag or exclude)");
+}
+
+std::vector<std::string> classify_outliers(const std::vector<double>& values,
+                                           outlier_method method)
+{
+    std::vector<std::string> classes(values.size());
+
+    if (values.size() < 4)
+        return classes;
+
+    std::vector<double> copy = values;
+
+    if (method == outlier_method::tukey)
+    {
+        double q1 = quantile(copy, 0.25);
+        double q3 = quantile(copy, 0.75);
+        double iqr = q3 - q1;
+
+        if (iqr <= 0)
+            return classes;
+
+        // The fences are measured from the quartiles, so we classify
+        // relative to the lower quartile for low values and the upper
+        // for high values
+        for (uint32_t i = 0; i < values.size(); ++i)
+        {
+            double center = values[i] < q1 ? q1 : q3;
+            if (values[i] >= q1 && values[i] <= q3)
+                continue;
+
+            classes[i] = classify(values[i], center, 1.5 * iqr, 3.0 * iqr);
+        }
+    }
+    else
+    {
+        double center = median(copy);
+
+        for (auto& v : copy)
+            v = std::fabs(v - center);
+
+        // Scaled to estimate the standard deviation of normal data
+        double sigma = 1.4826 * median(copy);
+
+        if (sigma <= 0)
+            return classes;
+
+        for (uint32_t i = 0; i < values.size(); ++i)
+            classes[i] = classify(values[i], center, 3 * sigma, 5 * sigma);
+    }
+
+    return classes;
+}
+
+bool classify_rows(const tables::table& results, const std::string& column,
+                   outlier_method method, std::vector<std::string>& classes)
+{
+    if (!results.has_column(column) || results.rows() == 0)
+        return false;
+
+    auto column_values = results.values(column);
+
+    std::vector<double> values;
+    std::vector<uint64_t> rows;
+    for (uint64_t row = 0; row < column_values.size(); ++row)
+    {
+        double value;
+        if (column_values[row].empty())
+            continue;
+        if (!numeric_value(column_values[row], value))
+            return false;
+
+        values.push_back(value);
+        rows.push_back(row);
+    }
+
+    auto value_classes = classify_outliers(values, method);
+
+    classes.assign(results.rows(), std::string());
+    for (uint32_t i = 0; i < rows.size(); ++i)
+        classes[rows[i]] = value_classes[i];
+
+    return true;
+}
+
+bool tag_outliers(tables::table& results, const std::string& column,
+                  outlier_method method)
+{
+    std::vector<std::string> tags;
+    if (!classify_rows(results, column, method, tags))
+        return false;
+
+    // The table is filled row by row, so the tags are added by copying
+    // the results into a new table with the extra column
+    tables::table tagged;
+    tagged.reserve(results.rows());
+
+    std::vector<std::string> columns;
+    std::vector<std::vector<boost::any>> values_by_column;
+
+    for (const auto& c : results.columns())
+    {
+        if (results.is_constant(c))
+        {
+            tagged.add_const_column(c, results.values(c).front());
+            continue;
+        }
+
+        tagged.add_column(c);
+        columns.push_back(c);
+        values_by_column.push_back(results.values(c));
+    }
+
+    tagged.add_column("outlier");
+
+    for (uint64_t row = 0; row < results.rows(); ++row)
+    {
+        tagged.add_row();
+
+        for (uint32_t i = 0; i < columns.size(); ++i)
+        {
+            if (!values_by_column[i][row].empty())
+                tagged.set_value(columns[i], values_by_column[i][row]);
+        }
+
+        tagged.set_value("outlier", tags[row]);
+    }
+
+    results = tagged;
+    return true;
+}
+
+std::vector<bool> outlier_rows(const tables::table& results)
+{
+    std::vector<bool> rows(results.rows(), false);
+
+    if (!results.has_column("outlier") ||
+        !results.is_column<std::string>("outlier"))
+    {
+        return rows;
+    }
+
+    auto tags = results.values_as<std::string>("outlier");
+    for (uint64_t row = 0; row < tags.size(); ++row)
+        rows[row] = !tags[row].empty();
+
+    return rows;
+}
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace tables
+{
+class table;
+}
+
+namespace gauge
+{
+/// How outlying runs are found
+enum class outlier_method
+{
+    /// Tukey's fences: values beyond 1.5 times the interquartile range
+    /// outside the quartiles are mild, beyond 3 times severe outliers
+    tukey,
+
+    /// Values more than 3 standard deviations estimated from the median
+    /// absolute deviation away from the median are mild, more than 5
+    /// severe outliers
+    mad
+};
+
+/// What is done with outlying runs
+enum class outlier_policy
+{
+    /// The runs are not classified
+    keep,
+
+    /// The runs are tagged in the "outlier" column and reported
+    flag,
+
+    /// The runs are tagged and left out of the summary statistics
+    exclude
+};
+
+/// @param name The name of a method i.e. "tukey" or "mad"
+/// @return the outlier method
+outlier_method parse_outlier_method(const std::string& name);
+
+/// @param name The name of a policy i.e. "keep", "flag" or "exclude"
+/// @return the outlier policy
+outlier_policy parse_outlier_policy(const std::string& name);
+
+/// Classifies the values as outliers. Fewer than four values or values
+/// without spread are never outliers.
+/// @param values The values
+/// @param method The method used to find the outliers
+/// @return the class of every value, empty if the value is not an
+///         outlier otherwise "low_mild", "low_severe", "high_mild" or
+///         "high_severe"
+std::vector<std::string> classify_outliers(const std::vector<double>& values,
+                                           outlier_method method);
+
+/// Classifies the runs by a result column. Rows without a value in the
+/// column are not classified.
+/// @param results The table containing the results
+/// @param column The column to classify the runs by
+/// @param method The method used to find the outliers
+/// @param classes The class of every row, see classify_outliers()
+/// @return false if the results have no numeric column of that name
+bool classify_rows(const tables::table& results, const std::string& column,
+                   outlier_method method, std::vector<std::string>& classes);
+
+/// Classifies the runs by a result column and stores the classes in the
+/// "outlier" column. Rows without a value in the column are not
+/// classified.
+/// @param results The table containing the results
+/// @param column The column to classify the runs by
+/// @param method The method used to find the outliers
+/// @return false if the results have no numeric column of that name
+bool tag_outliers(tables::table& results, const std::string& column,
+                  outlier_method method);
+
+/// @param results The table containing the results
+/// @return true for every row tagged as an outlier
+std::vector<bool> outlier_rows(const tables::table& results);
+}
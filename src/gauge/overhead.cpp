@@ -0,0 +1,157 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "do_not_optimize.hpp"
+#include "iteration_controller.hpp"
+#include "overhead.hpp"
+#include "statistics.hpp"
+#include "time_benchmark.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// Time benchmark with a fixed number of iterations used to measure
+/// the overhead of an empty loop
+class empty_benchmark : public time_benchmark
+{
+public:
+
+    empty_benchmark(const std::string& clock_name,
+                    uint64_t sample_interval) :
+        m_clock_name(clock_name),
+        m_sample_interval(sample_interval),
+        m_iterations(0)
+    { }
+
+    void set_iterations(uint64_t iterations)
+    {
+        m_iterations = iterations;
+    }
+
+    uint64_t iteration_count() const
+    {
+        return m_iterations;
+    }
+
+    std::string clock_name() const
+    {
+        return m_clock_name;
+    }
+
+    uint64_t sample_interval() const
+    {
+        return m_sample_interval;
+    }
+
+    bool overhead_correction() const
+    {
+        // We are the ones measuring the overhead
+        return false;
+    }
+
+    bool check_scaling() const
+    {
+        // The check needs the overhead we are measuring
+        return false;
+    }
+
+    uint32_t runs() const
+    {
+        return 1;
+    }
+
+    void test_body()
+    { }
+
+private:
+
+    std::string m_clock_name;
+    uint64_t m_sample_interval;
+    uint64_t m_iterations;
+};
+
+/// Runs the empty loop a number of times
+/// @param pause True if the timing should be paused and resumed in
+///        every iteration
+/// @param durations Set to the duration in nanoseconds of every run
+/// @return the median duration in nanoseconds
+double run_empty(const std::shared_ptr<empty_benchmark>& benchmark,
+                 uint64_t iterations, bool pause,
+                 std::vector<double>& durations)
+{
+    const uint32_t repeats = 21;
+
+    benchmark->set_iterations(iterations);
+
+    durations.clear();
+    for (uint32_t i = 0; i < repeats; ++i)
+    {
+        if (pause)
+        {
+            iteration_controller controller(benchmark);
+            for (; !controller.is_done(); controller.next())
+            {
+                controller.pause();
+                controller.resume();
+            }
+        }
+        else
+        {
+            iteration_controller controller(benchmark);
+            for (; !controller.is_done(); controller.next())
+                clobber_memory();
+        }
+
+        durations.push_back(benchmark->elapsed_nanoseconds());
+    }
+
+    std::vector<double> sorted = durations;
+    std::nth_element(sorted.begin(), sorted.begin() + repeats / 2,
+                     sorted.end());
+    return sorted[repeats / 2];
+}
+}
+
+const overhead& calibrate_overhead(const std::string& clock_name,
+                                   uint64_t sample_interval)
+{
+    static std::map<std::pair<std::string, uint64_t>, overhead> cache;
+
+    auto key = std::make_pair(clock_name, sample_interval);
+    auto it = cache.find(key);
+    if (it != cache.end())
+        return it->second;
+
+    auto benchmark =
+        std::make_shared<empty_benchmark>(clock_name, sample_interval);
+    benchmark->init();
+
+    const uint64_t iterations = 100000;
+
+    // Without iterations we only measure the fixed cost, the cost of
+    // an iteration is the slope between the two points
+    std::vector<double> durations;
+    double empty = run_empty(benchmark, 0, false, durations);
+    double loop = run_empty(benchmark, iterations, false, durations);
+    std::vector<double> loops = durations;
+    double paused = run_empty(benchmark, iterations, true, durations);
+
+    overhead o;
+    o.m_run = empty;
+    o.m_iteration = std::max(0.0, (loop - empty) / iterations);
+    o.m_iteration_spread =
+        (quantile(loops, 0.75) - quantile(loops, 0.25)) / iterations;
+    o.m_pause = std::max(0.0, (paused - loop) / iterations);
+
+    return cache[key] = o;
+}
+}
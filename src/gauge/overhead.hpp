@@ -0,0 +1,43 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace gauge
+{
+/// The measurement overhead of the RUN loop on the current machine
+struct overhead
+{
+    /// The fixed cost in nanoseconds of every measurement i.e. reading
+    /// the clock at the start and stop and setting up the loop
+    double m_run;
+
+    /// The cost in nanoseconds of every iteration of an empty loop
+    double m_iteration;
+
+    /// The run-to-run spread in nanoseconds of the cost of an iteration
+    /// of the empty loop: the interquartile range over the calibration
+    /// runs
+    double m_iteration_spread;
+
+    /// The cost in nanoseconds of pausing and resuming the timing once,
+    /// which is not excluded by the pause
+    double m_pause;
+};
+
+/// Measures the overhead by running an empty RUN loop through the
+/// iteration controller and a time benchmark using the given clock.
+/// The calibration runs once for every combination of clock and
+/// sample interval and the result is cached.
+/// @param clock_name The name of the clock
+/// @param sample_interval The iteration sampling interval, the
+///        sampling adds to the cost of every iteration
+/// @return the measured overhead
+const overhead& calibrate_overhead(const std::string& clock_name,
+                                   uint64_t sample_interval);
+}
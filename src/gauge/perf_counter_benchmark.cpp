@@ -0,0 +1,152 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+#include "perf_counter_benchmark.hpp"
+#include "perf_counters.hpp"
+#include "runner.hpp"
+
+namespace gauge
+{
+class perf_counter_benchmark::impl
+{
+public:
+
+    /// The performance counters
+    perf_counters m_counters;
+
+    /// True if the counters have been opened
+    bool m_opened = false;
+
+    /// The event group measured in the current run
+    uint32_t m_group = 0;
+};
+
+perf_counter_benchmark::perf_counter_benchmark() :
+    m_impl(new perf_counter_benchmark::impl())
+{ }
+
+perf_counter_benchmark::~perf_counter_benchmark()
+{ }
+
+void perf_counter_benchmark::init()
+{
+    time_benchmark::init();
+
+    if (!m_impl->m_opened)
+    {
+        m_impl->m_counters.open(perf_events());
+        m_impl->m_opened = true;
+    }
+
+    m_impl->m_group = 0;
+}
+
+void perf_counter_benchmark::start()
+{
+    if (m_impl->m_counters.is_open())
+    {
+        m_impl->m_counters.select_group(m_impl->m_group);
+        m_impl->m_counters.start();
+    }
+
+    time_benchmark::start();
+}
+
+void perf_counter_benchmark::stop()
+{
+    time_benchmark::stop();
+
+    if (m_impl->m_counters.is_open())
+        m_impl->m_counters.stop();
+}
+
+void perf_counter_benchmark::pause()
+{
+    time_benchmark::pause();
+
+    if (m_impl->m_counters.is_open())
+        m_impl->m_counters.pause();
+}
+
+void perf_counter_benchmark::resume()
+{
+    if (m_impl->m_counters.is_open())
+        m_impl->m_counters.resume();
+
+    time_benchmark::resume();
+}
+
+void perf_counter_benchmark::prepare_table(tables::table& results)
+{
+    time_benchmark::prepare_table(results);
+
+    std::string source = "none";
+    if (m_impl->m_counters.is_open())
+        source = m_impl->m_counters.is_software() ? "software" : "hardware";
+
+    results.add_const_column("perf_counters", source);
+
+    // Create all the columns up front, with multiple event groups
+    // each run only fills in some of them
+    for (const auto& event : m_impl->m_counters.events())
+    {
+        if (!results.has_column(event))
+            results.add_column(event);
+    }
+}
+
+void perf_counter_benchmark::store_run(tables::table& results)
+{
+    time_benchmark::store_run(results);
+
+    if (!m_impl->m_counters.is_open())
+        return;
+
+    uint64_t iterations = run_iterations() * batch_size();
+    assert(iterations > 0);
+
+    for (const auto& count : m_impl->m_counters.counts())
+    {
+        if (!results.has_column(count.first))
+            results.add_column(count.first);
+
+        results.set_value(count.first, count.second / iterations);
+    }
+
+    // The next run measures the next group of events
+    m_impl->m_group =
+        (m_impl->m_group + 1) % m_impl->m_counters.group_count();
+}
+
+std::string perf_counter_benchmark::column_unit(
+    const std::string& column) const
+{
+    if (column == "task_clock")
+        return "nanoseconds/iteration";
+
+    for (const auto& event : m_impl->m_counters.events())
+    {
+        if (column == event)
+            return "events/iteration";
+    }
+
+    return time_benchmark::column_unit(column);
+}
+
+std::vector<std::string> perf_counter_benchmark::perf_events() const
+{
+    const auto& options = gauge::runner::instance().options();
+
+    if (options.count("perf_events"))
+        return options["perf_events"].as<std::vector<std::string>>();
+
+    return { "instructions", "cycles", "branch_misses", "l1d_misses",
+             "llc_misses", "dtlb_misses" };
+}
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "time_benchmark.hpp"
+
+namespace gauge
+{
+/// Benchmark measuring time and reading the CPU performance counters
+/// around the RUN loop. The counts are stored per iteration in a
+/// column for each event e.g. "instructions" or "branch_misses".
+///
+/// If the PMU cannot count all the requested events at the same time
+/// the events are split into groups which are measured in turn, one
+/// group per run. In that case each event column only has values for
+/// the runs in which its group was measured.
+///
+/// Example:
+///
+///    BENCHMARK_F_INLINE(gauge::perf_counter_benchmark, decoder, decode, 10)
+///    {
+///        RUN
+///        {
+///            decode_some_data();
+///        }
+///    }
+///
+class perf_counter_benchmark : public time_benchmark
+{
+public:
+
+    /// Constructor
+    perf_counter_benchmark();
+
+    /// Destructor
+    ~perf_counter_benchmark();
+
+public:
+    // From time_benchmark
+
+    /// @copydoc benchmark::init()
+    virtual void init();
+
+    /// @copydoc benchmark::start()
+    virtual void start();
+
+    /// @copydoc benchmark::stop()
+    virtual void stop();
+
+    /// @copydoc benchmark::pause()
+    virtual void pause();
+
+    /// @copydoc benchmark::resume()
+    virtual void resume();
+
+    /// @copydoc benchmark::prepare_table(tables::table&)
+    virtual void prepare_table(tables::table& results);
+
+    /// @copydoc benchmark::store_run(tables::table&)
+    virtual void store_run(tables::table& results);
+
+    /// @copydoc benchmark::column_unit(const std::string&) const
+    virtual std::string column_unit(const std::string& column) const;
+
+public:
+
+    /// @return the names of the events to count. By default the events
+    ///         selected with the --perf_events option are used.
+    virtual std::vector<std::string> perf_events() const;
+
+private:
+
+    class impl;
+    std::unique_ptr<impl> m_impl;
+};
+}
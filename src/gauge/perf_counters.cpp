@@ -0,0 +1,668 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "do_not_optimize.hpp"
+#include "perf_counters.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// Description of a perf event
+struct event_type
+{
+    /// The name used for the event in gauge
+    const char* m_name;
+
+    /// The perf_event_attr type
+    uint32_t m_type;
+
+    /// The perf_event_attr config
+    uint64_t m_config;
+};
+
+/// The kind of a perf event
+enum class event_kind
+{
+    /// One of the generic hardware events
+    hardware,
+
+    /// One of the software events
+    software,
+
+    /// An event of the core PMU described in sysfs
+    pmu
+};
+
+/// A perf event resolved to its perf_event_attr settings
+struct event_config
+{
+    /// The perf_event_attr type
+    uint32_t m_type;
+
+    /// The perf_event_attr config
+    uint64_t m_config;
+
+    /// The factor to multiply the counts with
+    double m_scale;
+
+    /// The kind of event
+    event_kind m_kind;
+};
+
+#if defined(__linux__)
+
+const uint64_t cache_read_miss =
+    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+const event_type hardware[] =
+{
+    { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+    { "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { "cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { "l1d_misses", PERF_TYPE_HW_CACHE,
+      PERF_COUNT_HW_CACHE_L1D | cache_read_miss },
+    { "llc_misses", PERF_TYPE_HW_CACHE,
+      PERF_COUNT_HW_CACHE_LL | cache_read_miss },
+    { "dtlb_misses", PERF_TYPE_HW_CACHE,
+      PERF_COUNT_HW_CACHE_DTLB | cache_read_miss }
+};
+
+const event_type software[] =
+{
+    { "task_clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+    { "page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+    { "context_switches", PERF_TYPE_SOFTWARE,
+      PERF_COUNT_SW_CONTEXT_SWITCHES },
+    { "cpu_migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS }
+};
+
+/// Reads the first line of a file
+/// @return true if the file could be read
+bool read_line(const std::string& path, std::string& line)
+{
+    std::ifstream file(path);
+    return file && std::getline(file, line);
+}
+
+/// @return the sysfs directory of the core PMU or an empty string if
+///         there is none
+std::string pmu_directory()
+{
+    // Hybrid CPUs expose the performance cores as "cpu_core"
+    for (const std::string pmu : { "cpu", "cpu_core" })
+    {
+        std::string directory = "/sys/bus/event_source/devices/" + pmu;
+        std::string type;
+
+        if (read_line(directory + "/type", type))
+            return directory;
+    }
+
+    return "";
+}
+
+/// Places the bits of a value into the config bit ranges of a sysfs
+/// format e.g. "config:0-7" or "config:0-7,32-35"
+/// @return true if the format could be applied
+bool apply_format(const std::string& format, uint64_t value,
+                  uint64_t& config)
+{
+    auto colon = format.find(':');
+    if (colon == std::string::npos || format.substr(0, colon) != "config")
+        return false;
+
+    std::istringstream ranges(format.substr(colon + 1));
+    std::string range;
+    uint32_t shift = 0;
+
+    while (std::getline(ranges, range, ','))
+    {
+        auto dash = range.find('-');
+        uint32_t first = std::stoul(range.substr(0, dash));
+        uint32_t last = dash == std::string::npos ?
+                        first : std::stoul(range.substr(dash + 1));
+
+        for (uint32_t bit = first; bit <= last && bit < 64; ++bit, ++shift)
+        {
+            if ((value >> shift) & 1)
+                config |= 1ULL << bit;
+        }
+    }
+
+    return true;
+}
+
+/// Looks up an event of the core PMU in sysfs. The event is described
+/// by terms such as "event=0x3c,umask=0x0,any=1" and the format
+/// directory tells where each term goes in the config.
+/// @return true if the event was found
+bool find_pmu_event(const std::string& name, event_config& config)
+{
+    if (name.empty() || name.find('/') != std::string::npos)
+        return false;
+
+    std::string directory = pmu_directory();
+    std::string type;
+    std::string terms;
+
+    if (directory.empty() ||
+        !read_line(directory + "/type", type) ||
+        !read_line(directory + "/events/" + name, terms))
+    {
+        return false;
+    }
+
+    try
+    {
+        config.m_type = std::stoul(type);
+        config.m_config = 0;
+        config.m_scale = 1.0;
+        config.m_kind = event_kind::pmu;
+
+        std::istringstream stream(terms);
+        std::string term;
+
+        while (std::getline(stream, term, ','))
+        {
+            auto equal = term.find('=');
+            std::string key = term.substr(0, equal);
+            uint64_t value = equal == std::string::npos ?
+                             1 : std::stoull(term.substr(equal + 1), 0, 0);
+
+            std::string format;
+            if (!read_line(directory + "/format/" + key, format) ||
+                !apply_format(format, value, config.m_config))
+            {
+                return false;
+            }
+        }
+
+        std::string scale;
+        if (read_line(directory + "/events/" + name + ".scale", scale))
+            config.m_scale = std::stod(scale);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/// Looks up an event by name
+/// @return true if the event was found
+bool find_event(const std::string& name, event_config& config)
+{
+    for (const auto& e : hardware)
+    {
+        if (name == e.m_name)
+        {
+            config = { e.m_type, e.m_config, 1.0, event_kind::hardware };
+            return true;
+        }
+    }
+
+    for (const auto& e : software)
+    {
+        if (name == e.m_name)
+        {
+            config = { e.m_type, e.m_config, 1.0, event_kind::software };
+            return true;
+        }
+    }
+
+    return find_pmu_event(name, config);
+}
+
+/// Opens a single event for the calling thread, only counting user
+/// space
+/// @param group_fd The group leader or -1 to open a new group
+/// @return the file descriptor or -1 on error
+int open_event(const event_config& event, int group_fd)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = event.m_type;
+    attr.config = event.m_config;
+    attr.disabled = group_fd == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP |
+                       PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return static_cast<int>(
+        syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+#else
+
+const event_type hardware[] =
+{
+    { "instructions", 0, 0 }, { "cycles", 0, 0 }, { "branches", 0, 0 },
+    { "branch_misses", 0, 0 }, { "cache_misses", 0, 0 },
+    { "l1d_misses", 0, 0 }, { "llc_misses", 0, 0 }, { "dtlb_misses", 0, 0 }
+};
+
+const event_type software[] =
+{
+    { "task_clock", 0, 0 }, { "page_faults", 0, 0 },
+    { "context_switches", 0, 0 }, { "cpu_migrations", 0, 0 }
+};
+
+bool find_event(const std::string& name, event_config& config)
+{
+    for (const auto& e : hardware)
+    {
+        if (name == e.m_name)
+        {
+            config = { 0, 0, 1.0, event_kind::hardware };
+            return true;
+        }
+    }
+
+    for (const auto& e : software)
+    {
+        if (name == e.m_name)
+        {
+            config = { 0, 0, 1.0, event_kind::software };
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#endif
+
+/// Prints a warning the first time it is given a specific message
+void warn_once(const std::string& message)
+{
+    static std::set<std::string> warned;
+
+    if (warned.insert(message).second)
+        std::cerr << "Warning: " << message << std::endl;
+}
+}
+
+struct perf_counters::impl
+{
+    /// A group of events counted together
+    struct group
+    {
+        /// The file descriptors of the events, the group leader first
+        std::vector<int> m_fds;
+
+        /// The names of the events
+        std::vector<std::string> m_events;
+
+        /// The factors to multiply the counts of the events with
+        std::vector<double> m_scales;
+    };
+
+    /// Opens the events as a group
+    /// @return true if all events could be opened
+    bool open_group(const std::vector<std::string>& events, group& g)
+    {
+        assert(g.m_fds.empty());
+        (void) events;
+
+#if defined(__linux__)
+        for (const auto& name : events)
+        {
+            event_config event;
+            bool found = find_event(name, event);
+            assert(found);
+            (void) found;
+
+            int leader = g.m_fds.empty() ? -1 : g.m_fds[0];
+            int fd = open_event(event, leader);
+
+            if (fd == -1)
+            {
+                close_group(g);
+                return false;
+            }
+
+            g.m_fds.push_back(fd);
+            g.m_events.push_back(name);
+            g.m_scales.push_back(event.m_scale);
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// Closes the events of a group
+    void close_group(group& g)
+    {
+#if defined(__linux__)
+        // Close the members before the leader
+        for (auto it = g.m_fds.rbegin(); it != g.m_fds.rend(); ++it)
+            ::close(*it);
+#endif
+        g.m_fds.clear();
+        g.m_events.clear();
+        g.m_scales.clear();
+    }
+
+    /// Enables the counters of a group
+    void enable(const group& g)
+    {
+        assert(!g.m_fds.empty());
+#if defined(__linux__)
+        ioctl(g.m_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(g.m_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    /// Disables the counters of a group and reads them
+    /// @return false if the group was never scheduled on the PMU
+    bool disable(const group& g, std::map<std::string, double>& counts)
+    {
+        assert(!g.m_fds.empty());
+        counts.clear();
+
+#if defined(__linux__)
+        ioctl(g.m_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // The layout is: nr, time_enabled, time_running, values[nr]
+        std::vector<uint64_t> buffer(3 + g.m_fds.size());
+        ssize_t size = buffer.size() * sizeof(uint64_t);
+
+        if (::read(g.m_fds[0], buffer.data(), size) != size)
+            return false;
+
+        assert(buffer[0] == g.m_fds.size());
+
+        uint64_t enabled = buffer[1];
+        uint64_t running = buffer[2];
+
+        if (running == 0)
+            return false;
+
+        // If the kernel had to multiplex our counters with other users
+        // we scale the counts to the full time enabled
+        double scale = static_cast<double>(enabled) / running;
+
+        for (uint32_t i = 0; i < g.m_events.size(); ++i)
+            counts[g.m_events[i]] = buffer[3 + i] * scale * g.m_scales[i];
+
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// Checks whether a group can be scheduled on the PMU i.e. whether
+    /// there are enough counters for all its events
+    bool probe(const group& g)
+    {
+        std::map<std::string, double> counts;
+
+        enable(g);
+        uint32_t work = 0;
+        for (uint32_t i = 0; i < 10000; ++i)
+        {
+            work = work + i;
+            do_not_optimize(work);
+        }
+        return disable(g, counts);
+    }
+
+    /// Opens the events splitting them into groups which fit the PMU
+    /// @return the names of the events which could not be opened
+    std::vector<std::string> open_groups(
+        const std::vector<std::string>& events)
+    {
+        std::vector<std::string> skipped;
+        group current;
+
+        for (const auto& name : events)
+        {
+            std::vector<std::string> candidate = current.m_events;
+            candidate.push_back(name);
+
+            group g;
+            if (open_group(candidate, g) && probe(g))
+            {
+                close_group(current);
+                current = g;
+                continue;
+            }
+            close_group(g);
+
+            // The event does not fit with the others so we start a new
+            // group
+            if (!current.m_fds.empty())
+            {
+                m_groups.push_back(current);
+                current = group();
+            }
+
+            if (open_group({ name }, g) && probe(g))
+            {
+                current = g;
+            }
+            else
+            {
+                close_group(g);
+                skipped.push_back(name);
+            }
+        }
+
+        if (!current.m_fds.empty())
+            m_groups.push_back(current);
+
+        return skipped;
+    }
+
+    /// The open event groups
+    std::vector<group> m_groups;
+
+    /// The selected group
+    uint32_t m_selected = 0;
+
+    /// True if we fell back to the software events
+    bool m_software = false;
+
+    /// The counts of the last measurement
+    std::map<std::string, double> m_counts;
+};
+
+perf_counters::perf_counters() :
+    m_impl(new perf_counters::impl())
+{ }
+
+perf_counters::~perf_counters()
+{
+    close();
+}
+
+void perf_counters::open(const std::vector<std::string>& events)
+{
+    assert(m_impl);
+    close();
+
+    // Only requests for the generic hardware events fall back to the
+    // software events
+    bool only_hardware = true;
+
+    for (const auto& name : events)
+    {
+        event_config event;
+        if (!find_event(name, event))
+            throw std::runtime_error("Error unknown perf event '" + name + "'");
+
+        only_hardware = only_hardware && event.m_kind == event_kind::hardware;
+    }
+
+#if defined(__linux__)
+    auto skipped = m_impl->open_groups(events);
+
+    // If none of the hardware events could be opened we are most likely
+    // in a virtual machine or the PMU is not accessible, so we use the
+    // software events instead
+    if (!events.empty() && only_hardware && m_impl->m_groups.empty())
+    {
+        close();
+        warn_once("the hardware perf events are not available, "
+                  "falling back to the software events");
+
+        skipped = m_impl->open_groups(software_events());
+        m_impl->m_software = true;
+    }
+
+    for (const auto& name : skipped)
+        warn_once("the perf event '" + name + "' is not available");
+#else
+    warn_once("the perf events are not available on this platform");
+#endif
+}
+
+void perf_counters::close()
+{
+    assert(m_impl);
+
+    for (auto& g : m_impl->m_groups)
+        m_impl->close_group(g);
+
+    m_impl->m_groups.clear();
+    m_impl->m_counts.clear();
+    m_impl->m_selected = 0;
+    m_impl->m_software = false;
+}
+
+bool perf_counters::is_open() const
+{
+    assert(m_impl);
+    return !m_impl->m_groups.empty();
+}
+
+bool perf_counters::is_software() const
+{
+    assert(m_impl);
+    return m_impl->m_software;
+}
+
+uint32_t perf_counters::group_count() const
+{
+    assert(m_impl);
+    return static_cast<uint32_t>(m_impl->m_groups.size());
+}
+
+std::vector<std::string> perf_counters::group_events(uint32_t group) const
+{
+    assert(m_impl);
+    assert(group < m_impl->m_groups.size());
+    return m_impl->m_groups[group].m_events;
+}
+
+std::vector<std::string> perf_counters::events() const
+{
+    assert(m_impl);
+
+    std::vector<std::string> names;
+    for (const auto& g : m_impl->m_groups)
+        names.insert(names.end(), g.m_events.begin(), g.m_events.end());
+
+    return names;
+}
+
+void perf_counters::select_group(uint32_t group)
+{
+    assert(m_impl);
+    assert(group < m_impl->m_groups.size());
+    m_impl->m_selected = group;
+}
+
+void perf_counters::start()
+{
+    assert(m_impl);
+    assert(is_open());
+    m_impl->enable(m_impl->m_groups[m_impl->m_selected]);
+}
+
+void perf_counters::stop()
+{
+    assert(m_impl);
+    assert(is_open());
+    m_impl->disable(m_impl->m_groups[m_impl->m_selected], m_impl->m_counts);
+}
+
+void perf_counters::pause()
+{
+    assert(m_impl);
+    assert(is_open());
+#if defined(__linux__)
+    const auto& g = m_impl->m_groups[m_impl->m_selected];
+    ioctl(g.m_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+void perf_counters::resume()
+{
+    assert(m_impl);
+    assert(is_open());
+#if defined(__linux__)
+    const auto& g = m_impl->m_groups[m_impl->m_selected];
+    ioctl(g.m_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+const std::map<std::string, double>& perf_counters::counts() const
+{
+    assert(m_impl);
+    return m_impl->m_counts;
+}
+
+bool perf_counters::has_event(const std::string& event)
+{
+    event_config config;
+    return find_event(event, config);
+}
+
+std::vector<std::string> perf_counters::hardware_events()
+{
+    std::vector<std::string> names;
+    for (const auto& e : hardware)
+        names.push_back(e.m_name);
+    return names;
+}
+
+std::vector<std::string> perf_counters::software_events()
+{
+    std::vector<std::string> names;
+    for (const auto& e : software)
+        names.push_back(e.m_name);
+    return names;
+}
+}
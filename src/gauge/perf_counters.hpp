@@ -0,0 +1,99 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gauge
+{
+/// Reads CPU performance counters using the Linux perf_event interface.
+///
+/// Besides the generic hardware and software events, the events the
+/// core PMU describes in sysfs can be used by their sysfs name
+/// e.g. "topdown-total-slots".
+///
+/// The requested events are split into groups which fit the counters
+/// of the PMU, all events in a group are counted together. If none of
+/// the generic hardware events can be opened e.g. when running in a
+/// virtual machine the software events are used instead. On other
+/// platforms no events are available.
+class perf_counters
+{
+public:
+
+    /// Constructor
+    perf_counters();
+
+    /// Destructor, closes the events
+    ~perf_counters();
+
+    /// Opens the events. Events which cannot be counted are skipped.
+    /// @param events The names of the events to open
+    void open(const std::vector<std::string>& events);
+
+    /// Closes all open events
+    void close();
+
+    /// @return true if at least one event is open
+    bool is_open() const;
+
+    /// @return true if the hardware events were unavailable and the
+    ///         software events were opened instead
+    bool is_software() const;
+
+    /// @return the number of event groups. If more events were
+    ///         requested than the PMU can count at the same time,
+    ///         the events must be measured in turn.
+    uint32_t group_count() const;
+
+    /// @param group The group index
+    /// @return the names of the events in a group
+    std::vector<std::string> group_events(uint32_t group) const;
+
+    /// @return the names of all the open events
+    std::vector<std::string> events() const;
+
+    /// Selects the group counted by the next start() / stop()
+    /// @param group The group index
+    void select_group(uint32_t group);
+
+    /// Resets and starts the counters of the selected group
+    void start();
+
+    /// Stops the counters of the selected group and reads them
+    void stop();
+
+    /// Pauses the counters of the selected group without resetting them
+    void pause();
+
+    /// Resumes the counters of the selected group after a pause()
+    void resume();
+
+    /// @return the counts of the selected group's events read by the
+    ///         last stop(). The counts are scaled if the kernel had to
+    ///         share the counters with others during the measurement.
+    const std::map<std::string, double>& counts() const;
+
+    /// @param event The name of an event
+    /// @return true if the event is known on this machine
+    static bool has_event(const std::string& event);
+
+    /// @return the names of the supported hardware events
+    static std::vector<std::string> hardware_events();
+
+    /// @return the names of the supported software events
+    static std::vector<std::string> software_events();
+
+private:
+
+    struct impl;
+    std::unique_ptr<impl> m_impl;
+};
+}
@@ -6,14 +6,19 @@
 #include <cassert>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
 
+#include <tables/format.hpp>
 #include <tables/table.hpp>
 
 #include "benchmark.hpp"
 #include "file_printer.hpp"
+#include "outliers.hpp"
 #include "runner.hpp"
+#include "statistics.hpp"
 
 namespace gauge
 {
@@ -39,5 +44,93 @@ bool printer::is_enabled() const
 void printer::set_options(const po::variables_map& options)
 {
     m_enabled = options["use_" + m_name].as<bool>();
+
+    if (options.count("summary"))
+        m_summary = options["summary"].as<std::vector<std::string>>();
+
+    if (options.count("outliers"))
+    {
+        m_exclude_outliers =
+            parse_outlier_policy(options["outliers"].as<std::string>()) ==
+            outlier_policy::exclude;
+        m_outlier_column = options["outlier_column"].as<std::string>();
+    }
+}
+
+std::vector<bool> printer::excluded_rows(const tables::table& results) const
+{
+    if (!m_exclude_outliers)
+        return std::vector<bool>(results.rows(), false);
+
+    return outlier_rows(results);
+}
+
+void printer::add_summary(tables::table& results) const
+{
+    auto excluded = excluded_rows(results);
+
+    for (const auto& column : m_summary)
+    {
+        if (!results.has_column(column))
+            continue;
+
+        // Only the rows with a value are summarized, which columns of
+        // events measured in turn do not have in every run
+        auto column_values = results.values(column);
+
+        std::vector<double> values;
+        for (uint64_t row = 0; row < column_values.size(); ++row)
+        {
+            const auto& v = column_values[row];
+
+            double value;
+            if (!v.empty() && !excluded[row] && numeric_value(v, value))
+                values.push_back(value);
+        }
+
+        if (values.empty())
+            continue;
+
+        statistics s = calculate_statistics(values.cbegin(), values.cend());
+
+        results.add_const_column(column + "_count", s.m_count);
+        results.add_const_column(column + "_mean", s.m_mean);
+        results.add_const_column(column + "_std_dev", s.m_std_dev);
+        results.add_const_column(column + "_cv", s.m_cv);
+        results.add_const_column(column + "_median", s.m_median);
+        results.add_const_column(column + "_mad", s.m_mad);
+        results.add_const_column(column + "_mean_ci_low", s.m_mean_ci_low);
+        results.add_const_column(column + "_mean_ci_high", s.m_mean_ci_high);
+        results.add_const_column(
+            column + "_median_ci_low", s.m_median_ci_low);
+        results.add_const_column(
+            column + "_median_ci_high", s.m_median_ci_high);
+    }
+}
+
+std::shared_ptr<const tables::table> printer::with_summary(
+    const std::shared_ptr<const tables::table>& results) const
+{
+    if (m_summary.empty())
+        return results;
+
+    auto output = std::make_shared<tables::table>(*results);
+    add_summary(*output);
+    return output;
+}
+
+void printer::print_list(
+    std::ostream& s, const tables::format& format,
+    const std::vector<std::shared_ptr<const tables::table>>& tables)
+{
+    s << "[";
+    for (uint32_t i = 0; i < tables.size(); ++i)
+    {
+        if (i > 0)
+            s << ",";
+
+        format.print(s, *tables[i]);
+    }
+    s << "]";
 }
 }
@@ -5,6 +5,11 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <tables/format.hpp>
 #include <tables/table.hpp>
 
 #include <boost/program_options.hpp>
@@ -55,6 +60,19 @@ public:
                                   const tables::table& /*results*/)
     { }
 
+    /// Called when a result from a benchmark is ready. The results are
+    /// shared by all the printers, so a printer keeping them should keep
+    /// the pointer instead of a copy. By default calls
+    /// benchmark_result(const benchmark&, const tables::table&).
+    /// @param info The benchmark
+    /// @param results The benchmark results
+    virtual void shared_benchmark_result(
+        const benchmark& info,
+        const std::shared_ptr<const tables::table>& results)
+    {
+        benchmark_result(info, *results);
+    }
+
     /// Called when a specific benchmark is finished
     virtual void end_benchmark()
     { }
@@ -67,6 +85,34 @@ public:
     virtual ~printer()
     { }
 
+protected:
+
+    /// Adds the summary statistics of the columns selected with the
+    /// --summary option as constant columns e.g. "time_median"
+    /// @param results The results to extend
+    void add_summary(tables::table& results) const;
+
+    /// @param results The results shared by all the printers
+    /// @return the results to keep, the shared table itself unless a
+    ///         summary is added which needs a copy of our own
+    std::shared_ptr<const tables::table> with_summary(
+        const std::shared_ptr<const tables::table>& results) const;
+
+    /// @param results The results
+    /// @return true for every row to leave out of the summary statistics
+    ///         i.e. the outliers if they are excluded
+    std::vector<bool> excluded_rows(const tables::table& results) const;
+
+    /// Prints tables as a list in brackets separated by commas. Every
+    /// table is formatted from the pointer, so unlike passing a vector of
+    /// tables to the format nothing is copied.
+    /// @param s The stream to print to
+    /// @param format The format of the tables
+    /// @param tables The tables
+    static void print_list(
+        std::ostream& s, const tables::format& format,
+        const std::vector<std::shared_ptr<const tables::table>>& tables);
+
 protected:
 
     /// Name of the printer
@@ -75,6 +121,15 @@ protected:
     /// Boolean determining wether the printer is enabled or not.
     bool m_enabled;
 
+    /// The columns to summarize
+    std::vector<std::string> m_summary;
+
+    /// True if outliers are left out of the summary statistics
+    bool m_exclude_outliers = false;
+
+    /// The column by which the outliers were found
+    std::string m_outlier_column;
+
 };
 
 }
@@ -0,0 +1,196 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <vector>
+
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
+#include "cpu_topology.hpp"
+#include "printer_pipeline.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// Pins the calling thread to a CPU. If the CPU is negative the highest
+/// allowed CPU which is not avoided is used.
+void pin_printer_thread(int32_t cpu, const std::vector<uint32_t>& avoid)
+{
+    if (cpu < 0)
+    {
+        auto allowed = allowed_cpus();
+        for (auto it = allowed.rbegin(); it != allowed.rend(); ++it)
+        {
+            if (std::find(avoid.begin(), avoid.end(), *it) == avoid.end())
+            {
+                cpu = *it;
+                break;
+            }
+        }
+    }
+
+    if (cpu >= 0)
+        pin_thread(cpu);
+}
+}
+
+struct printer_pipeline::impl
+{
+    /// The printer thread
+    std::thread m_thread;
+
+    /// Guards the queue and the flags
+    std::mutex m_mutex;
+
+    /// Signals new work or the stop
+    std::condition_variable m_condition;
+
+    /// Signals that the posted work is done
+    std::condition_variable m_idle;
+
+    /// True while the thread does a piece of work
+    bool m_busy = false;
+
+    /// The posted work
+    std::deque<std::function<void()>> m_queue;
+
+    /// True when the thread should stop once the queue is empty
+    bool m_stopping = false;
+
+    /// The first exception thrown by the work
+    std::exception_ptr m_error;
+
+    void run()
+    {
+        for (;;)
+        {
+            std::function<void()> work;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_busy = false;
+                if (m_queue.empty())
+                    m_idle.notify_all();
+
+                m_condition.wait(lock, [this]
+                    { return m_stopping || !m_queue.empty(); });
+
+                if (m_queue.empty())
+                    return;
+
+                work = std::move(m_queue.front());
+                m_queue.pop_front();
+                m_busy = true;
+            }
+
+            // After an error the remaining work is dropped, the error is
+            // reported by stop()
+            if (m_error)
+                continue;
+
+            try
+            {
+                work();
+            }
+            catch (...)
+            {
+                m_error = std::current_exception();
+            }
+        }
+    }
+
+    void join()
+    {
+        if (!m_thread.joinable())
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_condition.notify_one();
+        m_thread.join();
+    }
+};
+
+printer_pipeline::printer_pipeline() :
+    m_impl(new impl())
+{ }
+
+printer_pipeline::~printer_pipeline()
+{
+    m_impl->join();
+}
+
+void printer_pipeline::start(bool asynchronous, int32_t cpu,
+                             std::vector<uint32_t> avoid)
+{
+    assert(!m_impl->m_thread.joinable());
+
+    m_impl->m_stopping = false;
+    m_impl->m_error = nullptr;
+
+    if (!asynchronous)
+        return;
+
+#if defined(__linux__)
+    if (avoid.empty() && sched_getcpu() >= 0)
+        avoid.push_back(sched_getcpu());
+#endif
+
+    m_impl->m_thread = std::thread([this, cpu, avoid]
+    {
+        pin_printer_thread(cpu, avoid);
+        m_impl->run();
+    });
+}
+
+void printer_pipeline::post(const std::function<void()>& work)
+{
+    if (!m_impl->m_thread.joinable())
+    {
+        work();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+        m_impl->m_queue.push_back(work);
+    }
+    m_impl->m_condition.notify_one();
+}
+
+void printer_pipeline::wait()
+{
+    if (!m_impl->m_thread.joinable())
+        return;
+
+    std::unique_lock<std::mutex> lock(m_impl->m_mutex);
+    m_impl->m_idle.wait(lock, [this]
+        { return m_impl->m_queue.empty() && !m_impl->m_busy; });
+}
+
+void printer_pipeline::stop()
+{
+    m_impl->join();
+
+    if (m_impl->m_error)
+    {
+        auto error = m_impl->m_error;
+        m_impl->m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace gauge
+{
+/// Runs the work of the printers on a thread of its own, so the
+/// measurements never wait for formatting or I/O. The work is done in
+/// the order it was posted.
+class printer_pipeline
+{
+public:
+
+    /// Constructor
+    printer_pipeline();
+
+    /// Destructor, finishes the posted work without reporting errors
+    ~printer_pipeline();
+
+    /// Starts the printer thread
+    /// @param asynchronous If false no thread is started and the work is
+    ///        done when it is posted
+    /// @param cpu The CPU to run the printer thread on. If negative an
+    ///        allowed CPU which is not avoided is chosen when possible.
+    ///        Only supported on Linux.
+    /// @param avoid The CPUs to keep the printer thread off, if empty the
+    ///        CPU of the calling thread
+    void start(bool asynchronous, int32_t cpu,
+               std::vector<uint32_t> avoid = {});
+
+    /// Posts work to the printer thread
+    /// @param work The work
+    void post(const std::function<void()>& work);
+
+    /// Waits for the posted work to finish, the printer thread keeps
+    /// running. Used before a measurement running on several CPUs, which
+    /// may include the one of the printer thread.
+    void wait();
+
+    /// Waits for the posted work to finish and stops the printer thread.
+    /// An exception thrown by the work is rethrown here.
+    void stop();
+
+private:
+
+    struct impl;
+    std::unique_ptr<impl> m_impl;
+};
+}
@@ -21,6 +21,6 @@ python_printer::python_printer(const std::string& default_filename) :
 void python_printer::print_to_stream(std::ostream& s)
 {
     tables::python_format format;
-    format.print(s, m_tables);
+    print_list(s, format, m_tables);
 }
 }
@@ -0,0 +1,164 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/resource.h>
+    #include <sys/time.h>
+#endif
+
+#include <tables/table.hpp>
+
+#include "resource_usage.hpp"
+
+namespace gauge
+{
+namespace
+{
+#if defined(__linux__)
+/// Reads a size in kilobytes from /proc/self/status
+/// @return the size in bytes or zero if not found
+uint64_t read_status_size(const std::string& key)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, key.size(), key) != 0 ||
+            line.size() <= key.size() || line[key.size()] != ':')
+        {
+            continue;
+        }
+
+        std::istringstream value(line.substr(key.size() + 1));
+        uint64_t kilobytes = 0;
+        value >> kilobytes;
+        return kilobytes * 1024;
+    }
+
+    return 0;
+}
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+double microseconds(const timeval& t)
+{
+    return t.tv_sec * 1e6 + t.tv_usec;
+}
+#endif
+}
+
+bool read_resource_usage(resource_usage& usage, bool process)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    rusage r;
+#if defined(__linux__)
+    if (::getrusage(process ? RUSAGE_SELF : RUSAGE_THREAD, &r) != 0)
+        return false;
+#else
+    (void) process;
+    if (::getrusage(RUSAGE_SELF, &r) != 0)
+        return false;
+#endif
+
+    usage.m_user_time = microseconds(r.ru_utime);
+    usage.m_system_time = microseconds(r.ru_stime);
+    usage.m_minor_faults = r.ru_minflt;
+    usage.m_major_faults = r.ru_majflt;
+    usage.m_voluntary_switches = r.ru_nvcsw;
+    usage.m_involuntary_switches = r.ru_nivcsw;
+
+#if defined(__linux__)
+    usage.m_rss = read_status_size("VmRSS");
+    usage.m_peak_rss = read_status_size("VmHWM");
+#elif defined(__APPLE__)
+    // The peak of the process lifetime in bytes
+    usage.m_rss = 0;
+    usage.m_peak_rss = r.ru_maxrss;
+#else
+    // The peak of the process lifetime in kilobytes
+    usage.m_rss = 0;
+    usage.m_peak_rss = r.ru_maxrss * 1024;
+#endif
+
+    return true;
+#else
+    (void) usage;
+    (void) process;
+    return false;
+#endif
+}
+
+void reset_peak_rss()
+{
+#if defined(__linux__)
+    // Supported since Linux 4.0, older kernels keep the lifetime peak
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+#endif
+}
+
+void store_resource_usage(tables::table& results,
+                          const resource_usage& before,
+                          const resource_usage& after)
+{
+    auto columns = resource_usage_columns();
+    double values[] = {
+        after.m_user_time - before.m_user_time,
+        after.m_system_time - before.m_system_time,
+        static_cast<double>(after.m_minor_faults - before.m_minor_faults),
+        static_cast<double>(after.m_major_faults - before.m_major_faults),
+        static_cast<double>(after.m_voluntary_switches -
+                            before.m_voluntary_switches),
+        static_cast<double>(after.m_involuntary_switches -
+                            before.m_involuntary_switches),
+        static_cast<double>(after.m_rss) - static_cast<double>(before.m_rss),
+        static_cast<double>(after.m_peak_rss) };
+
+    for (uint32_t i = 0; i < columns.size(); ++i)
+    {
+        // Without /proc we do not know the resident set size
+        if (columns[i] == "rss_delta" && after.m_rss == 0)
+            continue;
+
+        if (columns[i] == "rss_peak" && after.m_peak_rss == 0)
+            continue;
+
+        if (!results.has_column(columns[i]))
+            results.add_column(columns[i]);
+
+        results.set_value(columns[i], values[i]);
+    }
+}
+
+std::vector<std::string> resource_usage_columns()
+{
+    return { "cpu_user", "cpu_system", "minor_faults", "major_faults",
+             "voluntary_switches", "involuntary_switches", "rss_delta",
+             "rss_peak" };
+}
+
+std::string resource_usage_unit(const std::string& column)
+{
+    if (column == "cpu_user" || column == "cpu_system")
+        return "microseconds/run";
+
+    if (column == "minor_faults" || column == "major_faults")
+        return "faults/run";
+
+    if (column == "voluntary_switches" || column == "involuntary_switches")
+        return "switches/run";
+
+    if (column == "rss_delta" || column == "rss_peak")
+        return "bytes";
+
+    return "";
+}
+}
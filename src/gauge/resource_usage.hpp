@@ -0,0 +1,79 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tables
+{
+class table;
+}
+
+namespace gauge
+{
+/// A snapshot of the resources used by the benchmark thread and the
+/// process
+struct resource_usage
+{
+    /// The CPU time spent in user mode in microseconds
+    double m_user_time;
+
+    /// The CPU time spent in the kernel in microseconds
+    double m_system_time;
+
+    /// The page faults served without I/O
+    uint64_t m_minor_faults;
+
+    /// The page faults which required I/O
+    uint64_t m_major_faults;
+
+    /// The context switches because the thread waited for a resource
+    uint64_t m_voluntary_switches;
+
+    /// The context switches because the thread was preempted
+    uint64_t m_involuntary_switches;
+
+    /// The resident set size of the process in bytes, zero if unknown
+    uint64_t m_rss;
+
+    /// The peak resident set size of the process in bytes since the last
+    /// reset_peak_rss(), zero if unknown
+    uint64_t m_peak_rss;
+};
+
+/// Reads the resources used so far. On Linux the times, faults and
+/// context switches are those of the calling thread, elsewhere or if
+/// requested those of the process.
+/// @param usage The snapshot to fill in
+/// @param process True to read the resources used by all the threads of
+///        the process
+/// @return false if the resource usage is not available on this platform
+bool read_resource_usage(resource_usage& usage, bool process = false);
+
+/// Resets the peak resident set size of the process to the current size
+/// if the platform supports it
+void reset_peak_rss();
+
+/// Stores the resources used between two snapshots in the results i.e.
+/// the CPU times, faults and context switches of the run, the change of
+/// the resident set size and its peak
+/// @param results The table containing the results
+/// @param before The snapshot taken before the run
+/// @param after The snapshot taken after the run
+void store_resource_usage(tables::table& results,
+                          const resource_usage& before,
+                          const resource_usage& after);
+
+/// @return the names of the columns stored by store_resource_usage()
+std::vector<std::string> resource_usage_columns();
+
+/// @param column The name of a column
+/// @return the unit of a resource usage column or an empty string if the
+///         column is not a resource usage column
+std::string resource_usage_unit(const std::string& column);
+}
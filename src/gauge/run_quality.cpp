@@ -0,0 +1,210 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/resource.h>
+#endif
+
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
+#include <tables/table.hpp>
+
+#include "run_quality.hpp"
+
+namespace gauge
+{
+namespace
+{
+#if defined(__linux__)
+/// Sums the interrupts served by a CPU from /proc/interrupts
+/// @return the number of interrupts or zero if unknown
+uint64_t read_interrupts(int32_t cpu)
+{
+    std::ifstream interrupts("/proc/interrupts");
+    std::string line;
+
+    // The first line names the CPU columns e.g. "CPU0 CPU1"
+    if (!std::getline(interrupts, line))
+        return 0;
+
+    std::istringstream header(line);
+    std::string name;
+    int32_t column = -1;
+    for (int32_t i = 0; header >> name; ++i)
+    {
+        if (name == "CPU" + std::to_string(cpu))
+            column = i;
+    }
+
+    if (column < 0)
+        return 0;
+
+    uint64_t total = 0;
+    while (std::getline(interrupts, line))
+    {
+        std::istringstream fields(line);
+        std::string label;
+        fields >> label;
+
+        // Lines with fewer counts than CPUs e.g. "ERR:" are skipped by
+        // the failing extraction
+        uint64_t count = 0;
+        for (int32_t i = 0; i <= column; ++i)
+        {
+            if (!(fields >> count))
+            {
+                count = 0;
+                break;
+            }
+        }
+
+        total += count;
+    }
+
+    return total;
+}
+
+/// @return the current frequency of a CPU in kHz or zero if unknown
+uint64_t read_frequency(int32_t cpu)
+{
+    std::ifstream frequency("/sys/devices/system/cpu/cpu" +
+                            std::to_string(cpu) +
+                            "/cpufreq/scaling_cur_freq");
+    uint64_t khz = 0;
+    frequency >> khz;
+    return khz;
+}
+#endif
+}
+
+bool take_run_snapshot(run_snapshot& snapshot)
+{
+    snapshot.m_cpu = -1;
+    snapshot.m_switches = 0;
+    snapshot.m_interrupts = 0;
+    snapshot.m_frequency = 0;
+
+#if defined(__unix__) || defined(__APPLE__)
+    rusage r;
+#if defined(__linux__)
+    if (::getrusage(RUSAGE_THREAD, &r) != 0)
+        return false;
+#else
+    if (::getrusage(RUSAGE_SELF, &r) != 0)
+        return false;
+#endif
+    snapshot.m_switches = r.ru_nivcsw;
+
+#if defined(__linux__)
+    snapshot.m_cpu = ::sched_getcpu();
+    if (snapshot.m_cpu >= 0)
+    {
+        snapshot.m_interrupts = read_interrupts(snapshot.m_cpu);
+        snapshot.m_frequency = read_frequency(snapshot.m_cpu);
+    }
+#endif
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+run_noise compare_run_snapshots(const run_snapshot& before,
+                                const run_snapshot& after)
+{
+    run_noise noise;
+    noise.m_switches = after.m_switches - before.m_switches;
+    noise.m_migrated = before.m_cpu != after.m_cpu;
+
+    // The interrupt counts of different CPUs cannot be compared
+    noise.m_interrupts = 0;
+    if (!noise.m_migrated && after.m_interrupts >= before.m_interrupts)
+        noise.m_interrupts = after.m_interrupts - before.m_interrupts;
+
+    noise.m_frequency_change = 0;
+    if (before.m_frequency > 0 && after.m_frequency > 0)
+    {
+        noise.m_frequency_change =
+            (static_cast<double>(after.m_frequency) - before.m_frequency) *
+            100.0 / before.m_frequency;
+    }
+
+    return noise;
+}
+
+bool is_noisy(const run_noise& noise, const noise_limits& limits)
+{
+    if (limits.m_max_switches >= 0 &&
+        noise.m_switches > static_cast<uint64_t>(limits.m_max_switches))
+    {
+        return true;
+    }
+
+    if (limits.m_max_interrupts >= 0 &&
+        noise.m_interrupts > static_cast<uint64_t>(limits.m_max_interrupts))
+    {
+        return true;
+    }
+
+    if (limits.m_max_frequency_change >= 0 &&
+        std::fabs(noise.m_frequency_change) > limits.m_max_frequency_change)
+    {
+        return true;
+    }
+
+    return limits.m_reject_migrations && noise.m_migrated;
+}
+
+void store_run_noise(tables::table& results, const run_noise& noise,
+                     bool has_frequency)
+{
+    std::vector<std::string> columns = { "noise_switches",
+                                         "noise_migrations",
+                                         "noise_interrupts" };
+    std::vector<double> values = { static_cast<double>(noise.m_switches),
+                                   noise.m_migrated ? 1.0 : 0.0,
+                                   static_cast<double>(noise.m_interrupts) };
+
+    if (has_frequency)
+    {
+        columns.push_back("noise_frequency_change");
+        values.push_back(noise.m_frequency_change);
+    }
+
+    for (uint32_t i = 0; i < columns.size(); ++i)
+    {
+        if (!results.has_column(columns[i]))
+            results.add_column(columns[i]);
+
+        results.set_value(columns[i], values[i]);
+    }
+}
+
+std::string run_noise_unit(const std::string& column)
+{
+    if (column == "noise_switches")
+        return "preemptions/run";
+
+    if (column == "noise_migrations")
+        return "migrations/run";
+
+    if (column == "noise_interrupts")
+        return "interrupts/run";
+
+    if (column == "noise_frequency_change")
+        return "percent";
+
+    return "";
+}
+}
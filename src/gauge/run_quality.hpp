@@ -0,0 +1,98 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tables
+{
+class table;
+}
+
+namespace gauge
+{
+/// The state of the machine relevant to the noise of a run, taken
+/// before and after the run
+struct run_snapshot
+{
+    /// The CPU the benchmark thread runs on, negative if unknown
+    int32_t m_cpu;
+
+    /// The involuntary context switches of the benchmark thread
+    uint64_t m_switches;
+
+    /// The interrupts served by the CPU, zero if unknown
+    uint64_t m_interrupts;
+
+    /// The current frequency of the CPU in kHz, zero if unknown
+    uint64_t m_frequency;
+};
+
+/// The noise indicators of a run
+struct run_noise
+{
+    /// The number of times the benchmark thread was preempted
+    uint64_t m_switches;
+
+    /// True if the benchmark thread was moved to another CPU
+    bool m_migrated;
+
+    /// The number of interrupts served by the CPU during the run. Only
+    /// known if the thread did not migrate.
+    uint64_t m_interrupts;
+
+    /// The change of the CPU frequency in percent, zero if unknown
+    double m_frequency_change;
+};
+
+/// The limits above which a run is considered too noisy, a negative
+/// limit is disabled
+struct noise_limits
+{
+    /// The largest number of preemptions
+    int64_t m_max_switches = -1;
+
+    /// The largest number of interrupts
+    int64_t m_max_interrupts = -1;
+
+    /// The largest change of the CPU frequency in percent
+    double m_max_frequency_change = -1;
+
+    /// True if runs moved to another CPU are rejected
+    bool m_reject_migrations = false;
+};
+
+/// Takes a snapshot of the noise sources for the calling thread. The
+/// interrupts and the frequency are only available on Linux.
+/// @param snapshot The snapshot to fill in
+/// @return false if no noise indicators are available on this platform
+bool take_run_snapshot(run_snapshot& snapshot);
+
+/// @param before The snapshot taken before the run
+/// @param after The snapshot taken after the run
+/// @return the noise indicators of the run
+run_noise compare_run_snapshots(const run_snapshot& before,
+                                const run_snapshot& after);
+
+/// @param noise The noise indicators of a run
+/// @param limits The limits
+/// @return true if the noise of the run exceeds one of the limits
+bool is_noisy(const run_noise& noise, const noise_limits& limits);
+
+/// Stores the noise indicators of a run in the results
+/// @param results The table containing the results
+/// @param noise The noise indicators of the run
+/// @param has_frequency True if the CPU frequency could be read
+void store_run_noise(tables::table& results, const run_noise& noise,
+                     bool has_frequency);
+
+/// @param column The name of a column
+/// @return the unit of a noise indicator column or an empty string if the
+///         column is not a noise indicator column
+std::string run_noise_unit(const std::string& column);
+}
@@ -3,27 +3,207 @@
 //
 // Distributed under the "BSD License". See the accompanying LICENSE.rst file.
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <cstdlib>
 #include <ctime>
+#include <exception>
 #include <string>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <limits>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 #include <boost/program_options.hpp>
 
+#include <tables/format.hpp>
+
+#include "baseline.hpp"
+#include "benchmark_snapshot.hpp"
+#include "clock.hpp"
 #include "console_printer.hpp"
+#include "copy_rate.hpp"
+#include "cpu_topology.hpp"
 #include "csv_printer.hpp"
+#include "csv_stream_printer.hpp"
+#include "history.hpp"
+#include "history_printer.hpp"
 #include "json_printer.hpp"
+#include "jsonl_printer.hpp"
+#include "outliers.hpp"
+#include "environment.hpp"
+#include "printer_pipeline.hpp"
 #include "python_printer.hpp"
 #include "stdout_printer.hpp"
+#include "resource_usage.hpp"
+#include "run_quality.hpp"
 #include "results.hpp"
+#include "speedup.hpp"
+#include "spin_barrier.hpp"
+#include "statistics.hpp"
+#include "thread_benchmark.hpp"
 
 #include "runner.hpp"
 
 namespace gauge
 {
+namespace
+{
+/// @return the noise limits set with the command line options
+noise_limits parse_noise_limits(const po::variables_map& options)
+{
+    noise_limits limits;
+
+    if (options.count("max_preemptions"))
+    {
+        limits.m_max_switches =
+            options["max_preemptions"].as<uint64_t>();
+    }
+
+    if (options.count("max_interrupts"))
+    {
+        limits.m_max_interrupts =
+            options["max_interrupts"].as<uint64_t>();
+    }
+
+    if (options.count("max_frequency_change"))
+    {
+        limits.m_max_frequency_change =
+            options["max_frequency_change"].as<double>();
+    }
+
+    limits.m_reject_migrations = options.count("reject_migrations") > 0;
+
+    return limits;
+}
+
+/// @param results The results
+/// @param column The column
+/// @param excluded The rows to skip, none if empty
+/// @return the values of a column of doubles, skipping the rows without
+///         a value. Empty if there is no such column.
+std::vector<double> column_values(const tables::table& results,
+                                  const std::string& column,
+                                  const std::vector<bool>& excluded = {})
+{
+    std::vector<double> values;
+
+    if (!results.has_column(column) || !results.is_column<double>(column))
+        return values;
+
+    auto column_values = results.values(column);
+    for (uint64_t row = 0; row < column_values.size(); ++row)
+    {
+        const auto& v = column_values[row];
+
+        if (v.empty() || (row < excluded.size() && excluded[row]))
+            continue;
+
+        values.push_back(boost::any_cast<double>(v));
+    }
+
+    return values;
+}
+
+/// @param results The results of the runs so far
+/// @param column The column to check
+/// @param median True to use the median otherwise the mean
+/// @param excluded The rows left out of the statistic
+/// @return the half width of the 95% confidence interval relative to the
+///         statistic or a negative value if it cannot be calculated
+double relative_confidence_interval(const tables::table& results,
+                                    const std::string& column, bool median,
+                                    const std::vector<bool>& excluded)
+{
+    std::vector<double> values = column_values(results, column, excluded);
+
+    if (values.size() < 2)
+        return -1;
+
+    statistics s = calculate_statistics(values.cbegin(), values.cend());
+
+    double center = median ? s.m_median : s.m_mean;
+    double width = median ? s.m_median_ci_high - s.m_median_ci_low :
+                   s.m_mean_ci_high - s.m_mean_ci_low;
+
+    if (center == 0)
+        return -1;
+
+    return width / 2.0 / std::fabs(center);
+}
+
+/// Stops the printer pipeline when it goes out of scope, so the printer
+/// thread is also stopped when a benchmark throws. An error of the
+/// printers is then only reported, the error being thrown is kept.
+class pipeline_stopper
+{
+public:
+
+    explicit pipeline_stopper(printer_pipeline& pipeline) :
+        m_pipeline(pipeline),
+        m_stopped(false)
+    { }
+
+    ~pipeline_stopper()
+    {
+        if (m_stopped)
+            return;
+
+        try
+        {
+            m_pipeline.stop();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error in a printer: " << e.what() << std::endl;
+        }
+    }
+
+    /// Stops the pipeline, an error of the printers is rethrown
+    void stop()
+    {
+        m_stopped = true;
+        m_pipeline.stop();
+    }
+
+private:
+
+    printer_pipeline& m_pipeline;
+    bool m_stopped;
+};
+
+/// Restores the settings of the calling thread changed by
+/// apply_environment() when it goes out of scope, so the caller of
+/// runner::run() gets its thread back as it was
+class environment_restorer
+{
+public:
+
+    explicit environment_restorer(const previous_environment& previous) :
+        m_previous(previous)
+    { }
+
+    ~environment_restorer()
+    {
+        restore_environment(m_previous);
+    }
+
+private:
+
+    const previous_environment& m_previous;
+};
+
+/// The benchmark bound to the calling thread, see
+/// runner::set_thread_benchmark()
+thread_local runner::benchmark_ptr bound_benchmark;
+}
+
 struct runner::impl
 {
     /// Benchmark container
@@ -53,6 +233,46 @@ struct runner::impl
 
     /// Custom columns
     std::map<std::string, std::string> m_columns;
+
+    /// Runs the printers
+    printer_pipeline m_pipeline;
+
+    /// The start time of the current benchmark, taken on the measuring
+    /// thread
+    std::chrono::high_resolution_clock::time_point m_benchmark_start;
+
+    /// The rows of the --baseline results
+    std::vector<result_row> m_baseline;
+
+    /// The number of benchmarks which regressed compared to the baseline
+    uint32_t m_regressions = 0;
+
+    /// The thread counts the thread benchmarks are run with, empty for
+    /// their default
+    std::vector<uint32_t> m_thread_counts;
+
+    /// The median rate of the body with one thread in the current
+    /// scaling sweep, negative if not known
+    double m_reference_rate = -1;
+
+    /// The number of copies run in the rate mode, zero if disabled
+    uint32_t m_copies = 0;
+
+    /// The median time of the last benchmark run as a single copy,
+    /// negative if not known
+    double m_single_copy_time = -1;
+
+    /// The execution environment requested for the measuring thread
+    environment_request m_environment_request;
+
+    /// The execution environment in effect
+    environment m_environment;
+
+    /// True if every run starts on a fresh scheduler time slice
+    bool m_fresh_quantum = false;
+
+    /// The time spun before every run in microseconds
+    double m_prerun_spin = 0;
 };
 
 runner::runner() :
@@ -81,6 +301,15 @@ void runner::add_default_printers()
 
     instance().printers().push_back(
         std::make_shared<gauge::stdout_printer>());
+
+    instance().printers().push_back(
+        std::make_shared<gauge::history_printer>());
+
+    instance().printers().push_back(
+        std::make_shared<gauge::jsonl_printer>());
+
+    instance().printers().push_back(
+        std::make_shared<gauge::csv_stream_printer>());
 }
 
 void runner::run_benchmarks(int argc, const char* argv[])
@@ -120,12 +349,26 @@ void runner::add_benchmark(uint32_t id,
     m_impl->m_testcases[testcase_name][benchmark_name] = id;
 }
 
-runner::benchmark_ptr runner::current_benchmark()
+const po::variables_map& runner::options() const
 {
+    assert(m_impl);
+    return m_impl->m_options;
+}
+
+const runner::benchmark_ptr& runner::current_benchmark()
+{
+    if (bound_benchmark)
+        return bound_benchmark;
+
     assert(m_impl->m_current_benchmark);
     return m_impl->m_current_benchmark;
 }
 
+void runner::set_thread_benchmark(const benchmark_ptr& benchmark)
+{
+    bound_benchmark = benchmark;
+}
+
 void runner::run(int argc, const char* argv[])
 {
     try
@@ -145,6 +388,12 @@ void runner::run_unsafe(int argc, const char* argv[])
 
     po::options_description options("Gauge");
 
+    std::string clocks;
+    for (const auto& name : clock_names())
+    {
+        clocks += (clocks.empty() ? "" : ", ") + name;
+    }
+
     options.add_options()
     ("help", "produce help message")
     ("print_tests", "print testcases")
@@ -169,6 +418,195 @@ void runner::run_unsafe(int argc, const char* argv[])
      "Set the CPU warm-up time in seconds before starting the first benchmark. "
      "This should avoid unfavorable results for the first few benchmarks "
      "due to the CPU power-saving mechanisms, e.g. --warmup_time=5.0")
+    ("min_run_time", po::value<double>(),
+     "Set the minimum duration of a run in microseconds before a time "
+     "measurement is accepted. By default the duration is derived from "
+     "the resolution and read cost of the selected clock, "
+     "e.g. --min_run_time=10000")
+    ("overhead_correction", po::value<bool>()->default_value(true),
+     "Calibrate the overhead of the clock reads and an empty RUN loop and "
+     "store the overhead corrected time per iteration in the "
+     "time_corrected column next to the raw time, "
+     "e.g. --overhead_correction=0")
+    ("target_rel_ci", po::value<double>(),
+     "Repeat the runs of every benchmark until the 95% confidence interval "
+     "of the target statistic is within the given fraction of it, between "
+     "--min_runs and --max_runs runs. Overrides the runs set in the "
+     "benchmark and --runs, e.g. --target_rel_ci=0.01 for +-1%")
+    ("min_runs", po::value<uint32_t>()->default_value(5),
+     "Set the number of runs completed before the confidence interval is "
+     "checked with --target_rel_ci, e.g. --min_runs=10")
+    ("max_runs", po::value<uint32_t>()->default_value(1000),
+     "Set the number of runs after which a benchmark stops even if "
+     "--target_rel_ci is not met, e.g. --max_runs=200")
+    ("target_statistic", po::value<std::string>()->default_value("median"),
+     "Set the statistic of --target_column whose confidence interval is "
+     "checked with --target_rel_ci, either mean or median, "
+     "e.g. --target_statistic=mean")
+    ("target_column", po::value<std::string>()->default_value("time"),
+     "Set the result column checked with --target_rel_ci, "
+     "e.g. --target_column=cycles")
+    ("latency_interval", po::value<uint64_t>(),
+     "Sample the latency of single iterations inside RUN and report the "
+     "50th, 90th, 99th and 99.9th percentile and maximum per run. The "
+     "first iteration is reported separately. The value sets how often "
+     "an iteration is sampled, 1 samples every iteration while larger "
+     "values keep the overhead down for very short iterations, "
+     "e.g. --latency_interval=16")
+    ("clock", po::value<std::string>()->default_value("high_resolution"),
+     ("Set the clock used by the time benchmarks, the available clocks "
+      "are: " + clocks + ". A benchmark may override the clock used, "
+      "e.g. --clock=tsc").c_str())
+    ("perf_events",
+     po::value<std::vector<std::string> >()->multitoken(),
+     "Set the events counted by the perf counter benchmarks. The "
+     "default events are instructions, cycles, branch_misses, "
+     "l1d_misses, llc_misses and dtlb_misses "
+     "e.g. --perf_events instructions cycles branches")
+    ("resource_usage",
+     "Store the resources used by every run of a benchmark: the user and "
+     "system CPU time, the minor and major page faults, the voluntary and "
+     "involuntary context switches and on Linux the change and peak of "
+     "the resident set size")
+    ("run_quality",
+     "Store the noise indicators of every run: the preemptions of the "
+     "benchmark thread, whether it migrated to another CPU and on Linux "
+     "the interrupts served by its CPU and the change of the CPU "
+     "frequency. Implied by the options rejecting noisy runs")
+    ("max_preemptions", po::value<uint64_t>(),
+     "Reject and repeat runs in which the benchmark thread was preempted "
+     "more often, e.g. --max_preemptions=0")
+    ("max_interrupts", po::value<uint64_t>(),
+     "Reject and repeat runs in which the CPU served more interrupts, "
+     "e.g. --max_interrupts=100")
+    ("max_frequency_change", po::value<double>(),
+     "Reject and repeat runs in which the CPU frequency changed by more "
+     "percent, e.g. --max_frequency_change=5")
+    ("reject_migrations",
+     "Reject and repeat runs in which the benchmark thread moved to "
+     "another CPU")
+    ("max_retries", po::value<uint32_t>()->default_value(10),
+     "Set the number of times a noisy run is repeated before it is "
+     "accepted anyway, e.g. --max_retries=20")
+    ("track_allocations",
+     "Count the heap allocations, frees and allocated bytes inside the RUN "
+     "loop of the time benchmarks and report them per iteration. Requires "
+     "gauge/allocation_hooks.hpp or gauge/malloc_hooks.hpp to be included "
+     "in one source file of the benchmark program")
+    ("topdown",
+     "Count the top-down slot events around the RUN loop of the time "
+     "benchmarks and report the level 1 breakdown into frontend bound, "
+     "bad speculation, backend bound and retiring. Requires a CPU "
+     "exposing the slot events through perf")
+    ("outliers", po::value<std::string>()->default_value("keep"),
+     "Set what is done with outlying runs: keep does not look for them, "
+     "flag tags them in the outlier column and reports them and exclude "
+     "also leaves them out of the summary statistics, the target "
+     "confidence interval, the baseline comparison, the speedup, the "
+     "rate and the history, e.g. --outliers=flag")
+    ("outlier_method", po::value<std::string>()->default_value("tukey"),
+     "Set how outlying runs are found: tukey uses the fences at 1.5 and 3 "
+     "times the interquartile range, mad uses 3 and 5 standard deviations "
+     "estimated from the median absolute deviation, "
+     "e.g. --outlier_method=mad")
+    ("outlier_column", po::value<std::string>()->default_value("time"),
+     "Set the result column by which outlying runs are found, "
+     "e.g. --outlier_column=cycles")
+    ("baseline", po::value<std::string>(),
+     "Compare the results with a baseline written by the json or csv "
+     "printer. The benchmarks are matched by testcase, benchmark and "
+     "configuration, and the runs of --baseline_column are compared with "
+     "the Mann-Whitney U test. The program fails if a benchmark regressed, "
+     "e.g. --baseline=gauge_old.json")
+    ("baseline_column", po::value<std::string>()->default_value("time"),
+     "Set the result column compared with the baseline, lower values are "
+     "better, e.g. --baseline_column=cycles")
+    ("regression_threshold", po::value<double>()->default_value(0.05),
+     "Set the relative slowdown of the median compared to the baseline "
+     "above which a benchmark has regressed, unless the benchmark sets its "
+     "own, e.g. --regression_threshold=0.1 for 10%")
+    ("significance", po::value<double>()->default_value(0.05),
+     "Set the p-value below which a difference to the baseline is "
+     "significant, e.g. --significance=0.01")
+    ("history_dir", po::value<std::string>()->default_value("gauge_history"),
+     "Set the directory of the result history store written by the "
+     "history printer (enabled with --use_history=1) and searched by "
+     "--history_query and --history_trend, e.g. --history_dir=/data/gauge")
+    ("revision", po::value<std::string>()->default_value(""),
+     "Set the revision stored with the results in the history, "
+     "e.g. --revision=$(git rev-parse --short HEAD)")
+    ("history_query", po::value<std::string>(),
+     "Print the median of --history_column of every stored result of the "
+     "benchmarks matching the filter instead of running them, "
+     "e.g. --history_query=MyTest.*")
+    ("history_trend", po::value<std::string>(),
+     "Print the revisions at which the median of --history_column of the "
+     "benchmarks matching the filter shifted instead of running them, "
+     "e.g. --history_trend=*.*")
+    ("history_column", po::value<std::string>()->default_value("time"),
+     "Set the column used by --history_query and --history_trend, "
+     "e.g. --history_column=cycles")
+    ("trend_threshold", po::value<double>()->default_value(0.05),
+     "Set the smallest relative shift reported by --history_trend, "
+     "e.g. --trend_threshold=0.02")
+    ("async_printers", po::value<bool>()->default_value(true),
+     "Run the printers on a thread of their own, so the measurements do "
+     "not wait for the results to be formatted and written, "
+     "e.g. --async_printers=0")
+    ("printer_cpu", po::value<int32_t>(),
+     "Set the CPU the printer thread runs on. By default a CPU other than "
+     "the one running the benchmarks is chosen, e.g. --printer_cpu=3")
+    ("threads", po::value<std::vector<uint32_t> >()->multitoken(),
+     "Run the thread benchmarks with the given numbers of threads. With "
+     "several counts the benchmarks are run once per count in increasing "
+     "order starting with one thread, and the speedup, parallel "
+     "efficiency and Karp-Flatt serial fraction of every step are "
+     "reported, e.g. --threads 1 2 4 8")
+    ("thread_scaling",
+     "Run the thread benchmarks in a scaling sweep with 1, 2, 4 ... "
+     "threads up to the number of physical cores and then on all "
+     "hardware threads, see --threads")
+    ("pin_threads", po::value<bool>()->default_value(true),
+     "Pin the threads of the thread benchmarks to the allowed CPUs, one "
+     "per physical core first and then on the SMT siblings, "
+     "e.g. --pin_threads=0")
+    ("copies", po::value<uint32_t>(),
+     "Rate mode: after every benchmark also run the given number of "
+     "independent copies of it at the same time, pinned one per physical "
+     "core, and report their aggregate rate and slowdown compared to the "
+     "single copy. Zero runs one copy per physical core, e.g. --copies=8")
+    ("pin_cpu", po::value<std::string>(),
+     "Pin the thread running the benchmarks to a CPU. With auto an "
+     "isolated CPU is chosen if there is one, see the isolcpus kernel "
+     "parameter, and the printer thread is kept off the SMT siblings of "
+     "the CPU, e.g. --pin_cpu=auto or --pin_cpu=3")
+    ("sched_fifo", po::value<int32_t>(),
+     "Run the benchmarks with the SCHED_FIFO real-time policy at the given "
+     "priority from 1 to 99, if permitted, e.g. --sched_fifo=10")
+    ("nice", po::value<int32_t>(),
+     "Run the benchmarks with the given nice value, if permitted, "
+     "e.g. --nice=-10")
+    ("mlockall",
+     "Lock the memory of the process, so no page faults occur when "
+     "memory is swapped out")
+    ("timer_slack", po::value<uint64_t>(),
+     "Set the timer slack of the thread running the benchmarks in "
+     "nanoseconds, so sleeping threads wake up closer to their deadline, "
+     "e.g. --timer_slack=1")
+    ("prerun_yield",
+     "Yield the CPU before every run, so the run starts on a fresh "
+     "scheduler time slice")
+    ("prerun_spin", po::value<double>(),
+     "Yield the CPU and then spin for the given number of microseconds "
+     "before every run, so the run starts on a fresh time slice of a CPU "
+     "which is not idle, e.g. --prerun_spin=200")
+    ("summary",
+     po::value<std::vector<std::string> >()->multitoken(),
+     "Add the summary statistics of result columns to the output of the "
+     "file and stdout printers. For each column the count, mean, std_dev, "
+     "cv, median, mad and the 95% confidence intervals of the mean and "
+     "median are added as constant columns named after it, "
+     "e.g. --summary time throughput adds time_mean, time_median, ...")
     ("add_column",
      po::value<std::vector<std::string> >()->multitoken(),
      "Add a column to the test results, this can be used to "
@@ -217,6 +655,122 @@ void runner::run_unsafe(int argc, const char* argv[])
         return;
     }
 
+    if (m_impl->m_options.count("history_query") ||
+        m_impl->m_options.count("history_trend"))
+    {
+        history_store store(
+            m_impl->m_options["history_dir"].as<std::string>());
+        auto column = m_impl->m_options["history_column"].as<std::string>();
+
+        if (m_impl->m_options.count("history_query"))
+        {
+            print_history(std::cout, store.query(
+                m_impl->m_options["history_query"].as<std::string>()),
+                column);
+        }
+
+        if (m_impl->m_options.count("history_trend"))
+        {
+            print_trend(std::cout, store.query(
+                m_impl->m_options["history_trend"].as<std::string>()),
+                column, m_impl->m_options["trend_threshold"].as<double>());
+        }
+        return;
+    }
+
+    // Create the selected clock to check that it is available. This
+    // also runs any calibration needed by the clock and measures its
+    // resolution and read cost before the benchmarks start
+    auto clock = make_clock(m_impl->m_options["clock"].as<std::string>());
+    measure_clock(*clock);
+
+    if (m_impl->m_options.count("min_run_time") &&
+        m_impl->m_options["min_run_time"].as<double>() <= 0)
+    {
+        throw std::runtime_error("Error min_run_time must be positive");
+    }
+
+    if (m_impl->m_options.count("target_rel_ci"))
+    {
+        if (m_impl->m_options["target_rel_ci"].as<double>() <= 0)
+            throw std::runtime_error("Error target_rel_ci must be positive");
+
+        uint32_t min_runs = m_impl->m_options["min_runs"].as<uint32_t>();
+        uint32_t max_runs = m_impl->m_options["max_runs"].as<uint32_t>();
+        if (min_runs < 2 || max_runs < min_runs)
+        {
+            throw std::runtime_error(
+                "Error min_runs must be at least 2 and at most max_runs");
+        }
+
+        auto statistic = m_impl->m_options["target_statistic"]
+                         .as<std::string>();
+        if (statistic != "mean" && statistic != "median")
+        {
+            throw std::runtime_error(
+                "Error target_statistic must be mean or median");
+        }
+    }
+
+    // A previous run of the runner may have thrown inside a benchmark
+    m_impl->m_current_benchmark = benchmark_ptr();
+
+    // A previous run of the runner may have had its own baseline
+    m_impl->m_baseline.clear();
+    m_impl->m_regressions = 0;
+    if (m_impl->m_options.count("baseline"))
+    {
+        if (m_impl->m_options["regression_threshold"].as<double>() < 0)
+        {
+            throw std::runtime_error(
+                "Error regression_threshold must not be negative");
+        }
+
+        m_impl->m_baseline = read_result_file(
+            m_impl->m_options["baseline"].as<std::string>());
+    }
+
+    m_impl->m_thread_counts.clear();
+    if (m_impl->m_options.count("threads"))
+    {
+        m_impl->m_thread_counts =
+            m_impl->m_options["threads"].as<std::vector<uint32_t>>();
+    }
+    else if (m_impl->m_options.count("thread_scaling"))
+    {
+        m_impl->m_thread_counts = scaling_thread_counts(
+            physical_core_count(), (uint32_t)allowed_cpus().size());
+    }
+
+    auto& counts = m_impl->m_thread_counts;
+    if (std::find(counts.begin(), counts.end(), 0U) != counts.end())
+        throw std::runtime_error("Error threads must be positive");
+
+    // A sweep starts with one thread, the reference for the speedup
+    counts = sweep_thread_counts(counts);
+
+    m_impl->m_copies = 0;
+    if (m_impl->m_options.count("copies"))
+    {
+        m_impl->m_copies = m_impl->m_options["copies"].as<uint32_t>();
+        if (m_impl->m_copies == 0)
+            m_impl->m_copies = physical_core_count();
+
+        if (m_impl->m_copies > allowed_cpus().size())
+        {
+            std::cerr << "Warning: there are more copies than CPUs, the "
+                      << "copies will not all run at the same time"
+                      << std::endl;
+        }
+    }
+
+    parse_environment();
+
+    // Check the outlier options before running anything
+    parse_outlier_policy(m_impl->m_options["outliers"].as<std::string>());
+    parse_outlier_method(
+        m_impl->m_options["outlier_method"].as<std::string>());
+
     if (m_impl->m_options.count("add_column"))
     {
         auto v = m_impl->m_options["add_column"].as<
@@ -248,11 +802,38 @@ void runner::run_unsafe(int argc, const char* argv[])
         printer->set_options(m_impl->m_options);
     }
 
+    int32_t printer_cpu = -1;
+    if (m_impl->m_options.count("printer_cpu"))
+        printer_cpu = m_impl->m_options["printer_cpu"].as<int32_t>();
+
+    // The printer thread keeps off the core of the measuring thread. The
+    // copies and the threads of a benchmark may use any CPU, so the
+    // printers finish their work before those are measured.
+    std::vector<uint32_t> avoid;
+    if (m_impl->m_environment_request.m_cpu >= 0)
+        avoid = smt_siblings(m_impl->m_environment_request.m_cpu);
+
+    m_impl->m_pipeline.start(
+        m_impl->m_options["async_printers"].as<bool>(), printer_cpu, avoid);
+    pipeline_stopper stopper(m_impl->m_pipeline);
+
+    // Applied after starting the printer thread, which does not inherit
+    // the scheduling policy then
+    previous_environment previous;
+    m_impl->m_environment =
+        apply_environment(m_impl->m_environment_request, previous);
+    environment_restorer restorer(previous);
+
     // Notify all printers that we are starting
-    for (auto& printer: enabled_printers())
+    auto printers = enabled_printers();
+    m_impl->m_pipeline.post([printers]
     {
-        printer->start();
-    }
+        for (auto& printer: printers)
+        {
+            printer->start();
+        }
+    });
+
     // Check whether we should run all tests or whether we
     // should use a filter
     if (m_impl->m_options.count("gauge_filter"))
@@ -267,9 +848,21 @@ void runner::run_unsafe(int argc, const char* argv[])
     }
 
     // Notify all printers that we are done
-    for (auto& printer: enabled_printers())
+    m_impl->m_pipeline.post([printers]
+    {
+        for (auto& printer: printers)
+        {
+            printer->end();
+        }
+    });
+
+    stopper.stop();
+
+    if (m_impl->m_regressions > 0)
     {
-        printer->end();
+        throw std::runtime_error(
+            "Error " + std::to_string(m_impl->m_regressions) +
+            " benchmark(s) regressed compared to the baseline");
     }
 }
 
@@ -300,6 +893,85 @@ void runner::parse_add_column(const std::string& option)
     m_impl->m_columns[column_name] = column_value;
 }
 
+void runner::parse_environment()
+{
+    // Read before any thread is pinned, see allowed_cpus()
+    auto cpus = allowed_cpus();
+
+    environment_request request;
+
+    if (m_impl->m_options.count("pin_cpu"))
+    {
+        auto cpu = m_impl->m_options["pin_cpu"].as<std::string>();
+        if (cpu == "auto")
+        {
+            request.m_cpu = select_measurement_cpu();
+        }
+        else
+        {
+            try
+            {
+                request.m_cpu = std::stoi(cpu);
+            }
+            catch (const std::exception&)
+            {
+                throw std::runtime_error("Error malformed pin_cpu"
+                                         " (example 3 or auto)");
+            }
+
+            if (request.m_cpu < 0 ||
+                std::find(cpus.begin(), cpus.end(),
+                          (uint32_t)request.m_cpu) == cpus.end())
+            {
+                throw std::runtime_error(
+                    "Error pin_cpu " + cpu + " is not an allowed CPU");
+            }
+        }
+    }
+
+    if (m_impl->m_options.count("sched_fifo"))
+    {
+        request.m_fifo_priority =
+            m_impl->m_options["sched_fifo"].as<int32_t>();
+        if (request.m_fifo_priority < 1 || request.m_fifo_priority > 99)
+            throw std::runtime_error("Error sched_fifo must be from 1 to 99");
+    }
+
+    if (m_impl->m_options.count("nice"))
+    {
+        request.m_set_nice = true;
+        request.m_nice = m_impl->m_options["nice"].as<int32_t>();
+    }
+
+    request.m_lock_memory = m_impl->m_options.count("mlockall") > 0;
+
+    if (m_impl->m_options.count("timer_slack"))
+    {
+        request.m_timer_slack =
+            m_impl->m_options["timer_slack"].as<uint64_t>();
+        if (request.m_timer_slack == 0)
+            throw std::runtime_error("Error timer_slack must be positive");
+    }
+
+    m_impl->m_environment_request = request;
+
+    m_impl->m_prerun_spin = 0;
+    if (m_impl->m_options.count("prerun_spin"))
+    {
+        m_impl->m_prerun_spin =
+            m_impl->m_options["prerun_spin"].as<double>();
+
+        if (m_impl->m_prerun_spin < 0)
+        {
+            throw std::runtime_error(
+                "Error prerun_spin must not be negative");
+        }
+    }
+
+    m_impl->m_fresh_quantum = m_impl->m_options.count("prerun_yield") > 0 ||
+                              m_impl->m_options.count("prerun_spin") > 0;
+}
+
 void runner::run_all()
 {
     assert(m_impl);
@@ -449,13 +1121,269 @@ void runner::run_benchmark_configurations(benchmark_ptr benchmark)
         for (uint32_t i = 0; i < configs; ++i)
         {
             benchmark->set_current_configuration(i);
-            run_benchmark(benchmark);
+            run_benchmark_threads(benchmark);
+            run_benchmark_copies(benchmark);
         }
     }
     else
+    {
+        run_benchmark_threads(benchmark);
+        run_benchmark_copies(benchmark);
+    }
+}
+
+void runner::run_benchmark_threads(benchmark_ptr benchmark)
+{
+    assert(benchmark);
+    assert(m_impl);
+
+    auto threaded = std::dynamic_pointer_cast<thread_benchmark>(benchmark);
+    const auto& counts = m_impl->m_thread_counts;
+
+    if (!threaded || counts.empty())
     {
         run_benchmark(benchmark);
+        return;
+    }
+
+    m_impl->m_reference_rate = -1;
+
+    for (uint32_t threads : counts)
+    {
+        threaded->set_threads(threads);
+        run_benchmark(benchmark);
+    }
+
+    threaded->set_threads(0);
+}
+
+void runner::run_benchmark_copies(benchmark_ptr benchmark)
+{
+    assert(benchmark);
+    assert(m_impl);
+
+    uint32_t count = m_impl->m_copies;
+
+    // Thread benchmarks share their state on purpose, so they are only
+    // run as a single copy
+    if (count == 0 || m_impl->m_options.count("dry_run") ||
+        std::dynamic_pointer_cast<thread_benchmark>(benchmark))
+    {
+        return;
+    }
+
+    // Every copy is a new object made by the benchmark's factory
+    uint32_t id = m_impl->m_testcases[benchmark->testcase_name()]
+                  [benchmark->benchmark_name()];
+    auto& make = m_impl->m_benchmarks[id];
+
+    std::vector<benchmark_ptr> copies;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto copy = make();
+        assert(copy);
+
+        copy->get_options(m_impl->m_options);
+        if (copy->has_configurations())
+        {
+            copy->set_current_configuration(
+                benchmark->current_configuration());
+        }
+
+        if (copy->skip())
+            return;
+
+        copies.push_back(copy);
     }
+
+    uint32_t runs = m_impl->m_options.count("runs") ?
+                    m_impl->m_options["runs"].as<uint32_t>() :
+                    benchmark->runs();
+    assert(runs > 0);
+
+    start_benchmark();
+
+    // The copies may run on the CPU of the printer thread
+    m_impl->m_pipeline.wait();
+
+    std::vector<tables::table> tables(count);
+    measure_copies(copies, runs, tables);
+
+    tables::table results;
+    for (const auto& o : m_impl->m_columns)
+    {
+        results.add_const_column(o.first, o.second);
+    }
+
+    results.add_const_column("unit", benchmark->unit_text());
+    results.add_const_column("benchmark", benchmark->benchmark_name());
+    results.add_const_column("testcase", benchmark->testcase_name());
+    results.add_const_column("copies", count);
+
+    for (const auto& t : tables)
+        results.merge(t);
+
+    tag_runs(results);
+    auto excluded = excluded_rows(results);
+
+    // The median time of every copy, the rows of a copy are those of its
+    // table in the merged results
+    std::vector<double> times;
+    uint64_t first = 0;
+    for (const auto& t : tables)
+    {
+        std::vector<bool> copy_excluded(
+            excluded.begin() + first, excluded.begin() + first + t.rows());
+        first += t.rows();
+
+        std::vector<double> values = column_values(t, "time", copy_excluded);
+        if (!values.empty())
+            times.push_back(median(values));
+    }
+
+    copy_rate rate;
+    if (calculate_copy_rate(times, m_impl->m_single_copy_time, rate))
+    {
+        results.add_const_column("rate", rate.m_rate);
+
+        if (rate.m_has_single)
+        {
+            results.add_const_column("rate_single", rate.m_rate_single);
+            results.add_const_column("degradation", rate.m_degradation);
+            results.add_const_column("degradation_max",
+                                     rate.m_degradation_max);
+        }
+    }
+
+    publish_results(*benchmark, results, excluded);
+}
+
+void runner::measure_copies(const std::vector<benchmark_ptr>& copies,
+                            uint32_t runs, std::vector<tables::table>& tables)
+{
+    assert(!copies.empty());
+    assert(copies.size() == tables.size());
+
+    uint32_t count = (uint32_t)copies.size();
+    auto cpus = cpu_order();
+
+    // The copies measure in rounds started together, until every copy
+    // has its runs. A copy which is done keeps running its body, so the
+    // others are measured under the same load.
+    std::atomic<uint32_t> remaining(count);
+    bool done = false;
+    spin_barrier barrier(count, [&] { done = remaining.load() == 0; });
+
+    std::mutex init_mutex;
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        workers.emplace_back([&, i]
+        {
+            // The copies spin on every CPU, so they must not inherit a
+            // real-time policy from the measuring thread with which they
+            // could starve the rest of the system
+            pin_thread(cpus[i % cpus.size()]);
+            reset_scheduling();
+
+            auto& copy = copies[i];
+            auto& results = tables[i];
+            set_thread_benchmark(copy);
+
+            bool failed = false;
+            uint32_t run = 0;
+
+            try
+            {
+                // The clock and overhead calibrations are shared, and
+                // were mostly done by the single copy already
+                {
+                    std::lock_guard<std::mutex> lock(init_mutex);
+                    copy->init();
+                }
+
+                if (copy->needs_warmup_iteration())
+                {
+                    copy->setup();
+                    copy->test_body();
+                    copy->tear_down();
+                }
+
+                results.add_column("iterations");
+                results.add_column("run_number");
+                results.add_column("copy");
+                copy->prepare_table(results);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+
+                failed = true;
+                --remaining;
+            }
+
+            for (;;)
+            {
+                barrier.wait();
+                if (done)
+                    break;
+
+                // A failed copy still takes part in the rounds
+                if (failed)
+                    continue;
+
+                try
+                {
+                    copy->reset_counters();
+                    copy->setup();
+                    copy->test_body();
+                    copy->tear_down();
+
+                    uint64_t iterations =
+                        copy->run_iterations() * copy->batch_size();
+
+                    if (copy->accept_measurement() && run < runs)
+                    {
+                        results.add_row();
+                        results.set_value("iterations", iterations);
+                        results.set_value("run_number", run);
+                        results.set_value("copy", i);
+                        copy->store_run(results);
+                        copy->store_counters(results, iterations);
+
+                        if (++run == runs)
+                            --remaining;
+                    }
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error)
+                        error = std::current_exception();
+
+                    failed = true;
+                    if (run < runs)
+                        --remaining;
+                }
+            }
+
+            set_thread_benchmark(benchmark_ptr());
+        });
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    if (error)
+        std::rethrow_exception(error);
+
+    for (uint32_t i = 0; i < count; ++i)
+        copies[i]->finish_table(tables[i]);
 }
 
 void runner::run_benchmark(benchmark_ptr benchmark)
@@ -470,6 +1398,7 @@ void runner::run_benchmark(benchmark_ptr benchmark)
 
     assert(!m_impl->m_current_benchmark);
     m_impl->m_current_benchmark = benchmark;
+    m_impl->m_single_copy_time = -1;
 
     if (m_impl->m_current_benchmark->skip())
     {
@@ -497,6 +1426,26 @@ void runner::run_benchmark(benchmark_ptr benchmark)
         runs = benchmark->runs();
     }
 
+    // With a target confidence interval the runs continue until it is
+    // met, so the run count is just the upper bound
+    bool adaptive = m_impl->m_options.count("target_rel_ci") > 0;
+    double target_rel_ci = 0;
+    uint32_t min_runs = 0;
+    uint32_t fixed_runs = runs;
+
+    if (adaptive)
+    {
+        target_rel_ci = m_impl->m_options["target_rel_ci"].as<double>();
+        min_runs = m_impl->m_options["min_runs"].as<uint32_t>();
+        runs = m_impl->m_options["max_runs"].as<uint32_t>();
+    }
+
+    std::string target_column =
+        m_impl->m_options["target_column"].as<std::string>();
+    bool target_median =
+        m_impl->m_options["target_statistic"].as<std::string>() == "median";
+    double rel_ci = -1;
+
     tables::table results;
     results.reserve(runs);
 
@@ -509,35 +1458,321 @@ void runner::run_benchmark(benchmark_ptr benchmark)
     results.add_const_column("benchmark", benchmark->benchmark_name());
     results.add_const_column("testcase", benchmark->testcase_name());
 
+    store_environment(results, m_impl->m_environment_request,
+                      m_impl->m_environment);
+
     results.add_column("iterations");
     results.add_column("run_number");
 
     benchmark->prepare_table(results);
 
-    for (auto& printer: enabled_printers())
-    {
-        printer->start_benchmark();
-    }
+    start_benchmark();
 
     assert(runs > 0);
     uint32_t run = 0;
 
+    // The body of a thread benchmark runs on its own threads while this
+    // thread waits, so its resources are those of the whole process and
+    // the run quality of this thread says nothing about the run
+    bool threaded =
+        std::dynamic_pointer_cast<thread_benchmark>(benchmark) != nullptr;
+
+    // The threads may run on the CPU of the printer thread
+    if (threaded)
+        m_impl->m_pipeline.wait();
+
+    bool track_resources = m_impl->m_options.count("resource_usage") > 0;
+    resource_usage usage_before;
+    resource_usage usage_after;
+
+    noise_limits limits = parse_noise_limits(m_impl->m_options);
+    bool check_noise = !threaded &&
+                       (m_impl->m_options.count("run_quality") > 0 ||
+                        limits.m_max_switches >= 0 ||
+                        limits.m_max_interrupts >= 0 ||
+                        limits.m_max_frequency_change >= 0 ||
+                        limits.m_reject_migrations);
+
+    uint32_t max_retries = m_impl->m_options["max_retries"].as<uint32_t>();
+    uint32_t retries = 0;
+    uint32_t rejected = 0;
+
+    run_snapshot noise_before;
+    run_snapshot noise_after;
+
     while (run < runs)
     {
+        benchmark->reset_counters();
         benchmark->setup();
+
+        // The yield and the spin come before the snapshots. A yield which
+        // switches away leaves the thread runnable and is counted as an
+        // involuntary context switch, and the CPU time of the spin is not
+        // part of the run.
+        if (m_impl->m_fresh_quantum)
+        {
+            start_fresh_quantum();
+            spin_cpu(m_impl->m_prerun_spin);
+        }
+
+        // Only the test body is covered, not the setup and tear down
+        bool has_noise = false;
+        if (check_noise)
+            has_noise = take_run_snapshot(noise_before);
+
+        bool has_usage = false;
+        if (track_resources)
+        {
+            reset_peak_rss();
+            has_usage = read_resource_usage(usage_before, threaded);
+        }
+
         benchmark->test_body();
+
+        if (has_usage)
+            has_usage = read_resource_usage(usage_after, threaded);
+
+        if (has_noise)
+            has_noise = take_run_snapshot(noise_after);
+
         benchmark->tear_down();
 
+        // With RUN_BATCH every iteration runs the body a number of times
+        // and with threads every thread runs all the iterations, we
+        // report the number of times the body was run. Accepting the
+        // measurement may adjust the iteration count for the next run,
+        // so the count is the one of the measured run.
+        uint64_t iterations = benchmark->run_iterations() *
+                              benchmark->batch_size() * benchmark->threads();
+
         if (benchmark->accept_measurement())
         {
+            run_noise noise;
+            if (has_noise)
+            {
+                noise = compare_run_snapshots(noise_before, noise_after);
+
+                // A run disturbed by the machine is run again, unless the
+                // machine is so noisy that we would never finish
+                if (is_noisy(noise, limits) && retries < max_retries)
+                {
+                    ++retries;
+                    ++rejected;
+                    continue;
+                }
+            }
+
+            retries = 0;
+
             results.add_row();
-            results.set_value("iterations", benchmark->iteration_count());
+            results.set_value("iterations", iterations);
+
+            if (benchmark->batch_size() > 1 &&
+                !results.has_column("batch_size"))
+            {
+                results.add_const_column("batch_size",
+                                         benchmark->batch_size());
+            }
+
             results.set_value("run_number", run);
             benchmark->store_run(results);
+            benchmark->store_counters(results, iterations);
+
+            if (has_usage)
+                store_resource_usage(results, usage_before, usage_after);
+
+            if (has_noise)
+            {
+                bool has_frequency = noise_before.m_frequency > 0 &&
+                                     noise_after.m_frequency > 0;
+                store_run_noise(results, noise, has_frequency);
+            }
             ++run;
+
+            if (adaptive && run >= min_runs)
+            {
+                rel_ci = relative_confidence_interval(
+                    results, target_column, target_median,
+                    excluded_rows(results));
+
+                if (rel_ci >= 0 && rel_ci <= target_rel_ci)
+                    break;
+
+                // Without the target column we fall back to the fixed
+                // number of runs
+                if (rel_ci < 0 && run >= fixed_runs)
+                    break;
+            }
         }
     }
 
+    benchmark->finish_table(results);
+
+    if (adaptive)
+    {
+        results.add_const_column("target_rel_ci", target_rel_ci);
+        if (rel_ci >= 0)
+            results.add_const_column("rel_ci", rel_ci);
+    }
+
+    if (check_noise)
+        results.add_const_column("rejected_runs", rejected);
+
+    tag_runs(results);
+    auto excluded = excluded_rows(results);
+
+    if (m_impl->m_thread_counts.size() > 1 && results.has_column("threads"))
+        store_speedup(*benchmark, results, excluded);
+
+    // The single copy is the reference of the rate mode. It is marked as
+    // one copy, so it is compared with the single copy of the baseline
+    // and not with the copies.
+    if (m_impl->m_copies > 0)
+    {
+        results.add_const_column("copies", uint32_t(1));
+
+        std::vector<double> times = column_values(results, "time", excluded);
+        if (!times.empty())
+            m_impl->m_single_copy_time = median(times);
+    }
+
+    publish_results(*benchmark, results, excluded);
+
+    m_impl->m_current_benchmark = benchmark_ptr();
+}
+
+void runner::start_benchmark()
+{
+    m_impl->m_benchmark_start = std::chrono::high_resolution_clock::now();
+
+    // Posted like every other call of the printers, so they are all made
+    // on the printer thread in order
+    auto printers = enabled_printers();
+    m_impl->m_pipeline.post([printers]
+    {
+        for (auto& printer: printers)
+        {
+            printer->start_benchmark();
+        }
+    });
+}
+
+void runner::tag_runs(tables::table& results) const
+{
+    auto policy = parse_outlier_policy(
+        m_impl->m_options["outliers"].as<std::string>());
+
+    if (policy == outlier_policy::keep)
+        return;
+
+    tag_outliers(results,
+                 m_impl->m_options["outlier_column"].as<std::string>(),
+                 parse_outlier_method(
+                     m_impl->m_options["outlier_method"].as<std::string>()));
+}
+
+std::vector<bool> runner::excluded_rows(const tables::table& results) const
+{
+    std::vector<bool> excluded(results.rows(), false);
+
+    auto policy = parse_outlier_policy(
+        m_impl->m_options["outliers"].as<std::string>());
+
+    if (policy != outlier_policy::exclude)
+        return excluded;
+
+    if (results.has_column("outlier"))
+        return outlier_rows(results);
+
+    // The runs are not tagged yet, e.g. while checking the confidence
+    // interval
+    std::vector<std::string> classes;
+    if (!classify_rows(results,
+                       m_impl->m_options["outlier_column"].as<std::string>(),
+                       parse_outlier_method(
+                           m_impl->m_options["outlier_method"]
+                           .as<std::string>()),
+                       classes))
+    {
+        return excluded;
+    }
+
+    for (uint64_t row = 0; row < classes.size(); ++row)
+        excluded[row] = !classes[row].empty();
+
+    return excluded;
+}
+
+void runner::compare_baseline(const benchmark& info, tables::table& results,
+                              const std::vector<bool>& excluded)
+{
+    auto column = m_impl->m_options["baseline_column"].as<std::string>();
+
+    if (!results.has_column(column) || !results.is_column<double>(column))
+        return;
+
+    result_row key;
+    key["testcase"] = info.testcase_name();
+    key["benchmark"] = info.benchmark_name();
+
+    if (info.has_configurations())
+    {
+        tables::format f;
+        for (const auto& v : info.get_current_configuration())
+        {
+            std::ostringstream value;
+            f.print(value, v.second);
+            key[v.first] = value.str();
+        }
+    }
+
+    // The steps of a thread scaling sweep and the rate mode are
+    // compared separately
+    if (results.has_column("threads"))
+        key["threads"] = std::to_string(info.threads());
+
+    if (results.has_column("copies"))
+    {
+        key["copies"] = std::to_string(
+            results.values_as<uint32_t>("copies").front());
+    }
+
+    auto baseline = baseline_values(m_impl->m_baseline, key, column);
+
+    std::vector<double> current = column_values(results, column, excluded);
+
+    if (baseline.empty() || current.empty())
+        return;
+
+    comparison c = compare_samples(baseline, current);
+
+    double threshold = info.regression_threshold();
+    if (threshold < 0)
+        threshold = m_impl->m_options["regression_threshold"].as<double>();
+
+    bool significant =
+        c.m_p_value < m_impl->m_options["significance"].as<double>();
+
+    std::string verdict = "unchanged";
+    if (significant && c.m_ratio > 1.0 + threshold)
+        verdict = "regressed";
+    else if (significant && c.m_ratio < 1.0 / (1.0 + threshold))
+        verdict = "improved";
+
+    if (verdict == "regressed")
+        ++m_impl->m_regressions;
+
+    results.add_const_column("baseline_ratio", c.m_ratio);
+    results.add_const_column("baseline_p_value", c.m_p_value);
+    results.add_const_column("baseline_verdict", verdict);
+}
+
+void runner::publish_results(const benchmark& info, tables::table& results,
+                             const std::vector<bool>& excluded)
+{
+    if (m_impl->m_options.count("baseline"))
+        compare_baseline(info, results, excluded);
+
     // Clean out unwanted results
     if (m_impl->m_options.count("result_filter"))
     {
@@ -553,18 +1788,66 @@ void runner::run_benchmark(benchmark_ptr benchmark)
         }
     }
 
-    // Notify all printers that we are done
-    for (auto& printer: enabled_printers())
+    auto stop = std::chrono::high_resolution_clock::now();
+    double duration = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            stop - m_impl->m_benchmark_start).count());
+
+    if (info.has_configurations())
     {
-        printer->end_benchmark();
+        for (const auto& v : info.get_current_configuration())
+        {
+            results.add_const_column(v.first, v.second);
+        }
     }
 
-    for (auto& printer: enabled_printers())
+    // The results are published once to all printers, which may run on
+    // the printer thread while the next benchmark is measured
+    auto snapshot = std::make_shared<const benchmark_snapshot>(
+        info, results, duration);
+    auto shared = std::make_shared<const tables::table>(std::move(results));
+    auto printers = enabled_printers();
+
+    m_impl->m_pipeline.post([printers, snapshot, shared]
     {
-        printer->benchmark_result(*benchmark, results);
-    }
+        // Notify all printers that we are done
+        for (auto& printer: printers)
+        {
+            printer->end_benchmark();
+        }
 
-    m_impl->m_current_benchmark = benchmark_ptr();
+        for (auto& printer: printers)
+        {
+            printer->shared_benchmark_result(*snapshot, shared);
+        }
+    });
+
+}
+
+void runner::store_speedup(const benchmark& info, tables::table& results,
+                           const std::vector<bool>& excluded)
+{
+    std::vector<double> rates =
+        column_values(results, "iterations_per_second", excluded);
+
+    if (rates.empty())
+        return;
+
+    double rate = median(rates);
+    uint32_t threads = info.threads();
+
+    if (threads == 1)
+        m_impl->m_reference_rate = rate;
+
+    speedup scaling;
+    if (!calculate_speedup(rate, m_impl->m_reference_rate, threads, scaling))
+        return;
+
+    results.add_const_column("speedup", scaling.m_speedup);
+    results.add_const_column("efficiency", scaling.m_parallel_efficiency);
+
+    if (scaling.m_has_serial_fraction)
+        results.add_const_column("serial_fraction", scaling.m_serial_fraction);
 }
 
 std::vector<runner::printer_ptr> runner::enabled_printers() const
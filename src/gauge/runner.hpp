@@ -84,9 +84,19 @@ public:
                        std::string testcase_name,
                        std::string benchmark_name);
 
+    /// @return the parsed program options
+    const po::variables_map& options() const;
+
     /// Returns the id of the currently active benchmark
     /// @return id of benchmark
-    benchmark_ptr current_benchmark();
+    const benchmark_ptr& current_benchmark();
+
+    /// Binds a benchmark to the calling thread. The RUN loops on the
+    /// thread then control it instead of the current benchmark, this is
+    /// how every thread of a thread_benchmark gets a timer of its own.
+    /// @param benchmark The benchmark, an empty pointer removes the
+    ///        binding
+    static void set_thread_benchmark(const benchmark_ptr& benchmark);
 
     /// Start a new benchmark runner using the commandline
     /// parameters specified. Exceptions are not handled.
@@ -119,6 +129,25 @@ public:
     /// configurations
     void run_benchmark_configurations(benchmark_ptr bench);
 
+    /// Runs the specified benchmark with the thread counts set with the
+    /// --threads or --thread_scaling options if it is a thread_benchmark,
+    /// otherwise just once
+    void run_benchmark_threads(benchmark_ptr bench);
+
+    /// Runs the rate mode of a benchmark enabled with the --copies
+    /// option: independent copies of the benchmark made by its factory
+    /// run at the same time, pinned one per physical core. Does nothing
+    /// without the option and for thread benchmarks.
+    void run_benchmark_copies(benchmark_ptr bench);
+
+    /// Measures the copies of a benchmark at the same time, each on a
+    /// thread of its own
+    /// @param copies The copies
+    /// @param runs The number of runs of every copy
+    /// @param tables The results of every copy
+    void measure_copies(const std::vector<benchmark_ptr>& copies,
+                        uint32_t runs, std::vector<tables::table>& tables);
+
     /// @return access to the runners printers
     std::vector<printer_ptr>& printers();
 
@@ -126,10 +155,56 @@ public:
     std::vector<printer_ptr> enabled_printers() const;
 
 
+    /// Takes the start time of a benchmark and notifies the printers
+    /// that it is started
+    void start_benchmark();
+
+    /// Tags the outlying runs in the "outlier" column unless the
+    /// --outliers option is keep
+    /// @param results The results of the benchmark
+    void tag_runs(tables::table& results) const;
+
+    /// @param results The results of the benchmark
+    /// @return true for every run left out of the statistics by
+    ///         --outliers=exclude. Untagged runs are classified without
+    ///         tagging them.
+    std::vector<bool> excluded_rows(const tables::table& results) const;
+
+    /// Compares the results of a benchmark with the --baseline results
+    /// and stores the outcome in constant columns
+    /// @param info The benchmark
+    /// @param results The results of the benchmark
+    /// @param excluded The runs left out of the comparison
+    void compare_baseline(const benchmark& info, tables::table& results,
+                          const std::vector<bool>& excluded);
+
+    /// Compares with the baseline, drops the filtered columns and
+    /// publishes the results of a benchmark to the printers
+    /// @param info The benchmark
+    /// @param results The results of the benchmark, moved to the printers
+    /// @param excluded The runs left out of the statistics
+    void publish_results(const benchmark& info, tables::table& results,
+                         const std::vector<bool>& excluded);
+
+    /// Stores the speedup, parallel efficiency and serial fraction of a
+    /// step of a thread scaling sweep in constant columns. The speedup
+    /// is the median rate of the body relative to the one with one
+    /// thread.
+    /// @param info The benchmark
+    /// @param results The results of the benchmark
+    /// @param excluded The runs left out of the median
+    void store_speedup(const benchmark& info, tables::table& results,
+                       const std::vector<bool>& excluded);
+
     /// Parse the add_column options
     /// @param column Value from the input options
     void parse_add_column(const std::string& option);
 
+    /// Parse the options of the execution environment of the measuring
+    /// thread, --pin_cpu, --sched_fifo, --nice, --mlockall, --timer_slack
+    /// and the pre-run yield and spin
+    void parse_environment();
+
 private:
 
     struct impl;
@@ -0,0 +1,48 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "speedup.hpp"
+
+namespace gauge
+{
+bool calculate_speedup(double rate, double reference_rate, uint32_t threads,
+                       speedup& result)
+{
+    assert(threads > 0);
+
+    if (reference_rate <= 0)
+        return false;
+
+    result.m_speedup = rate / reference_rate;
+    result.m_parallel_efficiency = result.m_speedup / threads;
+
+    result.m_has_serial_fraction = threads > 1 && result.m_speedup > 0;
+    result.m_serial_fraction = 0;
+
+    if (result.m_has_serial_fraction)
+    {
+        double p = threads;
+        result.m_serial_fraction =
+            (1.0 / result.m_speedup - 1.0 / p) / (1.0 - 1.0 / p);
+    }
+
+    return true;
+}
+
+std::vector<uint32_t> sweep_thread_counts(std::vector<uint32_t> counts)
+{
+    if (counts.size() > 1)
+        counts.push_back(1);
+
+    std::sort(counts.begin(), counts.end());
+    counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+    return counts;
+}
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace gauge
+{
+/// The parallel scaling of a benchmark run with several threads
+/// relative to the run with one thread
+struct speedup
+{
+    /// The rate relative to the rate with one thread
+    double m_speedup;
+
+    /// The speedup per thread, one for perfect scaling
+    double m_parallel_efficiency;
+
+    /// True if the serial fraction could be estimated, which takes more
+    /// than one thread and a positive speedup
+    bool m_has_serial_fraction;
+
+    /// The Karp-Flatt metric: the serial fraction of the work estimated
+    /// from the speedup. A fraction growing with the threads points to
+    /// overhead such as contention rather than serial code.
+    double m_serial_fraction;
+};
+
+/// Calculates the scaling of a step of a thread sweep
+/// @param rate The rate with the given number of threads
+/// @param reference_rate The rate with one thread
+/// @param threads The number of threads
+/// @param result The calculated scaling
+/// @return true if the scaling could be calculated i.e. the reference
+///         rate is positive
+bool calculate_speedup(double rate, double reference_rate, uint32_t threads,
+                       speedup& result);
+
+/// @param counts The thread counts given for a sweep
+/// @return the sorted thread counts without duplicates. A sweep of more
+///         than one count also runs with one thread, the reference of
+///         the speedup.
+std::vector<uint32_t> sweep_thread_counts(std::vector<uint32_t> counts);
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace gauge
+{
+/// Barrier on which the waiting threads spin instead of sleeping, so they
+/// are all released within a few cycles of each other. When there are
+/// more threads than CPUs the threads yield while spinning, so the
+/// threads which have not arrived yet still get to run.
+///
+/// The barrier can be reused, each time all threads have arrived a new
+/// phase starts.
+class spin_barrier
+{
+public:
+
+    /// The number of spins before a waiting thread starts yielding
+    static const uint32_t yield_spins = 1000;
+
+public:
+
+    /// Constructor
+    /// @param count The number of threads which must arrive
+    /// @param completion Called by the last thread to arrive, before any
+    ///        of the threads are released
+    explicit spin_barrier(uint32_t count,
+                          std::function<void()> completion = nullptr) :
+        m_count(count),
+        m_completion(std::move(completion)),
+        m_arrived(0),
+        m_phase(0)
+    {
+        assert(m_count > 0);
+    }
+
+    /// Waits until all the threads have arrived
+    void wait()
+    {
+        uint32_t phase = m_phase.load(std::memory_order_acquire);
+
+        if (m_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_count)
+        {
+            if (m_completion)
+                m_completion();
+
+            m_arrived.store(0, std::memory_order_relaxed);
+            m_phase.store(phase + 1, std::memory_order_release);
+            return;
+        }
+
+        uint32_t spins = 0;
+        while (m_phase.load(std::memory_order_acquire) == phase)
+        {
+            if (spins < yield_spins)
+                ++spins;
+            else
+                std::this_thread::yield();
+        }
+    }
+
+private:
+
+    /// The number of threads which must arrive
+    const uint32_t m_count;
+
+    /// Called when all threads have arrived
+    std::function<void()> m_completion;
+
+    /// The number of threads which have arrived in the current phase
+    std::atomic<uint32_t> m_arrived;
+
+    /// Incremented when all threads have arrived
+    std::atomic<uint32_t> m_phase;
+};
+}
@@ -6,7 +6,15 @@
 #pragma once
 
 #include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
 #include <numeric>
+#include <typeinfo>
+#include <vector>
+
+#include <boost/any.hpp>
 
 namespace gauge
 {
@@ -14,6 +22,9 @@ namespace gauge
 /// result
 struct statistics
 {
+    /// The number of values
+    uint64_t m_count;
+
     /// The mean value
     double m_mean;
 
@@ -23,8 +34,30 @@ struct statistics
     /// The minimum value observed
     double m_min;
 
-    /// The standard deviation
+    /// The sample standard deviation
     double m_std_dev;
+
+    /// The median value
+    double m_median;
+
+    /// The median absolute deviation from the median
+    double m_mad;
+
+    /// The coefficient of variation i.e. the standard deviation
+    /// relative to the mean
+    double m_cv;
+
+    /// The lower bound of the 95% confidence interval of the mean
+    double m_mean_ci_low;
+
+    /// The upper bound of the 95% confidence interval of the mean
+    double m_mean_ci_high;
+
+    /// The lower bound of the 95% confidence interval of the median
+    double m_median_ci_low;
+
+    /// The upper bound of the 95% confidence interval of the median
+    double m_median_ci_high;
 };
 
 /// Calculates the mean of a sequence
@@ -37,24 +70,225 @@ double mean(Iterator begin, Iterator end)
     return std::accumulate(begin, end, 0.0) / size;
 }
 
-/// Calculate the statistics of a sequence
+/// Running mean and variance using Welford's algorithm, which does
+/// not lose precision when the values are large compared to their
+/// spread.
+class running_statistics
+{
+public:
+
+    /// Creates an empty accumulator
+    running_statistics() :
+        m_count(0),
+        m_mean(0),
+        m_m2(0),
+        m_min(0),
+        m_max(0)
+    { }
+
+    /// Adds a value
+    void add(double value)
+    {
+        ++m_count;
+
+        double delta = value - m_mean;
+        m_mean += delta / m_count;
+        m_m2 += delta * (value - m_mean);
+
+        if (m_count == 1 || value < m_min)
+            m_min = value;
+        if (m_count == 1 || value > m_max)
+            m_max = value;
+    }
+
+    /// @return the number of values added
+    uint64_t count() const
+    {
+        return m_count;
+    }
+
+    /// @return the mean of the values added
+    double mean() const
+    {
+        return m_mean;
+    }
+
+    /// @return the sample variance of the values added
+    double variance() const
+    {
+        return m_count > 1 ? m_m2 / (m_count - 1) : 0.0;
+    }
+
+    /// @return the smallest value added
+    double min() const
+    {
+        return m_min;
+    }
+
+    /// @return the largest value added
+    double max() const
+    {
+        return m_max;
+    }
+
+private:
+
+    uint64_t m_count;
+    double m_mean;
+    double m_m2;
+    double m_min;
+    double m_max;
+};
+
+/// Selects the value of the given rank as if the values were sorted.
+/// The values are partially reordered.
+/// @param values The values
+/// @param rank The zero based rank
+inline double nth_value(std::vector<double>& values, uint64_t rank)
+{
+    assert(rank < values.size());
+
+    auto nth = values.begin() + rank;
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+/// Calculates a quantile interpolating linearly between the closest
+/// ranks. The values are partially reordered.
+/// @param values The values
+/// @param q The quantile in the range [0, 1] e.g. 0.5 for the median
+inline double quantile(std::vector<double>& values, double q)
+{
+    assert(!values.empty());
+    assert(q >= 0.0 && q <= 1.0);
+
+    double position = q * (values.size() - 1);
+    uint64_t rank = static_cast<uint64_t>(position);
+    double fraction = position - rank;
+
+    double lower = nth_value(values, rank);
+    if (fraction == 0.0)
+        return lower;
+
+    // After the selection the next rank is the smallest value above
+    double upper = *std::min_element(values.begin() + rank + 1, values.end());
+    return lower + fraction * (upper - lower);
+}
+
+/// @return the median of the values. The values are partially
+///         reordered.
+inline double median(std::vector<double>& values)
+{
+    return quantile(values, 0.5);
+}
+
+/// @return the two-sided 95% critical value of Student's
+///         t-distribution for the degrees of freedom
+inline double t_critical_95(uint64_t degrees_of_freedom)
+{
+    assert(degrees_of_freedom > 0);
+
+    static const double table[] =
+    {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+        2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101,
+        2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052,
+        2.048, 2.045, 2.042
+    };
+
+    const uint64_t size = sizeof(table) / sizeof(table[0]);
+    if (degrees_of_freedom <= size)
+        return table[degrees_of_freedom - 1];
+
+    // Cornish-Fisher expansion around the normal quantile
+    const double z = 1.959964;
+    double n = static_cast<double>(degrees_of_freedom);
+    return z + (z * z * z + z) / (4 * n) +
+           (5 * std::pow(z, 5) + 16 * z * z * z + 3 * z) / (96 * n * n);
+}
+
+/// Calculate the statistics of a sequence.
+///
+/// The mean, variance, minimum and maximum are found in a single
+/// pass, the median, MAD and the confidence interval of the median
+/// by selection on a copy of the values, so no full sort is needed.
+/// The confidence interval of the mean is t-based, the one of the
+/// median uses the distribution-free order statistics.
 template<class Iterator>
 statistics calculate_statistics(Iterator begin, Iterator end)
 {
+    assert(begin != end);
+
+    std::vector<double> values;
+    values.reserve(std::distance(begin, end));
+
+    running_statistics running;
+    for (Iterator it = begin; it != end; ++it)
+    {
+        // @todo do we have an issues with overflows here
+        double value = static_cast<double>(*it);
+        running.add(value);
+        values.push_back(value);
+    }
+
     statistics s;
-    s.m_mean = mean(begin, end);
+    s.m_count = running.count();
+    s.m_mean = running.mean();
+    s.m_max = running.max();
+    s.m_min = running.min();
+    s.m_std_dev = std::sqrt(running.variance());
+    s.m_cv = s.m_mean != 0 ? s.m_std_dev / std::fabs(s.m_mean) : 0.0;
+
+    if (s.m_count > 1)
+    {
+        double error = t_critical_95(s.m_count - 1) * s.m_std_dev /
+                       std::sqrt(static_cast<double>(s.m_count));
+        s.m_mean_ci_low = s.m_mean - error;
+        s.m_mean_ci_high = s.m_mean + error;
+    }
+    else
+    {
+        s.m_mean_ci_low = s.m_mean;
+        s.m_mean_ci_high = s.m_mean;
+    }
 
-    typename Iterator::value_type max =
-        *std::max_element(begin, end);
+    s.m_median = median(values);
 
-    typename Iterator::value_type min =
-        *std::min_element(begin, end);
+    // The ranks bounding the median with 95% confidence follow from
+    // the normal approximation of the binomial distribution
+    double n = static_cast<double>(s.m_count);
+    double spread = 1.959964 * std::sqrt(n) / 2.0;
+    double low = std::floor(n / 2.0 - spread) - 1;
+    double high = std::ceil(n / 2.0 + spread);
 
-    // @todo do we have an issues with overflows here
-    s.m_max = static_cast<double>(max);
-    s.m_min = static_cast<double>(min);
+    s.m_median_ci_low = low > 0 ?
+        nth_value(values, static_cast<uint64_t>(low)) : s.m_min;
+    s.m_median_ci_high = high < n - 1 ?
+        nth_value(values, static_cast<uint64_t>(high)) : s.m_max;
+
+    for (auto& v : values)
+        v = std::fabs(v - s.m_median);
+
+    s.m_mad = median(values);
 
-    s.m_std_dev = 0;
     return s;
 }
+
+/// Converts a value of a numeric result column to a double
+/// @param value The value
+/// @param result Set to the value as a double
+/// @return false if the value is not a double, uint64_t or uint32_t
+inline bool numeric_value(const boost::any& value, double& result)
+{
+    if (value.type() == typeid(double))
+        result = boost::any_cast<double>(value);
+    else if (value.type() == typeid(uint64_t))
+        result = static_cast<double>(boost::any_cast<uint64_t>(value));
+    else if (value.type() == typeid(uint32_t))
+        result = boost::any_cast<uint32_t>(value);
+    else
+        return false;
+
+    return true;
+}
 }
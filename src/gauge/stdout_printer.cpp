@@ -38,16 +38,15 @@ stdout_printer::stdout_printer() :
 void stdout_printer::benchmark_result(const benchmark& info,
                                       const tables::table& results)
 {
-    tables::table output = results;
-    if (info.has_configurations())
-    {
-        const auto& c = info.get_current_configuration();
-        for (const auto& v : c)
-        {
-            output.add_const_column(v.first, v.second);
-        }
-    }
-    m_tables.insert(m_tables.end(), output);
+    shared_benchmark_result(
+        info, std::make_shared<const tables::table>(results));
+}
+
+void stdout_printer::shared_benchmark_result(
+    const benchmark& /*info*/,
+    const std::shared_ptr<const tables::table>& results)
+{
+    m_tables.push_back(with_summary(results));
 }
 
 void stdout_printer::end()
@@ -55,7 +54,22 @@ void stdout_printer::end()
     // Add newlines on each sides of the outputtet results to ease
     // the process of parsing it.
     std::cout << std::endl;
-    m_formatters.at(m_format_key)->print(std::cout, m_tables);
+    const auto& format = *m_formatters.at(m_format_key);
+
+    // The csv tables are merged into one with a single header, the
+    // others form a list
+    if (m_format_key == "csv")
+    {
+        tables::table combined_results;
+        for (const auto& t : m_tables)
+            combined_results.merge(*t);
+
+        format.print(std::cout, combined_results);
+    }
+    else
+    {
+        print_list(std::cout, format, m_tables);
+    }
     std::cout << std::endl;
 }
 
@@ -11,6 +11,7 @@
 #include <boost/program_options.hpp>
 
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -39,6 +40,11 @@ public:
     void benchmark_result(const benchmark& info,
                           const tables::table& results);
 
+    /// @see printer::shared_benchmark_result()
+    void shared_benchmark_result(
+        const benchmark& info,
+        const std::shared_ptr<const tables::table>& results);
+
     /// @see printer::end()
     void end();
 
@@ -56,7 +62,7 @@ private:
     /// The available formatters
     formatter_map m_formatters;
 
-    /// The output tables
-    std::vector<tables::table> m_tables;
+    /// The output tables, shared with the other printers
+    std::vector<std::shared_ptr<const tables::table>> m_tables;
 };
 }
@@ -0,0 +1,169 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+
+#include "file_sync.hpp"
+#include "runner.hpp"
+#include "stream_printer.hpp"
+
+namespace gauge
+{
+namespace
+{
+template<class T>
+bool print_as(std::ostream& out, const boost::any& value)
+{
+    if (value.type() != typeid(T))
+        return false;
+
+    out << boost::any_cast<T>(value);
+    return true;
+}
+}
+
+stream_printer::stream_printer(const std::string& name,
+                               const std::string& default_filename) :
+    printer(name, false),
+    m_filename_option(name + "_file")
+{
+    gauge::po::options_description options;
+
+    options.add_options()
+    (m_filename_option.c_str(),
+     gauge::po::value<std::string>()->default_value(default_filename),
+     ("Set the output filename of the " + name + " printer").c_str());
+
+    gauge::runner::instance().register_options(options);
+}
+
+void stream_printer::set_options(const po::variables_map& options)
+{
+    printer::set_options(options);
+    m_filename = options[m_filename_option].as<std::string>();
+    assert(!m_filename.empty());
+}
+
+void stream_printer::start()
+{
+    // Results of a previous invocation are replaced
+    replace(std::string());
+}
+
+void stream_printer::benchmark_result(const benchmark& /*info*/,
+                                      const tables::table& results)
+{
+    if (m_summary.empty())
+    {
+        write_results(results);
+        return;
+    }
+
+    tables::table output = results;
+    add_summary(output);
+    write_results(output);
+}
+
+void stream_printer::append(const std::string& data) const
+{
+    {
+        std::ofstream file(m_filename, std::ios::out | std::ios::app);
+        file << data;
+        file.close();
+
+        if (!file)
+        {
+            throw std::runtime_error("Error cannot write '" +
+                                     m_filename + "'");
+        }
+    }
+
+    sync_file(m_filename);
+}
+
+void stream_printer::replace(const std::string& content) const
+{
+    replace([&content](std::ostream& out) { out << content; });
+}
+
+void stream_printer::replace(
+    const std::function<void(std::ostream&)>& write) const
+{
+    std::string temporary = m_filename + ".tmp";
+
+    {
+        std::ofstream file(temporary, std::ios::out | std::ios::trunc);
+        write(file);
+        file.close();
+
+        if (!file)
+        {
+            throw std::runtime_error("Error cannot write '" +
+                                     temporary + "'");
+        }
+    }
+
+    sync_file(temporary);
+
+    // On POSIX the rename replaces the file atomically, elsewhere the
+    // old file has to be removed first
+#if !defined(__unix__) && !defined(__APPLE__)
+    std::remove(m_filename.c_str());
+#endif
+
+    if (std::rename(temporary.c_str(), m_filename.c_str()) != 0)
+    {
+        throw std::runtime_error("Error cannot replace '" +
+                                 m_filename + "'");
+    }
+
+    // The rename is only durable once the directory is flushed too
+    sync_parent_directory(m_filename);
+}
+
+std::string stream_printer::to_text(const boost::any& value)
+{
+    if (value.empty())
+        return "";
+
+    std::ostringstream out;
+    // Enough digits for every double to be read back unchanged
+    out.precision(std::numeric_limits<double>::max_digits10);
+
+    if (print_as<double>(out, value) || print_as<float>(out, value) ||
+        print_as<uint64_t>(out, value) || print_as<int64_t>(out, value) ||
+        print_as<uint32_t>(out, value) || print_as<int32_t>(out, value) ||
+        print_as<uint16_t>(out, value) || print_as<int16_t>(out, value) ||
+        print_as<std::string>(out, value) ||
+        print_as<const char*>(out, value))
+    {
+        return out.str();
+    }
+
+    if (value.type() == typeid(bool))
+        return boost::any_cast<bool>(value) ? "true" : "false";
+    if (value.type() == typeid(uint8_t))
+        return std::to_string(boost::any_cast<uint8_t>(value));
+    if (value.type() == typeid(int8_t))
+        return std::to_string(boost::any_cast<int8_t>(value));
+
+    throw std::runtime_error(std::string("Error cannot print values of "
+                                         "type ") + value.type().name());
+}
+
+bool stream_printer::is_text(const boost::any& value)
+{
+    return value.type() == typeid(std::string) ||
+           value.type() == typeid(const char*);
+}
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <string>
+
+#include <boost/any.hpp>
+
+#include <tables/table.hpp>
+
+#include "benchmark.hpp"
+#include "printer.hpp"
+
+namespace gauge
+{
+/// Base class for the printers writing the results of every benchmark
+/// to their file as soon as the benchmark completes. Unlike the
+/// file_printer nothing is kept in memory and the written results survive
+/// a crash or timeout of the benchmark program.
+class stream_printer : public printer
+{
+public:
+
+    /// Create a new stream printer
+    /// @param name The name of the printer
+    /// @param default_filename The default name of the outputted file
+    stream_printer(const std::string& name,
+                   const std::string& default_filename);
+
+public:
+    // From printer
+
+    /// @see printer::set_options(po::variables_map&)
+    virtual void set_options(const po::variables_map& options);
+
+    /// @see printer::start()
+    virtual void start();
+
+    /// @see printer::benchmark_result(const benchmark&, const table&)
+    virtual void benchmark_result(const benchmark& info,
+                                  const tables::table& results);
+
+protected:
+
+    /// Writes the results of a benchmark to the file
+    /// @param results The results
+    virtual void write_results(const tables::table& results) = 0;
+
+    /// Appends data to the file and flushes it to the disk
+    /// @param data The data to append
+    void append(const std::string& data) const;
+
+    /// Replaces the file with new content. The content is written to a
+    /// temporary file first, so the file is never partially written.
+    /// @param content The new content
+    void replace(const std::string& content) const;
+
+    /// Replaces the file with the content written by a function. The
+    /// content is written to a temporary file first.
+    /// @param write Called with the stream of the temporary file
+    void replace(const std::function<void(std::ostream&)>& write) const;
+
+    /// @param value A value of a results table
+    /// @return the value as text, strings are not quoted
+    static std::string to_text(const boost::any& value);
+
+    /// @param value A value of a results table
+    /// @return true if the value is a string
+    static bool is_text(const boost::any& value);
+
+protected:
+
+    /// The name of the output file
+    std::string m_filename;
+
+    /// The name of the filename option
+    std::string m_filename_option;
+};
+}
@@ -0,0 +1,371 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "clock.hpp"
+#include "cpu_topology.hpp"
+#include "environment.hpp"
+#include "runner.hpp"
+#include "spin_barrier.hpp"
+#include "statistics.hpp"
+#include "thread_benchmark.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// The index of the thread running the body
+thread_local uint32_t current_thread_index = 0;
+
+/// Controlled by the RUN loops on one of the threads. Measures the time
+/// the thread spends in its RUN loops with a clock of its own.
+class thread_timer : public benchmark
+{
+public:
+
+    /// Constructor
+    /// @param clock_name The name of the clock to use
+    /// @param iterations The number of iterations of the RUN loops
+    thread_timer(const std::string& clock_name, uint64_t iterations) :
+        m_clock_name(clock_name),
+        m_iterations(iterations),
+        m_ticks(0),
+        m_started(false)
+    { }
+
+    /// Creates the clock, must be called on the thread which uses it
+    void init()
+    {
+        m_clock = make_clock(m_clock_name);
+    }
+
+    uint64_t iteration_count() const
+    {
+        return m_iterations;
+    }
+
+    void start()
+    {
+        assert(m_clock);
+        m_started = true;
+        m_paused = 0;
+        m_start = m_clock->start();
+    }
+
+    void stop()
+    {
+        uint64_t stop = m_clock->stop();
+        uint64_t ticks = stop >= m_start ? stop - m_start : 0;
+
+        m_ticks += ticks >= m_paused ? ticks - m_paused : 0;
+    }
+
+    void pause()
+    {
+        m_pause_start = m_clock->stop();
+    }
+
+    void resume()
+    {
+        uint64_t now = m_clock->start();
+        m_paused += now >= m_pause_start ? now - m_pause_start : 0;
+    }
+
+    /// @return the time spent in the RUN loops in nanoseconds
+    double nanoseconds() const
+    {
+        return m_clock->nanoseconds(m_ticks);
+    }
+
+    /// @return true if a RUN loop was run
+    bool started() const
+    {
+        return m_started;
+    }
+
+    std::string unit_text() const
+    {
+        return "microseconds";
+    }
+
+    uint32_t runs() const
+    {
+        return 1;
+    }
+
+    void store_run(tables::table& /*results*/)
+    { }
+
+    void test_body()
+    { }
+
+private:
+
+    std::string m_clock_name;
+    std::shared_ptr<clock> m_clock;
+    uint64_t m_iterations;
+    uint64_t m_start;
+    uint64_t m_pause_start;
+    uint64_t m_paused;
+    uint64_t m_ticks;
+    bool m_started;
+};
+}
+
+class thread_benchmark::impl
+{
+public:
+
+    /// The times of the threads in the last run in microseconds per
+    /// iteration
+    std::vector<double> m_thread_times;
+
+    /// The number of threads set by the runner, zero if not set
+    uint32_t m_threads = 0;
+
+    /// The CPUs to pin the threads to in order, empty if the threads are
+    /// not pinned
+    std::vector<uint32_t> m_cpus;
+};
+
+thread_benchmark::thread_benchmark() :
+    m_impl(new thread_benchmark::impl())
+{ }
+
+thread_benchmark::~thread_benchmark()
+{ }
+
+uint32_t thread_benchmark::threads() const
+{
+    return m_impl->m_threads > 0 ? m_impl->m_threads : default_threads();
+}
+
+void thread_benchmark::set_threads(uint32_t threads)
+{
+    m_impl->m_threads = threads;
+}
+
+uint32_t thread_benchmark::thread_index()
+{
+    return current_thread_index;
+}
+
+void thread_benchmark::init()
+{
+    time_benchmark::init();
+
+    const auto& options = gauge::runner::instance().options();
+
+    m_impl->m_cpus.clear();
+    if (options.count("pin_threads") && options["pin_threads"].as<bool>())
+        m_impl->m_cpus = cpu_order();
+}
+
+void thread_benchmark::test_body()
+{
+    uint32_t count = threads();
+    assert(count > 0);
+
+    std::string name = time_benchmark::clock_name();
+    uint64_t iterations = iteration_count();
+
+    std::vector<std::shared_ptr<thread_timer>> timers;
+    for (uint32_t i = 0; i < count; ++i)
+        timers.push_back(std::make_shared<thread_timer>(name, iterations));
+
+    // The wall time starts when the last thread arrives at the barrier,
+    // so the time it takes to start the threads is not measured. It stops
+    // when the last thread has finished its body, so neither is the time
+    // it takes to end and join them.
+    spin_barrier start_barrier(count, [this] { start(); });
+    spin_barrier stop_barrier(count, [this] { stop(); });
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        workers.emplace_back([this, i, &timers, &start_barrier,
+                              &stop_barrier, &error_mutex, &error]
+        {
+            const auto& cpus = m_impl->m_cpus;
+            if (!cpus.empty())
+            {
+                pin_thread(cpus[i % cpus.size()]);
+            }
+            else
+            {
+                // Otherwise the threads inherit the affinity and the
+                // scheduling of the measuring thread, with --pin_cpu all
+                // of them would share its CPU
+                unpin_thread();
+                reset_scheduling();
+            }
+
+            current_thread_index = i;
+            runner::set_thread_benchmark(timers[i]);
+
+            auto keep_error = [&error_mutex, &error]
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+            };
+
+            // A thread which fails still arrives at the barriers, so the
+            // other threads are not left waiting
+            bool failed = false;
+            try
+            {
+                timers[i]->init();
+            }
+            catch (...)
+            {
+                keep_error();
+                failed = true;
+            }
+
+            start_barrier.wait();
+
+            if (!failed)
+            {
+                try
+                {
+                    thread_body();
+                }
+                catch (...)
+                {
+                    keep_error();
+                }
+            }
+
+            stop_barrier.wait();
+
+            runner::set_thread_benchmark(runner::benchmark_ptr());
+        });
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    if (error)
+        std::rethrow_exception(error);
+
+    // All the threads run the same loops, so they agree on the batch
+    set_batch_size(timers.front()->batch_size());
+
+    m_impl->m_thread_times.clear();
+    for (const auto& timer : timers)
+    {
+        // Did you forget the RUN macro?
+        assert(timer->started());
+
+        m_impl->m_thread_times.push_back(
+            timer->nanoseconds() / 1000.0 / (iterations * batch_size()));
+    }
+}
+
+void thread_benchmark::store_run(tables::table& results)
+{
+    time_benchmark::store_run(results);
+
+    if (!results.has_column("threads"))
+        results.add_const_column("threads", threads());
+
+    const char* columns[] =
+    {
+        "iterations_per_second", "thread_time_min", "thread_time_max",
+        "imbalance", "straggler", "straggler_thread"
+    };
+
+    for (const auto& c : columns)
+    {
+        if (!results.has_column(c))
+            results.add_column(c);
+    }
+
+    const auto& times = m_impl->m_thread_times;
+    assert(!times.empty());
+
+    double seconds = elapsed_seconds();
+    if (seconds > 0)
+    {
+        double runs = static_cast<double>(run_iterations()) * batch_size() *
+                      times.size();
+        results.set_value("iterations_per_second", runs / seconds);
+    }
+
+    auto slowest = std::max_element(times.begin(), times.end());
+    double fastest = *std::min_element(times.begin(), times.end());
+
+    std::vector<double> values(times);
+    double typical = median(values);
+    double mean = std::accumulate(times.begin(), times.end(), 0.0) /
+                  times.size();
+
+    results.set_value("thread_time_min", fastest);
+    results.set_value("thread_time_max", *slowest);
+    results.set_value("imbalance",
+                      mean > 0 ? (*slowest / mean - 1.0) * 100.0 : 0.0);
+    results.set_value("straggler",
+                      typical > 0 ? (*slowest / typical - 1.0) * 100.0 : 0.0);
+    results.set_value("straggler_thread",
+                      static_cast<uint32_t>(slowest - times.begin()));
+}
+
+std::string thread_benchmark::column_unit(const std::string& column) const
+{
+    if (column == "iterations_per_second")
+        return "iterations/second";
+
+    if (column == "imbalance" || column == "straggler")
+        return "percent";
+
+    if (column == "straggler_thread" || column == "threads")
+        return "thread";
+
+    return time_benchmark::column_unit(column);
+}
+
+std::string thread_benchmark::clock_name() const
+{
+    std::string name = time_benchmark::clock_name();
+
+    if (name == "thread_cputime" || name == "process_cputime")
+        return "steady";
+
+    return name;
+}
+
+bool thread_benchmark::overhead_correction() const
+{
+    return false;
+}
+
+bool thread_benchmark::track_allocations() const
+{
+    return false;
+}
+
+bool thread_benchmark::count_topdown() const
+{
+    return false;
+}
+
+uint64_t thread_benchmark::sample_interval() const
+{
+    return 0;
+}
+}
@@ -0,0 +1,140 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "time_benchmark.hpp"
+
+namespace gauge
+{
+/// Benchmark running its body on several threads at the same time, for
+/// measuring shared data structures such as concurrent queues.
+///
+/// In every run the threads are started together by a spinning barrier
+/// and each thread runs the body with a RUN loop of its own. The RUN
+/// loops on a thread are controlled by a timer private to the thread,
+/// with its own clock, and all threads run the same number of
+/// iterations.
+///
+/// The results combine the threads:
+///
+///   - "time" is the wall time from the release of the threads until the
+///     last thread finished, per iteration of one thread
+///   - "iterations" counts the runs of the body on all threads, so the
+///     throughput and item rates are summed over the threads
+///   - "iterations_per_second" is the summed rate of the body
+///   - "thread_time_min" and "thread_time_max" are the fastest and the
+///     slowest thread's time per iteration
+///   - "imbalance" is how much longer the slowest thread ran than the
+///     mean of the threads in percent
+///   - "straggler" is how much longer the slowest thread ran than the
+///     median thread in percent and "straggler_thread" its index
+///
+/// With the --pin_threads option, enabled by default, the threads are
+/// pinned to the allowed CPUs one per physical core first and then on
+/// the SMT siblings, see cpu_order(). Otherwise they may run on all the
+/// allowed CPUs with the default scheduling policy, whatever the
+/// execution environment of the measuring thread.
+///
+/// The measuring thread only waits while the threads run. The
+/// --resource_usage columns are therefore those of the whole process,
+/// and the --run_quality columns and noise limits are not used.
+///
+/// The setup() and tear_down() functions run on the runner's thread.
+/// The user counters are not synchronized, the body should only declare
+/// the bytes or items processed outside the RUN loop.
+///
+/// Example:
+///
+///    BENCHMARK_THREADS(queue, push_pop, 10, 4)
+///    {
+///        RUN
+///        {
+///            if (thread_index() % 2 == 0)
+///                queue.push(1);
+///            else
+///                queue.try_pop();
+///        }
+///    }
+///
+class thread_benchmark : public time_benchmark
+{
+public:
+
+    /// Constructor
+    thread_benchmark();
+
+    /// Destructor
+    ~thread_benchmark();
+
+    /// @return the number of threads running the body, the count set
+    ///         with set_threads() or else default_threads()
+    uint32_t threads() const;
+
+    /// Sets the number of threads, used by the runner for the
+    /// --threads and --thread_scaling sweeps
+    /// @param threads The number of threads, zero for default_threads()
+    void set_threads(uint32_t threads);
+
+    /// @return the number of threads running the body unless the runner
+    ///         sets another count
+    virtual uint32_t default_threads() const = 0;
+
+    /// The body run on each of the threads
+    virtual void thread_body() = 0;
+
+    /// @return the index of the calling thread among the threads running
+    ///         the body, zero outside of a thread_benchmark
+    static uint32_t thread_index();
+
+public:
+    // From time_benchmark
+
+    /// @copydoc benchmark::init()
+    virtual void init();
+
+    /// Runs thread_body() on the threads
+    void test_body();
+
+    /// @copydoc benchmark::store_run(tables::table&)
+    virtual void store_run(tables::table& results);
+
+    /// @copydoc benchmark::column_unit(const std::string&) const
+    virtual std::string column_unit(const std::string& column) const;
+
+    /// The wall time is measured with the clock selected by the --clock
+    /// option unless that measures CPU time, then the steady clock is
+    /// used. The threads use the selected clock.
+    /// @copydoc time_benchmark::clock_name() const
+    virtual std::string clock_name() const;
+
+    /// The calibrated overhead is the one of a single RUN loop, so the
+    /// correction is disabled
+    /// @copydoc time_benchmark::overhead_correction() const
+    virtual bool overhead_correction() const;
+
+    /// Only the allocations of the thread calling start() are counted,
+    /// which just waits for the threads, so the tracking is disabled
+    /// @copydoc time_benchmark::track_allocations() const
+    virtual bool track_allocations() const;
+
+    /// The slot events are counted for the thread calling start(), which
+    /// just waits for the threads, so the breakdown is disabled
+    /// @copydoc time_benchmark::count_topdown() const
+    virtual bool count_topdown() const;
+
+    /// The iteration latencies are not sampled on the threads
+    /// @copydoc benchmark::sample_interval() const
+    virtual uint64_t sample_interval() const;
+
+private:
+
+    class impl;
+    std::unique_ptr<impl> m_impl;
+};
+}
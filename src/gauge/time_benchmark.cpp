@@ -3,15 +3,48 @@
 //
 // Distributed under the "BSD License". See the accompanying LICENSE.rst file.
 
-#include <chrono>
-
 #include <algorithm>
+#include <iostream>
+#include <limits>
+#include <memory>
 #include <string>
 
+#include "allocation_tracker.hpp"
+#include "clock.hpp"
+#include "latency_histogram.hpp"
+#include "overhead.hpp"
+#include "perf_counters.hpp"
+#include "runner.hpp"
 #include "time_benchmark.hpp"
+#include "topdown.hpp"
 
 namespace gauge
 {
+namespace
+{
+/// The largest relative error we accept from the clock's resolution
+/// and read cost. The shortest accepted measurement is the larger of
+/// the two divided by this value.
+const double clock_error = 0.001;
+
+/// If the time grows less than twice while the iterations grow by this
+/// factor the time does not depend on the iterations
+const double dead_growth = 1000.0;
+
+/// Below this fraction of the time spent in the iterations the
+/// measurement is dominated by the constant overhead
+const double min_linearity = 0.5;
+
+/// The growth of the time per iteration left after subtracting the
+/// calibrated loop is noise, i.e. the body of the benchmark has been
+/// optimized away, while it is within this multiple of the interquartile
+/// range of the loop over the calibration runs. Two ranges above the
+/// median is about Tukey's fence for mild outliers of the loop. A body
+/// which grows by more is reported as live, also when its RUN loop
+/// happens to be slower than the calibrated one.
+const double dead_spread = 2.0;
+}
+
 class time_benchmark::impl
 {
 public:
@@ -20,19 +53,38 @@ public:
     /// acceptable result
     uint64_t m_iterations;
 
-    /// The threshold in microseconds before we accept
+    /// The number of iterations of the last measurement, accepting a
+    /// measurement may already have adjusted m_iterations for the next
+    uint64_t m_run_iterations;
+
+    /// The threshold in nanoseconds before we accept
     /// a measurement
     double m_threshold;
 
-    /// The start time
-    std::chrono::high_resolution_clock::time_point m_start;
+    /// The clock used for the measurements
+    std::shared_ptr<clock> m_clock;
+
+    /// The start time in clock ticks
+    uint64_t m_start;
 
-    /// The stop time
-    std::chrono::high_resolution_clock::time_point m_stop;
+    /// The stop time in clock ticks
+    uint64_t m_stop;
 
-    /// The result in microseconds
+    /// The result in nanoseconds
     double m_result;
 
+    /// The clock ticks at the last pause
+    uint64_t m_pause_start;
+
+    /// The clock ticks spent paused in the current measurement
+    uint64_t m_paused;
+
+    /// The number of pauses in the current measurement
+    uint64_t m_pauses;
+
+    /// True while the measurement is paused
+    bool m_is_paused;
+
     /// Got result i.e. was start() and stop() called
     /// If the user forgets to use the RUN macro inside the
     /// BENCHMARK macro this test would trigger
@@ -41,6 +93,63 @@ public:
 
     /// Stores whether the measurement was accepted
     bool m_accepted;
+
+    /// The latencies of the sampled iterations in clock ticks,
+    /// excluding the first iteration
+    latency_histogram m_latency;
+
+    /// The clock ticks at the last iteration mark
+    uint64_t m_mark;
+
+    /// The latency of the first iteration in clock ticks
+    uint64_t m_first_latency;
+
+    /// True if the first iteration was sampled
+    bool m_has_first_latency;
+
+    /// The calibrated overhead of the measurements, null if the
+    /// overhead correction is disabled
+    const overhead* m_overhead;
+
+    /// The calibrated overhead used to tell the growth of the body from
+    /// that of the RUN loop, also when the correction is disabled. Null
+    /// if the scaling is not checked.
+    const overhead* m_loop;
+
+    /// The iterations and result in nanoseconds of the first non-zero
+    /// measurement, used to detect a time which does not grow at all
+    uint64_t m_first_iterations;
+    double m_first_result;
+
+    /// The iterations and result in nanoseconds of the last rejected
+    /// non-zero measurement, used as the first point of the linearity
+    /// check
+    uint64_t m_calibration_iterations;
+    double m_calibration_result;
+
+    /// The lowest fraction of the time which grows with the iterations
+    /// in the accepted runs, negative until the linearity has been checked
+    double m_linearity;
+
+    /// The lowest fraction of the time which grows with the iterations,
+    /// including the RUN loop itself, in the accepted runs, negative
+    /// until the linearity has been checked
+    double m_growth;
+
+    /// The lowest growth of the time per iteration in nanoseconds left
+    /// after subtracting the calibrated cost of the RUN loop in the
+    /// accepted runs, negative if not checked
+    double m_body_slope;
+
+    /// True if the time does not grow with the iterations
+    bool m_dead;
+
+    /// True if the heap allocations are counted
+    bool m_track_allocations;
+
+    /// The counters used for the top-down breakdown, only created when
+    /// the breakdown is enabled with the --topdown option
+    std::unique_ptr<perf_counters> m_topdown;
 };
 
 time_benchmark::time_benchmark() :
@@ -53,9 +162,91 @@ time_benchmark::~time_benchmark()
 void time_benchmark::init()
 {
     m_impl->m_iterations = 1;
-    m_impl->m_threshold = 10000.0;
+    m_impl->m_run_iterations = 0;
     m_impl->m_started = false;
     m_impl->m_stopped = false;
+    m_impl->m_has_first_latency = false;
+    m_impl->m_first_iterations = 0;
+    m_impl->m_first_result = 0;
+    m_impl->m_calibration_iterations = 0;
+    m_impl->m_calibration_result = 0;
+    m_impl->m_linearity = -1;
+    m_impl->m_growth = -1;
+    m_impl->m_body_slope = -1;
+    m_impl->m_dead = false;
+
+    std::string name = clock_name();
+    if (!m_impl->m_clock || m_impl->m_clock->name() != name)
+    {
+        m_impl->m_clock = make_clock(name);
+    }
+
+    const auto& options = gauge::runner::instance().options();
+
+    if (options.count("min_run_time"))
+    {
+        // The option is given in microseconds
+        m_impl->m_threshold = options["min_run_time"].as<double>() * 1000.0;
+    }
+    else
+    {
+        // Run long enough for the clock's resolution and read cost to
+        // be negligible
+        const auto& p = measure_clock(*m_impl->m_clock);
+        m_impl->m_threshold =
+            std::max(p.m_resolution, p.m_read_cost) / clock_error;
+    }
+
+    assert(m_impl->m_threshold > 0);
+
+    m_impl->m_loop = nullptr;
+    if (overhead_correction() || check_scaling())
+    {
+        m_impl->m_loop =
+            &calibrate_overhead(m_impl->m_clock->name(), sample_interval());
+    }
+
+    m_impl->m_overhead = overhead_correction() ? m_impl->m_loop : nullptr;
+
+    m_impl->m_track_allocations = track_allocations();
+    if (m_impl->m_track_allocations && !allocation_tracker::is_available())
+    {
+        static bool warned = false;
+        if (!warned)
+        {
+            std::cerr << "Warning: tracking allocations requires including "
+                      << "gauge/allocation_hooks.hpp or gauge/malloc_hooks.hpp "
+                      << "in the benchmark program" << std::endl;
+            warned = true;
+        }
+
+        m_impl->m_track_allocations = false;
+    }
+
+    if (count_topdown() && !m_impl->m_topdown)
+    {
+        m_impl->m_topdown.reset(new perf_counters());
+
+        auto events = topdown_events();
+        if (!events.empty())
+            m_impl->m_topdown->open(events);
+
+        // All the slot events must be counted together for the
+        // breakdown to add up
+        if (m_impl->m_topdown->group_count() != 1 ||
+            m_impl->m_topdown->events() != events)
+        {
+            static bool warned = false;
+            if (!warned)
+            {
+                std::cerr << "Warning: the top-down slot events are not "
+                          << "available on this CPU" << std::endl;
+                warned = true;
+            }
+
+            m_impl->m_topdown->close();
+        }
+    }
 }
 
 uint64_t time_benchmark::iteration_count() const
@@ -66,24 +257,132 @@ uint64_t time_benchmark::iteration_count() const
 void time_benchmark::start()
 {
     assert(m_impl->m_iterations > 0);
+    assert(m_impl->m_clock);
     m_impl->m_started = true;
-    m_impl->m_start = std::chrono::high_resolution_clock::now();
+    m_impl->m_run_iterations = m_impl->m_iterations;
+
+    if (m_impl->m_topdown && m_impl->m_topdown->is_open())
+        m_impl->m_topdown->start();
+
+    m_impl->m_paused = 0;
+    m_impl->m_pauses = 0;
+    m_impl->m_is_paused = false;
+
+    if (m_impl->m_track_allocations)
+        allocation_tracker::start();
+
+    m_impl->m_start = m_impl->m_clock->start();
+    m_impl->m_mark = m_impl->m_start;
 }
 
 void time_benchmark::stop()
 {
-    m_impl->m_stop = std::chrono::high_resolution_clock::now();
+    m_impl->m_stop = m_impl->m_clock->stop();
+
+    if (m_impl->m_track_allocations)
+        allocation_tracker::stop();
+
+    if (m_impl->m_topdown && m_impl->m_topdown->is_open())
+        m_impl->m_topdown->stop();
 
     assert(m_impl->m_started);
+    assert(!m_impl->m_is_paused && "Did you forget to resume the timing?");
     m_impl->m_stopped = true;
 
-    m_impl->m_result = static_cast<double>(
-        std::chrono::duration_cast<std::chrono::microseconds>(
-            m_impl->m_stop-m_impl->m_start).count());
+    // The high_resolution clock is not guaranteed to be monotonic, so
+    // we have to guard against it going backwards
+    uint64_t ticks = m_impl->m_stop >= m_impl->m_start ?
+                     m_impl->m_stop - m_impl->m_start : 0;
+
+    ticks = ticks >= m_impl->m_paused ? ticks - m_impl->m_paused : 0;
+
+    m_impl->m_result = m_impl->m_clock->nanoseconds(ticks);
 
     assert(m_impl->m_iterations > 0);
 }
 
+void time_benchmark::pause()
+{
+    assert(m_impl->m_started);
+    assert(!m_impl->m_is_paused);
+
+    m_impl->m_pause_start = m_impl->m_clock->stop();
+    m_impl->m_is_paused = true;
+
+    if (m_impl->m_track_allocations)
+        allocation_tracker::pause();
+
+    if (m_impl->m_topdown && m_impl->m_topdown->is_open())
+        m_impl->m_topdown->pause();
+}
+
+void time_benchmark::resume()
+{
+    assert(m_impl->m_is_paused);
+
+    if (m_impl->m_topdown && m_impl->m_topdown->is_open())
+        m_impl->m_topdown->resume();
+
+    if (m_impl->m_track_allocations)
+        allocation_tracker::resume();
+
+    uint64_t now = m_impl->m_clock->start();
+    uint64_t paused = now >= m_impl->m_pause_start ?
+                      now - m_impl->m_pause_start : 0;
+
+    m_impl->m_paused += paused;
+    ++m_impl->m_pauses;
+    m_impl->m_is_paused = false;
+
+    // The pause is not part of the latency of the iteration
+    m_impl->m_mark += paused;
+}
+
+uint64_t time_benchmark::sample_interval() const
+{
+    const auto& options = gauge::runner::instance().options();
+
+    if (options.count("latency_interval"))
+        return options["latency_interval"].as<uint64_t>();
+
+    return 0;
+}
+
+void time_benchmark::reset_counters()
+{
+    benchmark::reset_counters();
+
+    if (sample_interval() > 0)
+    {
+        m_impl->m_latency.reset();
+        m_impl->m_has_first_latency = false;
+    }
+}
+
+void time_benchmark::sample_iteration(bool record)
+{
+    uint64_t now = m_impl->m_clock->start();
+
+    if (record && now >= m_impl->m_mark)
+    {
+        uint64_t latency = now - m_impl->m_mark;
+
+        // The first iteration often runs with cold caches and branch
+        // predictors so we keep it out of the steady state histogram
+        if (!m_impl->m_has_first_latency)
+        {
+            m_impl->m_first_latency = latency;
+            m_impl->m_has_first_latency = true;
+        }
+        else
+        {
+            m_impl->m_latency.add(latency);
+        }
+    }
+
+    m_impl->m_mark = now;
+}
+
 double time_benchmark::measurement()
 {
     assert(m_impl);
@@ -91,7 +390,9 @@ double time_benchmark::measurement()
     assert(m_impl->m_stopped);
     assert(m_impl->m_iterations > 0);
 
-    return m_impl->m_result / m_impl->m_iterations;
+    // Convert to microseconds
+    return m_impl->m_result / 1000.0 /
+           (m_impl->m_run_iterations * batch_size());
 }
 
 bool time_benchmark::accept_measurement()
@@ -103,13 +404,25 @@ bool time_benchmark::accept_measurement()
     assert(m_impl->m_threshold > 0);
     assert(m_impl->m_iterations > 0);
 
+    // A dead benchmark will never reach the threshold
+    if (m_impl->m_dead)
+        return true;
+
+    if (m_impl->m_result > 0 && m_impl->m_first_iterations == 0)
+    {
+        m_impl->m_first_iterations = m_impl->m_iterations;
+        m_impl->m_first_result = m_impl->m_result;
+    }
+
     if (m_impl->m_result >= m_impl->m_threshold)
     {
+        check_linearity();
+
         double factor = m_impl->m_result / m_impl->m_threshold;
         if (factor > 2.0)
         {
             // We seem to be running longer than needed
-            m_impl->m_iterations = static_cast<uint32_t>(
+            m_impl->m_iterations = static_cast<uint64_t>(
                 (m_impl->m_iterations / factor) + 1);
 
             assert(m_impl->m_iterations > 0);
@@ -118,8 +431,33 @@ bool time_benchmark::accept_measurement()
         return true;
     }
 
+    if (m_impl->m_first_iterations > 0 &&
+        m_impl->m_iterations >= m_impl->m_first_iterations * dead_growth &&
+        m_impl->m_result < 2.0 * m_impl->m_first_result)
+    {
+        // The time does not grow with the number of iterations, there
+        // is no point in scaling further
+        m_impl->m_dead = true;
+        check_linearity();
+        return true;
+    }
+
+    if (m_impl->m_result > 0)
+    {
+        m_impl->m_calibration_iterations = m_impl->m_iterations;
+        m_impl->m_calibration_result = m_impl->m_result;
+    }
+
     if (m_impl->m_result == 0)
     {
+        if (m_impl->m_iterations >= (uint64_t(1) << 40))
+        {
+            // Even an empty loop should have taken measurable time by now
+            m_impl->m_linearity = 0;
+            m_impl->m_dead = true;
+            return true;
+        }
+
         // Check for overflow - are you sure you actually measure
         // anything - it seems time is zero even with a very large
         // number of iterations?
@@ -142,8 +480,13 @@ bool time_benchmark::accept_measurement()
 
     assert(factor > 1.0);
 
+    // Check for overflow - the measured time does not seem to grow with
+    // the number of iterations
+    assert(m_impl->m_iterations * factor <
+           static_cast<double>(std::numeric_limits<uint64_t>::max()));
+
     // Adjust the number of iterations with the factor
-    m_impl->m_iterations = static_cast<uint32_t>(
+    m_impl->m_iterations = static_cast<uint64_t>(
         (m_impl->m_iterations * factor) + 1);
 
     assert(m_impl->m_iterations > 0);
@@ -161,5 +504,274 @@ void time_benchmark::store_run(tables::table& results)
     if (!results.has_column("time"))
         results.add_column("time");
     results.set_value("time", measurement());
+
+    if (!results.has_column("clock"))
+        results.add_const_column("clock", m_impl->m_clock->name());
+
+    if (m_impl->m_overhead)
+    {
+        const auto& o = *m_impl->m_overhead;
+
+        // Subtract the fixed cost of the measurement and the cost of
+        // the loop itself, noise may take us below zero. With RUN_BATCH
+        // the cost of the loop is shared by the batch.
+        double corrected = (m_impl->m_result - o.m_run -
+                            m_impl->m_pauses * o.m_pause) /
+                           m_impl->m_run_iterations - o.m_iteration;
+        corrected = std::max(0.0, corrected) / batch_size();
+
+        if (!results.has_column("time_corrected"))
+            results.add_column("time_corrected");
+        results.set_value("time_corrected", corrected / 1000.0);
+
+        if (!results.has_column("overhead_run"))
+            results.add_const_column("overhead_run", o.m_run / 1000.0);
+
+        if (!results.has_column("overhead_iteration"))
+        {
+            results.add_const_column("overhead_iteration",
+                                     o.m_iteration / 1000.0);
+        }
+
+        if (m_impl->m_pauses > 0 && !results.has_column("overhead_pause"))
+            results.add_const_column("overhead_pause", o.m_pause / 1000.0);
+    }
+
+    if (m_impl->m_pauses > 0)
+    {
+        if (!results.has_column("time_paused"))
+            results.add_column("time_paused");
+
+        // The untimed work per run of the body in microseconds
+        results.set_value("time_paused",
+                          m_impl->m_clock->nanoseconds(m_impl->m_paused) /
+                          1000.0 / (m_impl->m_run_iterations * batch_size()));
+    }
+
+    if (m_impl->m_track_allocations)
+    {
+        auto counts = allocation_tracker::counts();
+        double runs = static_cast<double>(m_impl->m_run_iterations) *
+                      batch_size();
+
+        const char* columns[] = { "allocations", "frees", "allocated_bytes" };
+        uint64_t values[] = { counts.m_allocations, counts.m_frees,
+                              counts.m_bytes };
+
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            if (!results.has_column(columns[i]))
+                results.add_column(columns[i]);
+
+            results.set_value(columns[i], values[i] / runs);
+        }
+    }
+
+    if (m_impl->m_has_first_latency)
+    {
+        store_latency(results, "latency_first", m_impl->m_first_latency);
+    }
+
+    const auto& latency = m_impl->m_latency;
+    if (latency.count() > 0)
+    {
+        store_latency(results, "latency_p50", latency.quantile(0.5));
+        store_latency(results, "latency_p90", latency.quantile(0.9));
+        store_latency(results, "latency_p99", latency.quantile(0.99));
+        store_latency(results, "latency_p99_9", latency.quantile(0.999));
+        store_latency(results, "latency_max", latency.max());
+    }
+
+    topdown breakdown;
+    if (m_impl->m_topdown && m_impl->m_topdown->is_open() &&
+        calculate_topdown(m_impl->m_topdown->counts(), breakdown))
+    {
+        auto columns = topdown_columns();
+        double values[] = { breakdown.m_frontend_bound,
+                            breakdown.m_bad_speculation,
+                            breakdown.m_backend_bound,
+                            breakdown.m_retiring };
+
+        for (uint32_t i = 0; i < columns.size(); ++i)
+        {
+            if (!results.has_column(columns[i]))
+                results.add_column(columns[i]);
+
+            results.set_value(columns[i], values[i] * 100.0);
+        }
+    }
+}
+
+void time_benchmark::finish_table(tables::table& results)
+{
+    if (!check_scaling())
+        return;
+
+    if (m_impl->m_linearity < 0 && !m_impl->m_dead)
+        return;
+
+    // The time does not grow at all, or a removed body left only the RUN
+    // loop whose cost is all the time grows with
+    bool constant = m_impl->m_growth >= 0 &&
+                    m_impl->m_growth < 1.0 / dead_growth;
+
+    bool loop_only = m_impl->m_body_slope >= 0 && m_impl->m_loop &&
+                     m_impl->m_body_slope <=
+                     dead_spread * m_impl->m_loop->m_iteration_spread;
+
+    std::string scaling = "linear";
+    if (m_impl->m_dead || constant || loop_only)
+        scaling = "optimized_away";
+    else if (m_impl->m_linearity < min_linearity)
+        scaling = "overhead_dominated";
+
+    results.add_const_column("linearity",
+                             std::max(0.0, m_impl->m_linearity));
+    results.add_const_column("scaling", scaling);
+}
+
+void time_benchmark::check_linearity()
+{
+    assert(m_impl->m_result > 0 || m_impl->m_dead);
+
+    uint64_t n1 = 0;
+    double t1 = 0;
+    uint64_t n2 = m_impl->m_run_iterations;
+    double t2 = m_impl->m_result;
+
+    if (m_impl->m_calibration_iterations > 0 &&
+        m_impl->m_calibration_iterations * 2 <= n2)
+    {
+        n1 = m_impl->m_calibration_iterations;
+        t1 = m_impl->m_calibration_result;
+    }
+    else if (m_impl->m_loop)
+    {
+        // The calibrated overhead is the time of zero iterations
+        t1 = m_impl->m_loop->m_run;
+    }
+    else
+    {
+        // With a single point we cannot tell
+        return;
+    }
+
+    if (t2 <= 0)
+    {
+        m_impl->m_linearity = 0;
+        m_impl->m_growth = 0;
+        return;
+    }
+
+    double slope = std::max(0.0, (t2 - t1) / (n2 - n1));
+
+    double growth = std::min(1.0, slope * n2 / t2);
+    if (m_impl->m_growth < 0 || growth < m_impl->m_growth)
+        m_impl->m_growth = growth;
+
+    // The time predicted from the growth between the two points
+    // relative to the measured time. A linear benchmark without any
+    // constant overhead gives one, a constant time gives zero. An empty
+    // RUN loop still grows with the cost of the loop itself, so that is
+    // not counted as growth.
+    if (m_impl->m_loop)
+    {
+        slope = std::max(0.0, slope - m_impl->m_loop->m_iteration);
+
+        if (m_impl->m_body_slope < 0 || slope < m_impl->m_body_slope)
+            m_impl->m_body_slope = slope;
+    }
+
+    double linearity = slope * n2 / t2;
+
+    linearity = std::min(1.0, std::max(0.0, linearity));
+    if (m_impl->m_linearity < 0 || linearity < m_impl->m_linearity)
+        m_impl->m_linearity = linearity;
+}
+
+void time_benchmark::store_latency(tables::table& results,
+                                   const std::string& column,
+                                   uint64_t ticks)
+{
+    if (!results.has_column(column))
+        results.add_column(column);
+
+    // Convert to microseconds, a sampled iteration runs the whole batch
+    results.set_value(column, m_impl->m_clock->nanoseconds(ticks) / 1000.0 /
+                      batch_size());
+}
+
+std::string time_benchmark::column_unit(const std::string& column) const
+{
+    for (const auto& c : topdown_columns())
+    {
+        if (column == c)
+            return "percent";
+    }
+
+    if (column == "allocations")
+        return "allocations/iteration";
+
+    if (column == "frees")
+        return "frees/iteration";
+
+    if (column == "allocated_bytes")
+        return "bytes/iteration";
+
+    return benchmark::column_unit(column);
+}
+
+bool time_benchmark::overhead_correction() const
+{
+    const auto& options = gauge::runner::instance().options();
+
+    if (options.count("overhead_correction"))
+        return options["overhead_correction"].as<bool>();
+
+    return true;
+}
+
+bool time_benchmark::check_scaling() const
+{
+    return true;
+}
+
+bool time_benchmark::track_allocations() const
+{
+    const auto& options = gauge::runner::instance().options();
+    return options.count("track_allocations") > 0;
+}
+
+bool time_benchmark::count_topdown() const
+{
+    const auto& options = gauge::runner::instance().options();
+    return options.count("topdown") > 0;
+}
+
+double time_benchmark::elapsed_seconds() const
+{
+    return elapsed_nanoseconds() / 1e9;
+}
+
+uint64_t time_benchmark::run_iterations() const
+{
+    assert(m_impl->m_started);
+    return m_impl->m_run_iterations;
+}
+
+double time_benchmark::elapsed_nanoseconds() const
+{
+    assert(m_impl->m_stopped);
+    return m_impl->m_result;
+}
+
+std::string time_benchmark::clock_name() const
+{
+    const auto& options = gauge::runner::instance().options();
+
+    if (options.count("clock"))
+        return options["clock"].as<std::string>();
+
+    return "high_resolution";
 }
 }
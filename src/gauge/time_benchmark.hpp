@@ -31,12 +31,27 @@ public:
     /// @copydoc benchmark::iteration_count() const
     virtual uint64_t iteration_count() const;
 
+    /// @copydoc benchmark::run_iterations() const
+    virtual uint64_t run_iterations() const;
+
     /// @copydoc benchmark::start()
     virtual void start();
 
     /// @copydoc benchmark::stop()
     virtual void stop();
 
+    /// @copydoc benchmark::pause()
+    virtual void pause();
+
+    /// @copydoc benchmark::resume()
+    virtual void resume();
+
+    /// @copydoc benchmark::sample_interval() const
+    virtual uint64_t sample_interval() const;
+
+    /// @copydoc benchmark::sample_iteration(bool)
+    virtual void sample_iteration(bool record);
+
     /// @copydoc benchmark::measurement()
     virtual double measurement();
 
@@ -46,8 +61,79 @@ public:
     /// @copydoc benchmark::unit_text() const
     virtual std::string unit_text() const;
 
+    /// @copydoc benchmark::store_run(tables::table&)
     virtual void store_run(tables::table& results);
 
+    /// Stores the linearity and the scaling of the least disturbed run
+    /// @copydoc benchmark::finish_table(tables::table&)
+    virtual void finish_table(tables::table& results);
+
+    /// @copydoc benchmark::column_unit(const std::string&) const
+    virtual std::string column_unit(const std::string& column) const;
+
+    /// @copydoc benchmark::elapsed_seconds() const
+    virtual double elapsed_seconds() const;
+
+    /// Also clears the iteration latencies if they are sampled, so the
+    /// histogram is not touched right before the timing starts
+    /// @copydoc benchmark::reset_counters()
+    virtual void reset_counters();
+
+public:
+
+    /// @return the name of the clock used to measure time. By default
+    ///         the clock selected with the --clock option is used, a
+    ///         benchmark may override this function to always use a
+    ///         specific clock e.g. "thread_cputime".
+    virtual std::string clock_name() const;
+
+    /// @return true if the measurement overhead should be calibrated and
+    ///         subtracted in the "time_corrected" column. By default the
+    ///         --overhead_correction option decides.
+    virtual bool overhead_correction() const;
+
+    /// @return true if the time should be checked for growing linearly
+    ///         with the iterations and the result stored in the
+    ///         "linearity" and "scaling" columns. The check uses the
+    ///         calibrated cost of the RUN loop, also when the overhead
+    ///         correction is disabled.
+    virtual bool check_scaling() const;
+
+    /// @return true if the heap allocations inside the RUN loop should
+    ///         be counted and stored per iteration in the "allocations",
+    ///         "frees" and "allocated_bytes" columns. By default the
+    ///         --track_allocations option decides. The counting requires
+    ///         gauge/allocation_hooks.hpp or gauge/malloc_hooks.hpp to be
+    ///         included in the benchmark program.
+    virtual bool track_allocations() const;
+
+    /// @return true if the top-down slot events should be counted around
+    ///         the RUN loop and broken down into the "frontend_bound",
+    ///         "bad_speculation", "backend_bound" and "retiring" columns.
+    ///         By default the --topdown option decides.
+    virtual bool count_topdown() const;
+
+    /// @return the duration of the last measurement in nanoseconds
+    double elapsed_nanoseconds() const;
+
+private:
+
+    /// Checks that the time grows linearly with the number of iterations
+    /// using the last rejected measurement and the current measurement
+    /// as the calibration points. The calibrated cost of the RUN loop is
+    /// not counted as growth in the linearity, but it is in the check for
+    /// a time which does not grow at all. A disturbance only adds time, so
+    /// the lowest linearity, growth and growth of the body of the runs
+    /// are kept.
+    void check_linearity();
+
+    /// Stores a latency in microseconds in the results
+    /// @param results The result table
+    /// @param column The name of the column
+    /// @param ticks The latency in clock ticks
+    void store_latency(tables::table& results, const std::string& column,
+                       uint64_t ticks);
+
 private:
 
     class impl;
@@ -0,0 +1,121 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "perf_counters.hpp"
+#include "topdown.hpp"
+
+namespace gauge
+{
+namespace
+{
+/// The events of CPUs with the PERF_METRICS feature (Intel Ice Lake and
+/// later). The metric events count the share of the slots in each
+/// category and must be grouped with the slots event as leader.
+const std::vector<std::string> metric_events =
+{
+    "slots", "topdown-retiring", "topdown-bad-spec", "topdown-fe-bound",
+    "topdown-be-bound"
+};
+
+/// The events of earlier CPUs (Intel Sandy Bridge to Skylake) from
+/// which the breakdown is calculated
+const std::vector<std::string> slot_events =
+{
+    "topdown-total-slots", "topdown-slots-issued", "topdown-slots-retired",
+    "topdown-fetch-bubbles", "topdown-recovery-bubbles"
+};
+
+bool has_events(const std::vector<std::string>& events)
+{
+    return std::all_of(events.begin(), events.end(), perf_counters::has_event);
+}
+
+bool has_counts(const std::map<std::string, double>& counts,
+                const std::vector<std::string>& events)
+{
+    for (const auto& e : events)
+    {
+        if (counts.find(e) == counts.end())
+            return false;
+    }
+    return true;
+}
+
+double clamp(double fraction)
+{
+    return std::min(1.0, std::max(0.0, fraction));
+}
+}
+
+std::vector<std::string> topdown_columns()
+{
+    return { "frontend_bound", "bad_speculation", "backend_bound",
+             "retiring" };
+}
+
+std::vector<std::string> topdown_events()
+{
+    if (has_events(metric_events))
+        return metric_events;
+
+    if (has_events(slot_events))
+        return slot_events;
+
+    return {};
+}
+
+bool calculate_topdown(const std::map<std::string, double>& counts,
+                       topdown& result)
+{
+    if (has_counts(counts, metric_events))
+    {
+        double retiring = counts.at("topdown-retiring");
+        double bad_speculation = counts.at("topdown-bad-spec");
+        double frontend_bound = counts.at("topdown-fe-bound");
+        double backend_bound = counts.at("topdown-be-bound");
+
+        double total =
+            retiring + bad_speculation + frontend_bound + backend_bound;
+
+        if (total <= 0)
+            return false;
+
+        result.m_retiring = retiring / total;
+        result.m_bad_speculation = bad_speculation / total;
+        result.m_frontend_bound = frontend_bound / total;
+        result.m_backend_bound = backend_bound / total;
+        return true;
+    }
+
+    if (has_counts(counts, slot_events))
+    {
+        double total = counts.at("topdown-total-slots");
+
+        if (total <= 0)
+            return false;
+
+        double issued = counts.at("topdown-slots-issued");
+        double retired = counts.at("topdown-slots-retired");
+        double fetch_bubbles = counts.at("topdown-fetch-bubbles");
+        double recovery_bubbles = counts.at("topdown-recovery-bubbles");
+
+        result.m_frontend_bound = clamp(fetch_bubbles / total);
+        result.m_bad_speculation =
+            clamp((issued - retired + recovery_bubbles) / total);
+        result.m_retiring = clamp(retired / total);
+        result.m_backend_bound = clamp(1.0 - result.m_frontend_bound -
+                                       result.m_bad_speculation -
+                                       result.m_retiring);
+        return true;
+    }
+
+    return false;
+}
+}
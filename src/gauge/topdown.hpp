@@ -0,0 +1,51 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace gauge
+{
+/// The level 1 top-down breakdown of the CPU's pipeline slots. Every
+/// slot is either retiring an instruction, wasted on instructions
+/// which are later discarded (bad speculation), or stalled because
+/// the frontend did not deliver an instruction or because the backend
+/// could not accept it. The fractions add up to one.
+struct topdown
+{
+    /// Fraction of slots where the frontend did not deliver instructions
+    double m_frontend_bound;
+
+    /// Fraction of slots stalled due to a lack of backend resources
+    double m_backend_bound;
+
+    /// Fraction of slots wasted on mispredicted or cleared instructions
+    double m_bad_speculation;
+
+    /// Fraction of slots retiring instructions
+    double m_retiring;
+};
+
+/// @return the names of the result columns holding the breakdown in
+///         percent, in the order frontend bound, bad speculation,
+///         backend bound and retiring
+std::vector<std::string> topdown_columns();
+
+/// @return the perf events needed to calculate the top-down breakdown
+///         on this CPU. Empty if the CPU does not expose the slot
+///         events. The events must be counted in the same group.
+std::vector<std::string> topdown_events();
+
+/// Calculates the top-down breakdown from the counts of the events
+/// returned by topdown_events()
+/// @param counts The counts of the events
+/// @param result The calculated breakdown
+/// @return true if the breakdown could be calculated
+bool calculate_topdown(const std::map<std::string, double>& counts,
+                       topdown& result);
+}
@@ -0,0 +1,307 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// The preprocessor defines are taken from
+// http://predef.sourceforge.net
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #include <cpuid.h>
+    #define GAUGE_TSC_AVAILABLE
+#elif defined(_M_X64) || defined(_M_IX86)
+    #include <intrin.h>
+    #define GAUGE_TSC_AVAILABLE
+#endif
+
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
+#include "tsc_clock.hpp"
+
+namespace gauge
+{
+namespace
+{
+#if defined(GAUGE_TSC_AVAILABLE)
+
+inline uint64_t read_start()
+{
+    _mm_lfence();
+    uint64_t ticks = __rdtsc();
+    _mm_lfence();
+    return ticks;
+}
+
+inline uint64_t read_stop()
+{
+    uint32_t aux;
+    uint64_t ticks = __rdtscp(&aux);
+    _mm_lfence();
+    return ticks;
+}
+
+/// @return true if CPUID reports an invariant time-stamp counter
+bool is_invariant()
+{
+    uint32_t regs[4] = { 0, 0, 0, 0 };
+
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0x80000000);
+    if (static_cast<uint32_t>(info[0]) < 0x80000007)
+        return false;
+    __cpuid(info, 0x80000007);
+    regs[3] = static_cast<uint32_t>(info[3]);
+#else
+    if (__get_cpuid_max(0x80000000, 0) < 0x80000007)
+        return false;
+    __get_cpuid(0x80000007, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+
+    // Bit 8 of EDX is the invariant TSC flag
+    return (regs[3] & (1U << 8)) != 0;
+}
+
+/// @return the current steady_clock time in nanoseconds
+inline int64_t steady_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// A time-stamp counter reading paired with a steady_clock reading
+struct sample
+{
+    /// The counter value
+    uint64_t m_ticks;
+
+    /// The steady_clock time in nanoseconds at the midpoint of the
+    /// window in which the counter was read
+    int64_t m_time;
+
+    /// The width of the window in nanoseconds i.e. the uncertainty of
+    /// the pairing
+    int64_t m_window;
+};
+
+/// Takes a number of samples and keeps the one with the narrowest
+/// window
+sample take_sample()
+{
+    sample best = { 0, 0, 0 };
+
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        int64_t before = steady_now();
+        uint64_t ticks = read_start();
+        int64_t after = steady_now();
+
+        int64_t window = after - before;
+        if (i == 0 || window < best.m_window)
+        {
+            best.m_ticks = ticks;
+            best.m_time = before + window / 2;
+            best.m_window = window;
+        }
+    }
+
+    return best;
+}
+
+/// Measures the counter frequency by busy waiting for a fixed amount
+/// of time. The median of a few trials is used.
+double measure_frequency()
+{
+    const int64_t duration = 10000000; // 10 ms
+    std::vector<double> trials;
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        sample first = take_sample();
+        while (steady_now() - first.m_time < duration) {}
+        sample last = take_sample();
+
+        double seconds = (last.m_time - first.m_time) / 1e9;
+        trials.push_back((last.m_ticks - first.m_ticks) / seconds);
+    }
+
+    std::sort(trials.begin(), trials.end());
+    return trials[trials.size() / 2];
+}
+
+#if defined(__linux__)
+/// Moves the calling thread to the given CPU and takes a sample there
+bool take_sample_on(uint32_t cpu, sample& s)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    if (sched_setaffinity(0, sizeof(set), &set) != 0)
+        return false;
+
+    s = take_sample();
+    return true;
+}
+
+/// Compares the counter on every CPU we are allowed to run on with the
+/// counter on the first such CPU. To cancel out any error in the
+/// measured frequency each CPU is sampled in between two samples on the
+/// reference CPU, and the expected counter value is interpolated.
+void check_synchronization(tsc_clock::calibration& c)
+{
+    cpu_set_t original;
+    CPU_ZERO(&original);
+    if (sched_getaffinity(0, sizeof(original), &original) != 0)
+        return;
+
+    std::vector<uint32_t> cpus;
+    for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &original))
+            cpus.push_back(cpu);
+    }
+
+    if (cpus.size() < 2)
+        return;
+
+    for (uint32_t i = 1; i < cpus.size(); ++i)
+    {
+        sample before, other, after;
+
+        if (!take_sample_on(cpus[0], before) ||
+            !take_sample_on(cpus[i], other) ||
+            !take_sample_on(cpus[0], after))
+        {
+            continue;
+        }
+
+        double elapsed = static_cast<double>(after.m_time - before.m_time);
+        if (elapsed <= 0)
+            continue;
+
+        double fraction = (other.m_time - before.m_time) / elapsed;
+        double expected = before.m_ticks +
+            fraction * static_cast<double>(after.m_ticks - before.m_ticks);
+
+        double skew = std::fabs(
+            (static_cast<double>(other.m_ticks) - expected) /
+            c.m_frequency * 1e9);
+
+        double tolerance = static_cast<double>(
+            before.m_window + other.m_window + after.m_window);
+
+        c.m_max_skew = std::max(c.m_max_skew, skew);
+
+        if (skew > tolerance)
+            c.m_synchronized = false;
+    }
+
+    sched_setaffinity(0, sizeof(original), &original);
+}
+#else
+void check_synchronization(tsc_clock::calibration& c)
+{
+    // We cannot move the thread between cores here, so we trust the
+    // invariant flag
+    c.m_synchronized = c.m_invariant;
+}
+#endif
+
+#else
+
+inline uint64_t read_start()
+{
+    assert(0 && "The time-stamp counter is not available");
+    return 0;
+}
+
+inline uint64_t read_stop()
+{
+    assert(0 && "The time-stamp counter is not available");
+    return 0;
+}
+
+#endif
+}
+
+tsc_clock::tsc_clock() :
+    m_nanoseconds_per_tick(1e9 / calibrate().m_frequency)
+{
+    assert(is_available());
+}
+
+bool tsc_clock::is_available()
+{
+#if defined(GAUGE_TSC_AVAILABLE)
+    return true;
+#else
+    return false;
+#endif
+}
+
+const tsc_clock::calibration& tsc_clock::calibrate()
+{
+    static calibration c = []()
+    {
+        calibration result = { 1e9, false, false, 0.0 };
+
+#if defined(GAUGE_TSC_AVAILABLE)
+        result.m_frequency = measure_frequency();
+        result.m_invariant = is_invariant();
+        result.m_synchronized = true;
+        check_synchronization(result);
+
+        if (!result.m_invariant)
+        {
+            std::cerr << "Warning: the time-stamp counter is not invariant, "
+                      << "tsc measurements are affected by frequency "
+                      << "scaling" << std::endl;
+        }
+
+        if (!result.m_synchronized)
+        {
+            std::cerr << "Warning: the time-stamp counters are not "
+                      << "synchronized across cores (skew up to "
+                      << result.m_max_skew << " ns), pin the benchmark "
+                      << "to a single core when using the tsc clock"
+                      << std::endl;
+        }
+#endif
+        return result;
+    }();
+
+    return c;
+}
+
+std::string tsc_clock::name() const
+{
+    return "tsc";
+}
+
+uint64_t tsc_clock::start()
+{
+    return read_start();
+}
+
+uint64_t tsc_clock::stop()
+{
+    return read_stop();
+}
+
+double tsc_clock::nanoseconds(uint64_t ticks) const
+{
+    return ticks * m_nanoseconds_per_tick;
+}
+}
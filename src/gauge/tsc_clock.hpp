@@ -0,0 +1,79 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "clock.hpp"
+
+namespace gauge
+{
+/// Clock reading the x86 time-stamp counter. The counter is read with
+/// rdtsc fenced by lfence when starting and with rdtscp followed by
+/// lfence when stopping, so the measured instructions can neither
+/// start before nor retire after the interval.
+///
+/// The counter frequency is measured against std::chrono::steady_clock
+/// the first time the clock is used.
+class tsc_clock : public clock
+{
+public:
+
+    /// The result of calibrating the time-stamp counter
+    struct calibration
+    {
+        /// The measured counter frequency in Hz
+        double m_frequency;
+
+        /// True if the CPU reports an invariant time-stamp counter i.e.
+        /// it ticks at a constant rate independent of power states
+        bool m_invariant;
+
+        /// True if the counters of all the CPU cores we may run on
+        /// were found to be synchronized
+        bool m_synchronized;
+
+        /// The largest offset in nanoseconds observed between the
+        /// counter of a core and the counter of the first core
+        double m_max_skew;
+    };
+
+public:
+
+    /// Constructor, runs the calibration if it has not already been
+    /// done and prints a warning if the counter is unreliable.
+    tsc_clock();
+
+    /// @return true if the time-stamp counter can be used on this
+    ///         platform
+    static bool is_available();
+
+    /// @return the calibration of the time-stamp counter. The
+    ///         calibration runs once and the result is cached.
+    static const calibration& calibrate();
+
+public:
+    // From clock
+
+    /// @copydoc clock::name() const
+    std::string name() const;
+
+    /// @copydoc clock::start()
+    uint64_t start();
+
+    /// @copydoc clock::stop()
+    uint64_t stop();
+
+    /// @copydoc clock::nanoseconds(uint64_t) const
+    double nanoseconds(uint64_t ticks) const;
+
+private:
+
+    /// The number of nanoseconds per tick
+    double m_nanoseconds_per_tick;
+};
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include "benchmark.hpp"
+#include "runner.hpp"
+
+namespace gauge
+{
+/// Scoped guard pausing the measurement of the runner's current benchmark
+/// for its lifetime. Used inside the RUN loop to exclude work which must
+/// be done in every iteration, e.g. resetting the input.
+///
+/// Example:
+///
+///    RUN
+///    {
+///        {
+///            gauge::untimed guard;
+///            std::shuffle(data.begin(), data.end(), generator);
+///        }
+///
+///        std::sort(data.begin(), data.end());
+///    }
+///
+class untimed
+{
+public:
+
+    /// Pauses the measurement of the runner's current benchmark
+    untimed() :
+        untimed(*gauge::runner::instance().current_benchmark())
+    { }
+
+    /// Pauses the measurement of a specific benchmark
+    /// @param benchmark the benchmark to pause
+    explicit untimed(benchmark& benchmark) :
+        m_benchmark(benchmark)
+    {
+        m_benchmark.pause();
+    }
+
+    /// Resumes the measurement
+    ~untimed()
+    {
+        m_benchmark.resume();
+    }
+
+    untimed(const untimed&) = delete;
+    untimed& operator=(const untimed&) = delete;
+
+private:
+
+    /// The paused benchmark
+    benchmark& m_benchmark;
+};
+}
@@ -0,0 +1,22 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <gauge/gauge.hpp>
+
+#include <string>
+
+/// A benchmark which is never run, for testing the code which is given
+/// a benchmark e.g. the printers and the counters
+struct dummy_benchmark : public gauge::benchmark
+{
+    void store_run(tables::table&) { }
+    uint32_t runs() const { return 1; }
+    void start() { }
+    void stop() { }
+    std::string unit_text() const { return "dummies"; }
+    void test_body() { }
+};
@@ -0,0 +1,52 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#pragma once
+
+#include <gauge/gauge.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Keeps the results published by the runner
+struct collecting_printer : public gauge::printer
+{
+    collecting_printer() :
+        gauge::printer("collecting")
+    { }
+
+    void benchmark_result(const gauge::benchmark&,
+                          const tables::table& results)
+    {
+        m_results.push_back(results);
+    }
+
+    std::vector<tables::table> m_results;
+};
+
+/// Runs the benchmarks with the given command-line options, which should
+/// select them with --gauge_filter
+/// @param options The options
+/// @return the results published by the runner
+inline std::vector<tables::table> run_with_options(
+    const std::vector<std::string>& options)
+{
+    static auto printer = std::make_shared<collecting_printer>();
+    printer->m_results.clear();
+
+    auto& printers = gauge::runner::instance().printers();
+    printers.push_back(printer);
+
+    std::vector<const char*> argv = { "program", "--warmup_time=0" };
+    for (const auto& o : options)
+        argv.push_back(o.c_str());
+
+    gauge::runner::instance().run_unsafe((int)argv.size(), argv.data());
+
+    printers.erase(std::find(printers.begin(), printers.end(), printer));
+    return printer->m_results;
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/allocation_hooks.hpp>
+#include <gauge/allocation_tracker.hpp>
+#include <gauge/gauge.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(test_allocation_tracker, count)
+{
+    EXPECT_TRUE(gauge::allocation_tracker::is_available());
+
+    gauge::allocation_tracker::start();
+
+    auto value = new uint64_t(42);
+    gauge::do_not_optimize(value);
+    delete value;
+
+    gauge::allocation_tracker::pause();
+    std::unique_ptr<uint32_t> untracked(new uint32_t(1));
+    gauge::allocation_tracker::resume();
+
+    gauge::allocation_tracker::stop();
+
+    // Stopped so this is not counted, not even after a resume()
+    std::vector<uint8_t> ignored(100);
+    gauge::allocation_tracker::resume();
+    std::vector<uint8_t> also_ignored(100);
+    gauge::allocation_tracker::pause();
+
+    auto counts = gauge::allocation_tracker::counts();
+    EXPECT_EQ(1U, counts.m_allocations);
+    EXPECT_EQ(1U, counts.m_frees);
+    EXPECT_EQ(sizeof(uint64_t), counts.m_bytes);
+}
+
+TEST(test_allocation_tracker, other_threads)
+{
+    std::atomic<bool> done(false);
+    std::atomic<uint32_t> allocated(0);
+
+    std::thread other([&done, &allocated]
+    {
+        while (!done)
+        {
+            std::unique_ptr<uint64_t> value(new uint64_t(42));
+            gauge::do_not_optimize(value.get());
+            ++allocated;
+        }
+    });
+
+    while (allocated < 10)
+        std::this_thread::yield();
+
+    // Only the allocations of this thread are counted
+    gauge::allocation_tracker::start();
+
+    uint32_t before = allocated;
+    while (allocated < before + 100)
+        std::this_thread::yield();
+
+    gauge::allocation_tracker::stop();
+
+    done = true;
+    other.join();
+
+    auto counts = gauge::allocation_tracker::counts();
+    EXPECT_EQ(0U, counts.m_allocations);
+    EXPECT_EQ(0U, counts.m_frees);
+    EXPECT_EQ(0U, counts.m_bytes);
+}
+
+struct allocation_benchmark : public gauge::time_benchmark
+{
+    bool track_allocations() const
+    {
+        return true;
+    }
+
+    void store_run(tables::table& results)
+    {
+        gauge::time_benchmark::store_run(results);
+
+        auto allocations = results.values_as<double>("allocations");
+        auto frees = results.values_as<double>("frees");
+        auto bytes = results.values_as<double>("allocated_bytes");
+
+        EXPECT_EQ(m_allocations, allocations.back());
+        EXPECT_EQ(m_allocations, frees.back());
+        EXPECT_EQ(m_allocations * 64, bytes.back());
+    }
+
+    void run(uint32_t allocations)
+    {
+        m_allocations = allocations;
+
+        RUN
+        {
+            for (uint32_t i = 0; i < allocations; ++i)
+            {
+                std::vector<uint8_t> buffer(64);
+                gauge::do_not_optimize(buffer.data());
+            }
+        }
+    }
+
+    uint32_t m_allocations;
+};
+
+BENCHMARK_F_INLINE(allocation_benchmark, allocations, none, 3)
+{
+    run(0);
+}
+
+BENCHMARK_F_INLINE(allocation_benchmark, allocations, two, 3)
+{
+    run(2);
+}
@@ -0,0 +1,171 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gauge/baseline.hpp>
+#include <gauge/gauge.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "run_with_options.hpp"
+
+TEST(test_baseline, read_json)
+{
+    const char* filename = "test_baseline.json";
+    {
+        std::ofstream file(filename);
+        file << "[{\"benchmark\": \"decode\", \"testcase\": \"coder\", "
+             << "\"symbols\": 16, \"time\": [1.5, 2.5, 2.0]},\n"
+             << " {\"benchmark\": \"decode\", \"testcase\": \"coder\", "
+             << "\"symbols\": 32, \"time\": [4.0, 5.0]}]";
+    }
+
+    auto rows = gauge::read_result_file(filename);
+    std::remove(filename);
+
+    ASSERT_EQ(5U, rows.size());
+
+    gauge::result_row key = { { "testcase", "coder" },
+                              { "benchmark", "decode" },
+                              { "symbols", "32" } };
+
+    std::vector<double> expected = { 4.0, 5.0 };
+    EXPECT_EQ(expected, gauge::baseline_values(rows, key, "time"));
+
+    key["symbols"] = "64";
+    EXPECT_TRUE(gauge::baseline_values(rows, key, "time").empty());
+}
+
+TEST(test_baseline, read_csv)
+{
+    const char* filename = "test_baseline.csv";
+    {
+        std::ofstream file(filename);
+        file << "benchmark,testcase,time,type\n"
+             << "decode,coder,1.5,\"a,b\"\n"
+             << "decode,coder,2.5,\"a,b\"\n"
+             << "encode,coder,7.0,\"a,b\"\n";
+    }
+
+    auto rows = gauge::read_result_file(filename);
+    std::remove(filename);
+
+    ASSERT_EQ(3U, rows.size());
+
+    gauge::result_row key = { { "testcase", "coder" },
+                              { "benchmark", "decode" },
+                              { "type", "a,b" } };
+
+    std::vector<double> expected = { 1.5, 2.5 };
+    EXPECT_EQ(expected, gauge::baseline_values(rows, key, "time"));
+}
+
+TEST(test_baseline, compare_samples)
+{
+    std::vector<double> baseline;
+    std::vector<double> same;
+    std::vector<double> slower;
+
+    for (uint32_t i = 0; i < 20; ++i)
+    {
+        baseline.push_back(100.0 + i % 5);
+        same.push_back(100.0 + (i + 2) % 5);
+        slower.push_back(110.0 + i % 5);
+    }
+
+    auto c = gauge::compare_samples(baseline, same);
+    EXPECT_DOUBLE_EQ(1.0, c.m_ratio);
+    EXPECT_GT(c.m_p_value, 0.5);
+
+    c = gauge::compare_samples(baseline, slower);
+    EXPECT_NEAR(1.098, c.m_ratio, 0.001);
+    EXPECT_LT(c.m_p_value, 0.001);
+}
+
+BENCHMARK(baseline, sleep, 8)
+{
+    RUN
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+}
+
+TEST(test_baseline, regressions_are_reset)
+{
+    const char* filename = "test_baseline_sleep.csv";
+    {
+        // A baseline far faster than the benchmark
+        std::ofstream file(filename);
+        file << "benchmark,testcase,time\n";
+        for (uint32_t i = 0; i < 8; ++i)
+            file << "sleep,baseline," << (0.001 + i * 0.0001) << "\n";
+    }
+
+    std::string baseline = std::string("--baseline=") + filename;
+    std::vector<const char*> with_baseline =
+        { "program", "--gauge_filter=baseline.sleep", "--warmup_time=0",
+          baseline.c_str() };
+    std::vector<const char*> without_baseline =
+        { "program", "--gauge_filter=baseline.sleep", "--warmup_time=0" };
+
+    auto& runner = gauge::runner::instance();
+    EXPECT_THROW(runner.run_unsafe((int)with_baseline.size(),
+                                   with_baseline.data()),
+                 std::runtime_error);
+    std::remove(filename);
+
+    // Neither the regression nor the baseline is kept for the next run
+    EXPECT_NO_THROW(runner.run_unsafe((int)without_baseline.size(),
+                                      without_baseline.data()));
+}
+
+TEST(test_baseline, copies)
+{
+    const char* filename = "test_baseline_copies.csv";
+
+    // The baseline is written from a run with two copies, which are made
+    // far slower, so the single copy must be compared with the single
+    // copy only
+    auto written = run_with_options(
+        { "--gauge_filter=baseline.sleep", "--copies=2" });
+    ASSERT_EQ(2U, written.size());
+    {
+        std::ofstream file(filename);
+        file << "benchmark,testcase,copies,time\n";
+        for (const auto& results : written)
+        {
+            uint32_t copies = results.values_as<uint32_t>("copies").front();
+            for (auto time : results.values_as<double>("time"))
+            {
+                file << "sleep,baseline," << copies << ","
+                     << (copies == 1 ? time : time * 1000) << "\n";
+            }
+        }
+    }
+
+    auto results = run_with_options(
+        { "--gauge_filter=baseline.sleep", "--copies=2",
+          std::string("--baseline=") + filename });
+    std::remove(filename);
+
+    ASSERT_EQ(2U, results.size());
+    ASSERT_TRUE(results[0].has_column("baseline_ratio"));
+    ASSERT_TRUE(results[1].has_column("baseline_ratio"));
+
+    double single = results[0].values_as<double>("baseline_ratio").front();
+    EXPECT_GT(single, 0.2);
+    EXPECT_LT(single, 5.0);
+
+    double copies = results[1].values_as<double>("baseline_ratio").front();
+    EXPECT_LT(copies, 0.01);
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/clock.hpp>
+#include <gauge/gauge.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+TEST(test_clock, available_clocks)
+{
+    auto names = gauge::clock_names();
+    EXPECT_FALSE(names.empty());
+
+    for (const auto& name : names)
+    {
+        auto clock = gauge::make_clock(name);
+        ASSERT_TRUE((bool)clock);
+        EXPECT_EQ(name, clock->name());
+
+        uint64_t start = clock->start();
+        uint64_t stop = clock->stop();
+        EXPECT_GE(stop, start);
+        EXPECT_GE(clock->nanoseconds(stop - start), 0.0);
+    }
+}
+
+TEST(test_clock, unknown_clock)
+{
+    EXPECT_THROW(gauge::make_clock("sundial"), std::runtime_error);
+}
+
+TEST(test_clock, wall_clocks_measure_sleep)
+{
+    for (const auto& name : gauge::clock_names())
+    {
+        // The CPU time clocks do not advance while we sleep
+        if (name == "thread_cputime" || name == "process_cputime")
+            continue;
+
+        auto clock = gauge::make_clock(name);
+
+        uint64_t start = clock->start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        uint64_t stop = clock->stop();
+
+        // The sleep may end a little earlier on Windows
+        EXPECT_GE(clock->nanoseconds(stop - start), 2000000 * 0.99)
+            << name;
+    }
+}
+
+TEST(test_clock, measure_clock)
+{
+    for (const auto& name : gauge::clock_names())
+    {
+        auto clock = gauge::make_clock(name);
+        const auto& properties = gauge::measure_clock(*clock);
+
+        EXPECT_GT(properties.m_resolution, 0.0) << name;
+        EXPECT_GT(properties.m_read_cost, 0.0) << name;
+
+        // The properties are only measured once per clock
+        auto other = gauge::make_clock(name);
+        EXPECT_EQ(&properties, &gauge::measure_clock(*other)) << name;
+    }
+}
+
+/// Benchmark forcing a specific clock independent of the --clock option
+struct steady_clock_benchmark : public gauge::time_benchmark
+{
+    std::string clock_name() const
+    {
+        return "steady";
+    }
+
+    void store_run(tables::table& results)
+    {
+        gauge::time_benchmark::store_run(results);
+        EXPECT_EQ("steady", results.values_as<std::string>("clock")[0]);
+    }
+
+    void test_body()
+    {
+        RUN
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+};
+
+BENCHMARK_F(steady_clock_benchmark, clock, steady, 1);
@@ -0,0 +1,135 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/allocation_tracker.hpp>
+#include <gauge/copy_rate.hpp>
+#include <gauge/gauge.hpp>
+#include <gauge/statistics.hpp>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "run_with_options.hpp"
+
+TEST(test_copies, calculate_copy_rate)
+{
+    gauge::copy_rate result;
+
+    // Two copies taking 100 and 200 microseconds per run, the single
+    // copy took 100
+    ASSERT_TRUE(gauge::calculate_copy_rate({ 100.0, 200.0 }, 100.0, result));
+    EXPECT_DOUBLE_EQ(15000.0, result.m_rate);
+    ASSERT_TRUE(result.m_has_single);
+    EXPECT_DOUBLE_EQ(10000.0, result.m_rate_single);
+    EXPECT_DOUBLE_EQ(50.0, result.m_degradation);
+    EXPECT_DOUBLE_EQ(100.0, result.m_degradation_max);
+
+    // Copies running faster than the single copy
+    ASSERT_TRUE(gauge::calculate_copy_rate({ 80.0, 80.0 }, 100.0, result));
+    EXPECT_DOUBLE_EQ(25000.0, result.m_rate);
+    EXPECT_DOUBLE_EQ(-20.0, result.m_degradation);
+    EXPECT_DOUBLE_EQ(-20.0, result.m_degradation_max);
+
+    // Copies without a time are left out
+    ASSERT_TRUE(gauge::calculate_copy_rate({ 0.0, 50.0 }, 50.0, result));
+    EXPECT_DOUBLE_EQ(20000.0, result.m_rate);
+    EXPECT_DOUBLE_EQ(0.0, result.m_degradation);
+
+    // Without the single copy there is nothing to compare with
+    ASSERT_TRUE(gauge::calculate_copy_rate({ 100.0 }, -1.0, result));
+    EXPECT_DOUBLE_EQ(10000.0, result.m_rate);
+    EXPECT_FALSE(result.m_has_single);
+
+    EXPECT_FALSE(gauge::calculate_copy_rate({ }, 100.0, result));
+    EXPECT_FALSE(gauge::calculate_copy_rate({ 0.0 }, 100.0, result));
+}
+
+struct copy_benchmark : public gauge::time_benchmark
+{
+    bool track_allocations() const
+    {
+        return true;
+    }
+
+    void store_run(tables::table& results)
+    {
+        gauge::time_benchmark::store_run(results);
+
+        // Every copy counts its own allocations, which the copies
+        // running at the same time must not disturb
+        if (gauge::allocation_tracker::is_available())
+        {
+            EXPECT_EQ(2.0, results.values_as<double>("allocations").back());
+            EXPECT_EQ(2.0, results.values_as<double>("frees").back());
+        }
+    }
+};
+
+BENCHMARK_F_INLINE(copy_benchmark, copies, allocate, 3)
+{
+    RUN
+    {
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            std::vector<uint8_t> buffer(64);
+            gauge::do_not_optimize(buffer.data());
+        }
+    }
+}
+
+TEST(test_copies, rate)
+{
+    auto results = run_with_options(
+        { "--gauge_filter=copies.allocate", "--copies=2",
+          "--track_allocations" });
+
+    // The single copy and then the copies
+    ASSERT_EQ(2U, results.size());
+    EXPECT_EQ(1U, results[0].values_as<uint32_t>("copies").front());
+
+    const auto& copies = results[1];
+    EXPECT_EQ(6U, copies.rows());
+    EXPECT_EQ(2U, copies.values_as<uint32_t>("copies").front());
+
+    // The runs of every copy
+    auto copy = copies.values_as<uint32_t>("copy");
+    auto time = copies.values_as<double>("time");
+    std::map<uint32_t, std::vector<double>> times;
+    for (uint32_t row = 0; row < copies.rows(); ++row)
+        times[copy[row]].push_back(time[row]);
+
+    ASSERT_EQ(2U, times.size());
+    EXPECT_EQ(3U, times[0].size());
+    EXPECT_EQ(3U, times[1].size());
+
+    // The columns are calculated from the median times
+    auto single_times = results[0].values_as<double>("time");
+    double single_time = gauge::median(single_times);
+
+    std::vector<double> copy_times;
+    for (auto& t : times)
+        copy_times.push_back(gauge::median(t.second));
+
+    gauge::copy_rate expected;
+    ASSERT_TRUE(gauge::calculate_copy_rate(copy_times, single_time,
+                                           expected));
+
+    ASSERT_TRUE(copies.has_column("rate"));
+    ASSERT_TRUE(copies.has_column("rate_single"));
+    ASSERT_TRUE(copies.has_column("degradation"));
+    ASSERT_TRUE(copies.has_column("degradation_max"));
+
+    EXPECT_DOUBLE_EQ(expected.m_rate,
+                     copies.values_as<double>("rate").front());
+    EXPECT_DOUBLE_EQ(1e6 / single_time,
+                     copies.values_as<double>("rate_single").front());
+    EXPECT_DOUBLE_EQ(expected.m_degradation,
+                     copies.values_as<double>("degradation").front());
+    EXPECT_DOUBLE_EQ(expected.m_degradation_max,
+                     copies.values_as<double>("degradation_max").front());
+}
@@ -0,0 +1,106 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/gauge.hpp>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dummy_benchmark.hpp"
+
+struct counter_benchmark : public gauge::time_benchmark
+{
+    void store_run(tables::table& results)
+    {
+        gauge::time_benchmark::store_run(results);
+
+        // The runner stores the counters after store_run(), so we check
+        // the runs stored before this one
+        if (!results.has_column("runs"))
+            return;
+
+        auto iterations = results.values_as<uint64_t>("iterations");
+        auto runs = results.values("runs");
+        auto bytes = results.values("bytes_per_run");
+        auto throughput = results.values("throughput");
+        auto items = results.values("items_per_second");
+
+        for (uint32_t i = 0; i + 1 < results.rows(); ++i)
+        {
+            EXPECT_EQ(double(iterations[i]), boost::any_cast<double>(runs[i]));
+            EXPECT_EQ(1000.0, boost::any_cast<double>(bytes[i]));
+
+            // Both are the same rate in different units
+            EXPECT_NEAR(boost::any_cast<double>(throughput[i]) * 1e6 / 1000,
+                        boost::any_cast<double>(items[i]) / 10,
+                        boost::any_cast<double>(items[i]) * 1e-9);
+        }
+    }
+
+    void test_body()
+    {
+        std::vector<uint8_t> data(1000, 1);
+
+        set_bytes_processed(data.size());
+        set_items_processed(10);
+
+        double& runs = counter("runs");
+        double& bytes = counter("bytes_per_run",
+                                gauge::counter_mode::average);
+        double& rate = counter("runs_per_second", gauge::counter_mode::rate);
+
+        RUN
+        {
+            uint32_t sum = 0;
+            for (auto d : data)
+                sum += d;
+
+            gauge::do_not_optimize(sum);
+
+            runs += 1;
+            bytes += 1000;
+            rate += 1;
+        }
+    }
+};
+
+BENCHMARK_F(counter_benchmark, counters, sum, 3);
+
+TEST(test_counters, store_counters)
+{
+    dummy_benchmark benchmark;
+    benchmark.set_bytes_processed(1000);
+    benchmark.set_items_processed(10);
+
+    double& runs = benchmark.counter("runs");
+    runs = 100;
+    benchmark.counter("bytes_per_run", gauge::counter_mode::average) = 500;
+
+    EXPECT_EQ("megabytes/second", benchmark.column_unit("throughput"));
+    EXPECT_EQ("items/second", benchmark.column_unit("items_per_second"));
+    EXPECT_EQ("runs", benchmark.column_unit("runs"));
+    EXPECT_EQ("bytes_per_run/iteration",
+              benchmark.column_unit("bytes_per_run"));
+    EXPECT_EQ("dummies", benchmark.column_unit("other"));
+
+    // Without an elapsed time no rates are stored
+    tables::table results;
+    results.add_row();
+    benchmark.store_counters(results, 100);
+
+    EXPECT_FALSE(results.has_column("throughput"));
+    EXPECT_FALSE(results.has_column("items_per_second"));
+    EXPECT_EQ(100.0, results.values_as<double>("runs").back());
+    EXPECT_EQ(5.0, results.values_as<double>("bytes_per_run").back());
+
+    benchmark.reset_counters();
+    EXPECT_EQ(0.0, benchmark.counter("runs"));
+
+    // The reference stays valid when counters are reset or added
+    benchmark.counter("other") = 1;
+    runs += 7;
+    EXPECT_EQ(7.0, benchmark.counter("runs"));
+}
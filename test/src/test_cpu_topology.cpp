@@ -0,0 +1,71 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <gauge/cpu_topology.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(test_cpu_topology, parse_cpu_list)
+{
+    EXPECT_EQ(std::vector<uint32_t>({ 0, 1, 2, 3, 8, 10, 11 }),
+              gauge::parse_cpu_list("0-3,8,10-11\n"));
+
+    EXPECT_EQ(std::vector<uint32_t>({ 5 }), gauge::parse_cpu_list("5"));
+    EXPECT_TRUE(gauge::parse_cpu_list("").empty());
+}
+
+TEST(test_cpu_topology, scaling_thread_counts)
+{
+    EXPECT_EQ(std::vector<uint32_t>({ 1 }),
+              gauge::scaling_thread_counts(1, 1));
+
+    EXPECT_EQ(std::vector<uint32_t>({ 1, 2, 4, 6, 12 }),
+              gauge::scaling_thread_counts(6, 12));
+
+    EXPECT_EQ(std::vector<uint32_t>({ 1, 2, 4, 8 }),
+              gauge::scaling_thread_counts(8, 8));
+}
+
+TEST(test_cpu_topology, cpu_order)
+{
+    auto allowed = gauge::allowed_cpus();
+    auto order = gauge::cpu_order();
+
+    ASSERT_FALSE(allowed.empty());
+
+    // The order is a permutation of the allowed CPUs
+    EXPECT_EQ(allowed.size(), order.size());
+    EXPECT_TRUE(std::is_permutation(order.begin(), order.end(),
+                                    allowed.begin()));
+
+    // The cores come first and no core is listed twice among them
+    uint32_t cores = gauge::physical_core_count();
+    EXPECT_LE(cores, order.size());
+
+    for (uint32_t i = 0; i < cores; ++i)
+    {
+        for (uint32_t sibling : gauge::smt_siblings(order[i]))
+        {
+            if (sibling == order[i])
+                continue;
+
+            EXPECT_EQ(order.begin() + cores,
+                      std::find(order.begin(), order.begin() + cores,
+                                sibling));
+        }
+    }
+}
+
+TEST(test_cpu_topology, select_measurement_cpu)
+{
+    auto allowed = gauge::allowed_cpus();
+    uint32_t cpu = gauge::select_measurement_cpu();
+
+    EXPECT_NE(allowed.end(), std::find(allowed.begin(), allowed.end(), cpu));
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/gauge.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+/// A dependency chain with a barrier in every step
+uint64_t chain_with_barrier()
+{
+    uint64_t x = 3;
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        x = x * x + i;
+        gauge::do_not_optimize(x);
+    }
+    return x;
+}
+
+/// The same dependency chain without the barriers
+uint64_t chain()
+{
+    uint64_t x = 3;
+    for (uint32_t i = 0; i < 1000; ++i)
+        x = x * x + i;
+    return x;
+}
+}
+
+TEST(test_do_not_optimize, keeps_chain)
+{
+    // The compiler must assume that the barrier changes the value, but
+    // the value computed with it is the same
+    EXPECT_EQ(chain(), chain_with_barrier());
+}
+
+TEST(test_do_not_optimize, keeps_values)
+{
+    uint32_t number = 42;
+    gauge::do_not_optimize(number);
+    EXPECT_EQ(42U, number);
+
+    const double constant = 1.5;
+    gauge::do_not_optimize(constant);
+    EXPECT_EQ(1.5, constant);
+
+    float fraction = 0.25f;
+    gauge::do_not_optimize(fraction);
+    EXPECT_EQ(0.25f, fraction);
+
+    // Values which do not fit a register
+    std::array<uint64_t, 8> array = {{ 1, 2, 3, 4, 5, 6, 7, 8 }};
+    gauge::do_not_optimize(array);
+    EXPECT_EQ(8U, array[7]);
+
+    std::string text = "gauge";
+    gauge::do_not_optimize(text);
+    EXPECT_EQ("gauge", text);
+}
+
+TEST(test_do_not_optimize, clobber_memory)
+{
+    std::array<uint32_t, 16> buffer;
+    buffer.fill(0);
+
+    for (uint32_t i = 0; i < buffer.size(); ++i)
+    {
+        buffer[i] = i;
+        gauge::clobber_memory();
+    }
+
+    EXPECT_EQ(15U, buffer[15]);
+}
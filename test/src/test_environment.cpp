@@ -0,0 +1,89 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include <gauge/environment.hpp>
+
+#include <tables/table.hpp>
+
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+    #include <sys/prctl.h>
+#endif
+
+TEST(test_environment, default_request)
+{
+    gauge::environment_request request;
+
+    // Nothing is requested, so nothing changes and nothing is stored
+    gauge::previous_environment previous;
+    auto effective = gauge::apply_environment(request, previous);
+
+    EXPECT_EQ(-1, effective.m_cpu);
+    EXPECT_EQ("default", effective.m_scheduler);
+    EXPECT_FALSE(effective.m_memory_locked);
+    EXPECT_FALSE(previous.m_pinned);
+    EXPECT_FALSE(previous.m_scheduled);
+    EXPECT_FALSE(previous.m_niced);
+    EXPECT_FALSE(previous.m_memory_locked);
+    EXPECT_FALSE(previous.m_slack_changed);
+
+    tables::table results;
+    gauge::store_environment(results, request, effective);
+    EXPECT_TRUE(results.columns().empty());
+}
+
+TEST(test_environment, store_environment)
+{
+    gauge::environment_request request;
+    request.m_cpu = 2;
+    request.m_fifo_priority = 10;
+    request.m_lock_memory = true;
+
+    // The lock was not permitted
+    gauge::environment effective;
+    effective.m_cpu = 2;
+    effective.m_scheduler = "fifo 10";
+
+    tables::table results;
+    gauge::store_environment(results, request, effective);
+    results.add_row();
+
+    EXPECT_TRUE(results.is_constant("pinned_cpu"));
+    EXPECT_EQ(2, results.values_as<int32_t>("pinned_cpu").front());
+    EXPECT_EQ("fifo 10",
+              results.values_as<std::string>("scheduler").front());
+    EXPECT_EQ("no",
+              results.values_as<std::string>("memory_locked").front());
+    EXPECT_FALSE(results.has_column("timer_slack"));
+}
+
+#if defined(__linux__)
+TEST(test_environment, timer_slack)
+{
+    // Applied on a thread of its own, the settings are per thread
+    std::thread thread([]
+    {
+        int slack = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+        ASSERT_GT(slack, 0);
+
+        gauge::environment_request request;
+        request.m_timer_slack = slack + 1000;
+
+        gauge::previous_environment previous;
+        auto effective = gauge::apply_environment(request, previous);
+        EXPECT_EQ(slack + 1000U, effective.m_timer_slack);
+
+        // The thread gets its timer slack back
+        gauge::restore_environment(previous);
+        EXPECT_EQ(slack, prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0));
+    });
+    thread.join();
+}
+#endif
@@ -0,0 +1,258 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gauge/history.hpp>
+#include <gauge/history_printer.hpp>
+
+#include <gtest/gtest.h>
+
+#include "dummy_benchmark.hpp"
+
+TEST(test_history, append_and_query)
+{
+    const std::string directory = "test_history_store";
+
+    gauge::history_entry decode;
+    decode.m_benchmark = "coder.decode";
+    decode.m_config = "symbols=16";
+    decode.m_machine = gauge::machine_fingerprint();
+    decode.m_revision = "r1";
+    decode.m_timestamp = 1000;
+    decode.m_columns["time"] = { 1.0, 2.0, 3.0 };
+
+    gauge::history_entry encode = decode;
+    encode.m_benchmark = "coder.encode";
+    encode.m_columns["time"] = { 4.0 };
+
+    gauge::history_store store(directory);
+    store.append({ decode, encode });
+
+    decode.m_revision = "r2";
+    store.append({ decode });
+
+    auto entries = store.query("coder.dec*");
+    ASSERT_EQ(2U, entries.size());
+    EXPECT_EQ("r1", entries[0].m_revision);
+    EXPECT_EQ("r2", entries[1].m_revision);
+    EXPECT_EQ("symbols=16", entries[1].m_config);
+    EXPECT_EQ(1000U, entries[1].m_timestamp);
+    EXPECT_EQ(decode.m_columns, entries[1].m_columns);
+
+    EXPECT_EQ(3U, store.query("*.*").size());
+    EXPECT_TRUE(store.query("other.*").empty());
+
+    // Appends within the same microsecond must not overwrite a segment
+    for (uint32_t i = 0; i < 20; ++i)
+        store.append({ encode });
+
+    EXPECT_EQ(21U, store.query("coder.encode").size());
+
+    // Clean up the segments listed in the index
+    std::vector<std::string> segments;
+    {
+        std::ifstream index(directory + "/index");
+        std::string line;
+        while (std::getline(index, line))
+        {
+            auto end = line.rfind('\t');
+            auto begin = line.rfind('\t', end - 1) + 1;
+            segments.push_back(line.substr(begin, end - begin));
+        }
+    }
+    for (const auto& s : segments)
+        std::remove((directory + "/" + s).c_str());
+    std::remove((directory + "/index").c_str());
+    std::remove(directory.c_str());
+}
+
+TEST(test_history, incomplete_index_line)
+{
+    const std::string directory = "test_history_incomplete";
+
+    gauge::history_entry entry;
+    entry.m_benchmark = "coder.decode";
+    entry.m_machine = gauge::machine_fingerprint();
+    entry.m_timestamp = 1000;
+    entry.m_columns["time"] = { 1.0 };
+
+    gauge::history_store store(directory);
+    store.append({ entry, entry });
+
+    // A crash while the index was extended leaves a partly written line,
+    // here the second line cut inside its offset
+    std::string line;
+    {
+        std::ifstream index(directory + "/index");
+        std::getline(index, line);
+        std::getline(index, line);
+    }
+    ASSERT_GT(line.size() - line.rfind('\t'), 2U);
+    {
+        std::ofstream index(directory + "/index", std::ios::app);
+        index << line.substr(0, line.size() - 1);
+    }
+
+    EXPECT_EQ(2U, store.query("*").size());
+
+    // The next append removes the incomplete line instead of ending it,
+    // which would make the cut offset look valid
+    store.append({ entry });
+    EXPECT_EQ(3U, store.query("*").size());
+
+    std::vector<std::string> segments;
+    {
+        std::ifstream index(directory + "/index");
+        std::string line;
+        while (std::getline(index, line))
+        {
+            auto end = line.rfind('\t');
+            if (end == std::string::npos || end == 0)
+                continue;
+            auto begin = line.rfind('\t', end - 1) + 1;
+            segments.push_back(line.substr(begin, end - begin));
+        }
+    }
+    for (const auto& s : segments)
+        std::remove((directory + "/" + s).c_str());
+    std::remove((directory + "/index").c_str());
+    std::remove(directory.c_str());
+}
+
+TEST(test_history, escaped_fields)
+{
+    const std::string directory = "test_history_escaped";
+
+    gauge::history_entry entry;
+    entry.m_benchmark = "coder.decode";
+    entry.m_config = "name=a\tb\nc\\d";
+    entry.m_machine = gauge::machine_fingerprint();
+    entry.m_revision = "r1\nr2";
+    entry.m_timestamp = 1000;
+    entry.m_columns["time"] = { 1.0 };
+
+    gauge::history_store store(directory);
+    store.append({ entry, entry });
+
+    // A tab or newline does not break up the line of the entry
+    auto entries = store.query("coder.decode");
+    ASSERT_EQ(2U, entries.size());
+    EXPECT_EQ(entry.m_config, entries[1].m_config);
+    EXPECT_EQ(entry.m_revision, entries[1].m_revision);
+
+    std::string line;
+    {
+        std::ifstream index(directory + "/index");
+        std::getline(index, line);
+    }
+    auto end = line.rfind('\t');
+    auto begin = line.rfind('\t', end - 1) + 1;
+    std::string segment = directory + "/" + line.substr(begin, end - begin);
+
+    // A corrupt length is reported instead of being allocated
+    {
+        std::fstream file(segment,
+                          std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(4);
+        uint32_t length = 0xffffffff;
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    }
+    EXPECT_THROW(store.query("coder.decode"), std::runtime_error);
+
+    std::remove(segment.c_str());
+    std::remove((directory + "/index").c_str());
+    std::remove(directory.c_str());
+}
+
+TEST(test_history, printer_skips_excluded_runs)
+{
+    const std::string directory = "test_history_printer";
+
+    gauge::po::variables_map options;
+    auto set = [&options](const std::string& name, const boost::any& value)
+    {
+        options.insert(std::make_pair(
+            name, gauge::po::variable_value(value, false)));
+    };
+    set("use_history", true);
+    set("history_dir", directory);
+    set("revision", std::string("r1"));
+    set("outliers", std::string("exclude"));
+    set("outlier_column", std::string("time"));
+
+    gauge::history_printer printer;
+    printer.set_options(options);
+
+    // The last run is an excluded outlier and the mode column is not
+    // numeric past its first value
+    tables::table results;
+    results.add_column("time");
+    results.add_column("mode");
+    results.add_column("outlier");
+    std::vector<double> times = { 5.0, 5.1, 50.0 };
+    for (uint32_t i = 0; i < times.size(); ++i)
+    {
+        results.add_row();
+        results.set_value("time", times[i]);
+        results.set_value("outlier",
+                          std::string(i == 2 ? "high_severe" : ""));
+        if (i == 0)
+            results.set_value("mode", uint32_t(1));
+        else
+            results.set_value("mode", std::string("fast"));
+    }
+
+    dummy_benchmark info;
+    printer.start();
+    printer.benchmark_result(info, results);
+    printer.end();
+
+    auto entries = gauge::history_store(directory).query("*");
+    ASSERT_EQ(1U, entries.size());
+
+    std::vector<double> expected = { 5.0, 5.1 };
+    EXPECT_EQ(expected, entries[0].m_columns["time"]);
+    EXPECT_EQ(0U, entries[0].m_columns.count("mode"));
+
+    std::vector<std::string> segments;
+    {
+        std::ifstream index(directory + "/index");
+        std::string line;
+        while (std::getline(index, line))
+        {
+            auto end = line.rfind('\t');
+            auto begin = line.rfind('\t', end - 1) + 1;
+            segments.push_back(line.substr(begin, end - begin));
+        }
+    }
+    for (const auto& s : segments)
+        std::remove((directory + "/" + s).c_str());
+    std::remove((directory + "/index").c_str());
+    std::remove(directory.c_str());
+}
+
+TEST(test_history, detect_change_points)
+{
+    std::vector<double> series;
+    for (uint32_t i = 0; i < 20; ++i)
+        series.push_back(100.0 + (i % 3));
+    for (uint32_t i = 0; i < 20; ++i)
+        series.push_back(120.0 + (i % 3));
+
+    auto points = gauge::detect_change_points(series, 0.05);
+    ASSERT_EQ(1U, points.size());
+    EXPECT_EQ(20U, points[0].m_index);
+    EXPECT_NEAR(101.0, points[0].m_before, 0.5);
+    EXPECT_NEAR(121.0, points[0].m_after, 0.5);
+
+    // Noise alone or shifts below the threshold are not change points
+    series.resize(20);
+    EXPECT_TRUE(gauge::detect_change_points(series, 0.05).empty());
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/gauge.hpp>
+#include <gauge/latency_histogram.hpp>
+
+#include <cstdint>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+TEST(test_latency_histogram, small_values_are_exact)
+{
+    gauge::latency_histogram histogram;
+
+    for (uint64_t v = 1; v <= 100; ++v)
+        histogram.add(v);
+
+    EXPECT_EQ(100U, histogram.count());
+    EXPECT_EQ(1U, histogram.min());
+    EXPECT_EQ(100U, histogram.max());
+    EXPECT_EQ(50U, histogram.quantile(0.5));
+    EXPECT_EQ(90U, histogram.quantile(0.9));
+    EXPECT_EQ(99U, histogram.quantile(0.99));
+    EXPECT_EQ(100U, histogram.quantile(1.0));
+    EXPECT_EQ(1U, histogram.quantile(0.0));
+
+    histogram.reset();
+    EXPECT_EQ(0U, histogram.count());
+}
+
+TEST(test_latency_histogram, relative_error)
+{
+    double max_error =
+        1.0 / (1U << (gauge::latency_histogram::precision_bits - 1));
+
+    uint64_t values[] = { 255, 256, 257, 1000, 123456, 987654321,
+                          std::numeric_limits<uint64_t>::max() / 3,
+                          std::numeric_limits<uint64_t>::max() };
+
+    for (auto v : values)
+    {
+        uint32_t bucket = gauge::latency_histogram::bucket(v);
+        ASSERT_LT(bucket, gauge::latency_histogram::bucket_count());
+
+        uint64_t upper = gauge::latency_histogram::upper_bound(bucket);
+        EXPECT_GE(upper, v);
+        EXPECT_LE((upper - v) / static_cast<double>(v), max_error);
+
+        // The buckets are ordered
+        if (bucket > 0)
+        {
+            EXPECT_LT(gauge::latency_histogram::upper_bound(bucket - 1), v);
+        }
+    }
+}
+
+TEST(test_latency_histogram, tail)
+{
+    gauge::latency_histogram histogram;
+
+    for (uint32_t i = 0; i < 990; ++i)
+        histogram.add(1000);
+    for (uint32_t i = 0; i < 10; ++i)
+        histogram.add(1000000);
+
+    EXPECT_NEAR(1000.0, histogram.quantile(0.5), 1000 * 0.01);
+    EXPECT_NEAR(1000.0, histogram.quantile(0.99), 1000 * 0.01);
+    EXPECT_NEAR(1000000.0, histogram.quantile(0.999), 1000000 * 0.01);
+    EXPECT_EQ(1000000U, histogram.max());
+}
+
+/// Benchmark sampling the latency of every second iteration
+struct latency_benchmark : public gauge::time_benchmark
+{
+    uint64_t sample_interval() const
+    {
+        return 2;
+    }
+
+    void store_run(tables::table& results)
+    {
+        gauge::time_benchmark::store_run(results);
+
+        EXPECT_TRUE(results.has_column("latency_first"));
+
+        // With a single iteration only the first one is sampled
+        if (run_iterations() > 1)
+        {
+            EXPECT_TRUE(results.has_column("latency_p50"));
+            EXPECT_TRUE(results.has_column("latency_p99_9"));
+            EXPECT_TRUE(results.has_column("latency_max"));
+
+            auto p50 = results.values_as<double>("latency_p50");
+            auto max = results.values_as<double>("latency_max");
+            EXPECT_GT(p50.back(), 0.0);
+            EXPECT_LE(p50.back(), max.back());
+        }
+    }
+
+    void test_body()
+    {
+        RUN
+        {
+            uint32_t sum = 0;
+            for (uint32_t i = 0; i < 100; ++i)
+            {
+                sum = sum + i;
+                gauge::do_not_optimize(sum);
+            }
+        }
+    }
+};
+
+BENCHMARK_F(latency_benchmark, latency, sum, 3);
@@ -0,0 +1,197 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/gauge.hpp>
+
+#include <algorithm>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+/// Checks that the time per iteration of a body left without any work
+/// stays far below the microsecond of the live body
+void expect_loop_only(const tables::table& results)
+{
+    auto times = results.values_as<double>("time");
+    EXPECT_LT(*std::min_element(times.begin(), times.end()), 0.05);
+}
+}
+
+struct linearity_benchmark : public gauge::time_benchmark
+{
+    void finish_table(tables::table& results)
+    {
+        gauge::time_benchmark::finish_table(results);
+
+        ASSERT_TRUE(results.has_column("scaling"));
+        ASSERT_TRUE(results.has_column("linearity"));
+        ASSERT_TRUE(results.is_constant("scaling"));
+
+        auto scaling = results.values_as<std::string>("scaling");
+        check_scaling(scaling.front(),
+                      results.values_as<double>("linearity").front());
+    }
+
+    virtual void check_scaling(const std::string& scaling,
+                               double linearity) const = 0;
+};
+
+struct live_benchmark : public linearity_benchmark
+{
+    void check_scaling(const std::string& scaling, double linearity) const
+    {
+        EXPECT_EQ("linear", scaling) << linearity;
+    }
+
+    void test_body()
+    {
+        RUN
+        {
+            uint32_t sum = 0;
+            for (uint32_t i = 0; i < 1000; ++i)
+            {
+                sum = sum + i;
+                gauge::do_not_optimize(sum);
+            }
+        }
+    }
+};
+
+struct small_benchmark : public linearity_benchmark
+{
+    void check_scaling(const std::string& scaling, double linearity) const
+    {
+        // The body may cost less than the constant overhead, but it is
+        // there
+        EXPECT_NE("optimized_away", scaling) << linearity;
+    }
+
+    void test_body()
+    {
+        RUN
+        {
+            uint32_t sum = 0;
+            for (uint32_t i = 0; i < 10; ++i)
+            {
+                sum = sum + i;
+                gauge::do_not_optimize(sum);
+            }
+        }
+    }
+};
+
+struct nanosecond_benchmark : public linearity_benchmark
+{
+    void check_scaling(const std::string& scaling, double linearity) const
+    {
+        // A live body of a few nanoseconds grows faster than the RUN loop
+        EXPECT_NE("optimized_away", scaling) << linearity;
+    }
+
+    void test_body()
+    {
+        uint32_t value = 3;
+        RUN
+        {
+            for (uint32_t i = 0; i < 4; ++i)
+                value = value * value + 1;
+
+            gauge::do_not_optimize(value);
+        }
+    }
+};
+
+struct add_benchmark : public linearity_benchmark
+{
+    void check_scaling(const std::string& scaling, double linearity) const
+    {
+        // A single add costs about two iterations of the RUN loop, which
+        // is more than the loop varies from run to run
+        EXPECT_NE("optimized_away", scaling) << linearity;
+    }
+
+    void test_body()
+    {
+        double value = 0;
+        RUN
+        {
+            value = value + 1.0;
+            gauge::do_not_optimize(value);
+        }
+    }
+};
+
+struct empty_body_benchmark : public linearity_benchmark
+{
+    void check_scaling(const std::string&, double) const
+    {
+        // Only the RUN loop is left, which costs about as much as the
+        // calibrated loop, so the scaling may go either way
+    }
+
+    void finish_table(tables::table& results)
+    {
+        linearity_benchmark::finish_table(results);
+        expect_loop_only(results);
+    }
+
+    void test_body()
+    {
+        RUN
+        { }
+    }
+};
+
+BENCHMARK_F(live_benchmark, linearity, live, 3);
+BENCHMARK_F(small_benchmark, linearity, small, 3);
+BENCHMARK_F(nanosecond_benchmark, linearity, nanosecond, 3);
+BENCHMARK_F(add_benchmark, linearity, add, 3);
+BENCHMARK_F(empty_body_benchmark, linearity, empty, 3);
+
+// Without optimization the unused computation is not removed
+#if defined(__OPTIMIZE__)
+
+struct dead_benchmark : public linearity_benchmark
+{
+    void check_scaling(const std::string&, double) const
+    {
+        // The body is removed, only the RUN loop is left. Its growth may
+        // exceed the spread of the calibrated loop where it is compiled
+        // differently, so the time tells that the body is gone.
+    }
+
+    void finish_table(tables::table& results)
+    {
+        linearity_benchmark::finish_table(results);
+        expect_loop_only(results);
+    }
+
+    void test_body()
+    {
+        RUN
+        {
+            // The result is never used so the loop is removed
+            uint32_t sum = 0;
+            for (uint32_t i = 0; i < 1000; ++i)
+                sum = sum + i;
+        }
+    }
+};
+
+struct dead_uncorrected_benchmark : public dead_benchmark
+{
+    bool overhead_correction() const
+    {
+        // The RUN loop is still calibrated for the check
+        return false;
+    }
+};
+
+BENCHMARK_F(dead_benchmark, linearity, dead, 3);
+BENCHMARK_F(dead_uncorrected_benchmark, linearity, dead_uncorrected, 3);
+
+#endif
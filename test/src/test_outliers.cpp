@@ -0,0 +1,98 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <string>
+#include <vector>
+
+#include <tables/table.hpp>
+
+#include <gauge/outliers.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(test_outliers, classify_outliers)
+{
+    std::vector<double> values =
+        { 10.0, 10.2, 9.9, 10.1, 10.0, 9.8, 10.3, 10.1, 11.0, 20.0, 5.0 };
+
+    auto tukey = gauge::classify_outliers(values, gauge::outlier_method::tukey);
+    ASSERT_EQ(values.size(), tukey.size());
+    EXPECT_EQ("", tukey[0]);
+    EXPECT_EQ("high_mild", tukey[8]);
+    EXPECT_EQ("high_severe", tukey[9]);
+    EXPECT_EQ("low_severe", tukey[10]);
+
+    auto mad = gauge::classify_outliers(values, gauge::outlier_method::mad);
+    EXPECT_EQ("", mad[0]);
+    EXPECT_EQ("high_severe", mad[9]);
+    EXPECT_EQ("low_severe", mad[10]);
+
+    // Too few values or no spread are never classified
+    std::vector<double> few = { 1.0, 2.0, 100.0 };
+    for (const auto& c :
+         gauge::classify_outliers(few, gauge::outlier_method::tukey))
+    {
+        EXPECT_EQ("", c);
+    }
+}
+
+TEST(test_outliers, tag_outliers)
+{
+    tables::table results;
+    results.add_const_column("unit", std::string("microseconds"));
+    results.add_column("time");
+
+    std::vector<double> times = { 5.0, 5.1, 4.9, 5.0, 5.2, 50.0 };
+    for (auto t : times)
+    {
+        results.add_row();
+        results.set_value("time", t);
+    }
+
+    EXPECT_FALSE(gauge::tag_outliers(
+        results, "cycles", gauge::outlier_method::tukey));
+    EXPECT_TRUE(gauge::tag_outliers(
+        results, "time", gauge::outlier_method::tukey));
+
+    // The results are kept as they were with the classes added
+    EXPECT_EQ(times.size(), results.rows());
+    EXPECT_EQ(times, results.values_as<double>("time"));
+    EXPECT_EQ("microseconds", results.values_as<std::string>("unit")[0]);
+
+    auto tags = results.values_as<std::string>("outlier");
+    EXPECT_EQ("", tags[0]);
+    EXPECT_EQ("high_severe", tags[5]);
+
+    auto rows = gauge::outlier_rows(results);
+    EXPECT_FALSE(rows[0]);
+    EXPECT_TRUE(rows[5]);
+
+    EXPECT_THROW(gauge::parse_outlier_policy("drop"), std::runtime_error);
+}
+
+TEST(test_outliers, classify_rows)
+{
+    tables::table results;
+    results.add_column("time");
+
+    std::vector<std::string> classes;
+    EXPECT_FALSE(gauge::classify_rows(
+        results, "time", gauge::outlier_method::tukey, classes));
+
+    std::vector<double> times = { 5.0, 5.1, 4.9, 5.0, 5.2, 50.0 };
+    for (auto t : times)
+    {
+        results.add_row();
+        results.set_value("time", t);
+    }
+
+    // The rows are classified without tagging the results
+    EXPECT_TRUE(gauge::classify_rows(
+        results, "time", gauge::outlier_method::tukey, classes));
+    ASSERT_EQ(times.size(), classes.size());
+    EXPECT_EQ("", classes[0]);
+    EXPECT_EQ("high_severe", classes[5]);
+    EXPECT_FALSE(results.has_column("outlier"));
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/gauge.hpp>
+#include <gauge/overhead.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(test_overhead, calibrate)
+{
+    const auto& o = gauge::calibrate_overhead("steady", 0);
+
+    EXPECT_GT(o.m_run, 0.0);
+    EXPECT_GE(o.m_iteration, 0.0);
+
+    // The calibration is only done once for each clock
+    EXPECT_EQ(&o, &gauge::calibrate_overhead("steady", 0));
+}
+
+/// Benchmark checking the overhead corrected time of every run
+struct overhead_benchmark : public gauge::time_benchmark
+{
+    bool overhead_correction() const
+    {
+        return true;
+    }
+
+    void store_run(tables::table& results)
+    {
+        gauge::time_benchmark::store_run(results);
+
+        ASSERT_TRUE(results.has_column("time_corrected"));
+        ASSERT_TRUE(results.has_column("overhead_run"));
+        ASSERT_TRUE(results.has_column("overhead_iteration"));
+
+        EXPECT_TRUE(results.is_constant("overhead_run"));
+        EXPECT_TRUE(results.is_constant("overhead_iteration"));
+
+        // The overhead is only ever subtracted
+        auto time = results.values_as<double>("time");
+        auto corrected = results.values_as<double>("time_corrected");
+        EXPECT_GE(corrected.back(), 0.0);
+        EXPECT_LE(corrected.back(), time.back());
+
+        const auto& o = gauge::calibrate_overhead(clock_name(),
+                                                  sample_interval());
+        EXPECT_DOUBLE_EQ(o.m_run / 1000.0,
+                         results.values_as<double>("overhead_run").back());
+        EXPECT_DOUBLE_EQ(
+            o.m_iteration / 1000.0,
+            results.values_as<double>("overhead_iteration").back());
+    }
+
+    void test_body()
+    {
+        RUN
+        {
+            uint32_t sum = 0;
+            for (uint32_t i = 0; i < 100; ++i)
+            {
+                sum = sum + i;
+                gauge::do_not_optimize(sum);
+            }
+        }
+    }
+};
+
+BENCHMARK_F(overhead_benchmark, overhead, corrected, 3);
@@ -0,0 +1,77 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/gauge.hpp>
+#include <gauge/perf_counters.hpp>
+
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(test_perf_counters, unknown_event)
+{
+    gauge::perf_counters counters;
+    EXPECT_THROW(counters.open({ "coffee_spills" }), std::runtime_error);
+}
+
+TEST(test_perf_counters, count_events)
+{
+    gauge::perf_counters counters;
+    counters.open(gauge::perf_counters::hardware_events());
+
+    // The counters may not be accessible e.g. due to the
+    // perf_event_paranoid setting or on other platforms than Linux
+    if (!counters.is_open())
+        return;
+
+    std::vector<std::string> events;
+    for (uint32_t group = 0; group < counters.group_count(); ++group)
+    {
+        auto group_events = counters.group_events(group);
+        EXPECT_FALSE(group_events.empty());
+
+        counters.select_group(group);
+        counters.start();
+
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < 100000; ++i)
+        {
+            sum = sum + i;
+            gauge::do_not_optimize(sum);
+        }
+
+        counters.stop();
+
+        EXPECT_EQ(group_events.size(), counters.counts().size());
+        events.insert(events.end(), group_events.begin(), group_events.end());
+    }
+
+    EXPECT_EQ(counters.events(), events);
+}
+
+/// Benchmark reading the performance counters around the RUN loop
+struct perf_benchmark : public gauge::perf_counter_benchmark
+{
+    void setup()
+    {
+        m_values.resize(1000);
+        std::iota(m_values.begin(), m_values.end(), 0);
+    }
+
+    void test_body()
+    {
+        RUN
+        {
+            uint32_t sum = std::accumulate(m_values.begin(), m_values.end(), 0U);
+            gauge::do_not_optimize(sum);
+        }
+    }
+
+    std::vector<uint32_t> m_values;
+};
+
+BENCHMARK_F(perf_benchmark, perf, accumulate, 5);
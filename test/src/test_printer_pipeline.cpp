@@ -0,0 +1,122 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gauge/gauge.hpp>
+#include <gauge/printer_pipeline.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(test_printer_pipeline, order)
+{
+    for (bool asynchronous : { false, true })
+    {
+        gauge::printer_pipeline pipeline;
+        pipeline.start(asynchronous, -1);
+
+        std::vector<uint32_t> done;
+        std::thread::id thread;
+
+        for (uint32_t i = 0; i < 100; ++i)
+        {
+            pipeline.post([&done, &thread, i]
+            {
+                done.push_back(i);
+                thread = std::this_thread::get_id();
+            });
+        }
+
+        pipeline.stop();
+
+        ASSERT_EQ(100U, done.size());
+        for (uint32_t i = 0; i < done.size(); ++i)
+            EXPECT_EQ(i, done[i]);
+
+        EXPECT_EQ(!asynchronous, thread == std::this_thread::get_id());
+    }
+}
+
+TEST(test_printer_pipeline, error)
+{
+    gauge::printer_pipeline pipeline;
+    pipeline.start(true, -1);
+
+    bool after = false;
+    pipeline.post([] { throw std::runtime_error("Error writing"); });
+    pipeline.post([&after] { after = true; });
+
+    EXPECT_THROW(pipeline.stop(), std::runtime_error);
+    EXPECT_FALSE(after);
+
+    // The pipeline can be started again
+    pipeline.start(true, -1);
+    pipeline.post([&after] { after = true; });
+    pipeline.stop();
+    EXPECT_TRUE(after);
+}
+
+TEST(test_printer_pipeline, wait)
+{
+    gauge::printer_pipeline pipeline;
+    pipeline.start(true, -1);
+
+    uint32_t done = 0;
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        pipeline.post([&done]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ++done;
+        });
+    }
+
+    // The work is done but the thread still runs
+    pipeline.wait();
+    EXPECT_EQ(10U, done);
+
+    pipeline.post([&done] { ++done; });
+    pipeline.stop();
+    EXPECT_EQ(11U, done);
+}
+
+namespace
+{
+/// True if the throwing benchmark should throw
+bool throw_in_body = false;
+}
+
+BENCHMARK(printer_pipeline, throwing, 1)
+{
+    if (throw_in_body)
+        throw std::runtime_error("Error in the body");
+
+    uint32_t value = 0;
+    RUN
+    {
+        gauge::do_not_optimize(++value);
+    }
+}
+
+TEST(test_printer_pipeline, benchmark_error)
+{
+    std::vector<const char*> argv =
+        { "program", "--gauge_filter=printer_pipeline.throwing",
+          "--warmup_time=0" };
+
+    // The printer thread is stopped when a benchmark throws, so the
+    // runner can be run again
+    auto& runner = gauge::runner::instance();
+
+    throw_in_body = true;
+    EXPECT_THROW(runner.run_unsafe((int)argv.size(), argv.data()),
+                 std::runtime_error);
+
+    throw_in_body = false;
+    EXPECT_NO_THROW(runner.run_unsafe((int)argv.size(), argv.data()));
+}
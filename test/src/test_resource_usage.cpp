@@ -0,0 +1,74 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/gauge.hpp>
+#include <gauge/resource_usage.hpp>
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+TEST(test_resource_usage, page_faults)
+{
+    gauge::resource_usage before;
+    gauge::resource_usage after;
+
+    gauge::reset_peak_rss();
+    ASSERT_TRUE(gauge::read_resource_usage(before));
+
+    // Touch every page of a new buffer
+    std::vector<uint8_t> buffer(16 * 1024 * 1024, 1);
+    gauge::do_not_optimize(buffer.data());
+    gauge::clobber_memory();
+
+    ASSERT_TRUE(gauge::read_resource_usage(after));
+
+    tables::table results;
+    results.add_row();
+    gauge::store_resource_usage(results, before, after);
+
+    for (const auto& column : gauge::resource_usage_columns())
+    {
+        EXPECT_TRUE(results.has_column(column)) << column;
+        EXPECT_FALSE(gauge::resource_usage_unit(column).empty());
+    }
+
+    EXPECT_GT(results.values_as<double>("minor_faults").back(), 0.0);
+    EXPECT_GT(results.values_as<double>("rss_delta").back(),
+              8.0 * 1024 * 1024);
+    EXPECT_GE(results.values_as<double>("rss_peak").back(),
+              static_cast<double>(after.m_rss));
+    EXPECT_GE(results.values_as<double>("cpu_user").back() +
+              results.values_as<double>("cpu_system").back(), 0.0);
+}
+
+TEST(test_resource_usage, process)
+{
+    gauge::resource_usage thread_before;
+    gauge::resource_usage thread_after;
+    gauge::resource_usage process_before;
+    gauge::resource_usage process_after;
+
+    ASSERT_TRUE(gauge::read_resource_usage(thread_before));
+    ASSERT_TRUE(gauge::read_resource_usage(process_before, true));
+
+    // The faults of another thread only count for the process
+    std::thread worker([]
+    {
+        std::vector<uint8_t> buffer(16 * 1024 * 1024, 1);
+        gauge::do_not_optimize(buffer.data());
+        gauge::clobber_memory();
+    });
+    worker.join();
+
+    ASSERT_TRUE(gauge::read_resource_usage(thread_after));
+    ASSERT_TRUE(gauge::read_resource_usage(process_after, true));
+
+    EXPECT_GT(process_after.m_minor_faults - process_before.m_minor_faults,
+              thread_after.m_minor_faults - thread_before.m_minor_faults);
+}
+#endif
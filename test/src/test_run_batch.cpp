@@ -0,0 +1,41 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/gauge.hpp>
+
+#include <gtest/gtest.h>
+
+struct batch_benchmark : public gauge::time_benchmark
+{
+    void store_run(tables::table& results)
+    {
+        gauge::time_benchmark::store_run(results);
+
+        EXPECT_EQ(8U, batch_size());
+        EXPECT_EQ(run_iterations() * 8, m_runs);
+
+        // The runner reports the number of times the body was run
+        auto iterations = results.values_as<uint64_t>("iterations");
+        EXPECT_EQ(m_runs, iterations.back());
+
+        ASSERT_TRUE(results.has_column("batch_size"));
+        EXPECT_EQ(8U, results.values_as<uint32_t>("batch_size").back());
+    }
+
+    void test_body()
+    {
+        m_runs = 0;
+
+        RUN_BATCH(8)
+        {
+            ++m_runs;
+            gauge::do_not_optimize(m_runs);
+        }
+    }
+
+    uint64_t m_runs;
+};
+
+BENCHMARK_F(batch_benchmark, batch, count, 3);
@@ -0,0 +1,77 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/run_quality.hpp>
+
+#include <tables/table.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(test_run_quality, snapshot)
+{
+    gauge::run_snapshot before;
+    gauge::run_snapshot after;
+
+#if defined(__unix__)
+    ASSERT_TRUE(gauge::take_run_snapshot(before));
+    ASSERT_TRUE(gauge::take_run_snapshot(after));
+
+    auto noise = gauge::compare_run_snapshots(before, after);
+    EXPECT_GE(after.m_switches, before.m_switches);
+    EXPECT_EQ(noise.m_switches, after.m_switches - before.m_switches);
+#else
+    EXPECT_FALSE(gauge::take_run_snapshot(before));
+#endif
+}
+
+TEST(test_run_quality, limits)
+{
+    gauge::run_snapshot before = { 0, 10, 100, 2000000 };
+    gauge::run_snapshot after = { 0, 12, 150, 1800000 };
+
+    auto noise = gauge::compare_run_snapshots(before, after);
+    EXPECT_EQ(2U, noise.m_switches);
+    EXPECT_FALSE(noise.m_migrated);
+    EXPECT_EQ(50U, noise.m_interrupts);
+    EXPECT_DOUBLE_EQ(-10.0, noise.m_frequency_change);
+
+    // Nothing is rejected without limits
+    gauge::noise_limits limits;
+    EXPECT_FALSE(gauge::is_noisy(noise, limits));
+
+    limits.m_max_switches = 2;
+    EXPECT_FALSE(gauge::is_noisy(noise, limits));
+    limits.m_max_switches = 1;
+    EXPECT_TRUE(gauge::is_noisy(noise, limits));
+
+    limits = gauge::noise_limits();
+    limits.m_max_interrupts = 49;
+    EXPECT_TRUE(gauge::is_noisy(noise, limits));
+
+    limits = gauge::noise_limits();
+    limits.m_max_frequency_change = 5;
+    EXPECT_TRUE(gauge::is_noisy(noise, limits));
+
+    // The interrupts of different CPUs are not compared
+    after.m_cpu = 1;
+    noise = gauge::compare_run_snapshots(before, after);
+    EXPECT_TRUE(noise.m_migrated);
+    EXPECT_EQ(0U, noise.m_interrupts);
+
+    limits = gauge::noise_limits();
+    EXPECT_FALSE(gauge::is_noisy(noise, limits));
+    limits.m_reject_migrations = true;
+    EXPECT_TRUE(gauge::is_noisy(noise, limits));
+
+    tables::table results;
+    results.add_row();
+    gauge::store_run_noise(results, noise, false);
+
+    EXPECT_TRUE(results.has_column("noise_switches"));
+    EXPECT_TRUE(results.has_column("noise_migrations"));
+    EXPECT_TRUE(results.has_column("noise_interrupts"));
+    EXPECT_FALSE(results.has_column("noise_frequency_change"));
+    EXPECT_EQ(1.0, results.values_as<double>("noise_migrations").back());
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cstdint>
+#include <vector>
+
+#include <gauge/speedup.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(test_speedup, calculate)
+{
+    gauge::speedup result;
+
+    // Three times the rate with four threads
+    ASSERT_TRUE(gauge::calculate_speedup(300.0, 100.0, 4, result));
+    EXPECT_DOUBLE_EQ(3.0, result.m_speedup);
+    EXPECT_DOUBLE_EQ(0.75, result.m_parallel_efficiency);
+    ASSERT_TRUE(result.m_has_serial_fraction);
+    EXPECT_DOUBLE_EQ(1.0 / 9.0, result.m_serial_fraction);
+
+    // Perfect scaling has no serial fraction
+    ASSERT_TRUE(gauge::calculate_speedup(800.0, 100.0, 8, result));
+    EXPECT_DOUBLE_EQ(8.0, result.m_speedup);
+    EXPECT_DOUBLE_EQ(1.0, result.m_parallel_efficiency);
+    EXPECT_NEAR(0.0, result.m_serial_fraction, 1e-12);
+
+    // No speedup at all is all serial
+    ASSERT_TRUE(gauge::calculate_speedup(100.0, 100.0, 2, result));
+    EXPECT_DOUBLE_EQ(0.5, result.m_parallel_efficiency);
+    EXPECT_DOUBLE_EQ(1.0, result.m_serial_fraction);
+
+    // The reference itself
+    ASSERT_TRUE(gauge::calculate_speedup(100.0, 100.0, 1, result));
+    EXPECT_DOUBLE_EQ(1.0, result.m_speedup);
+    EXPECT_DOUBLE_EQ(1.0, result.m_parallel_efficiency);
+    EXPECT_FALSE(result.m_has_serial_fraction);
+
+    // Nothing to compare with
+    EXPECT_FALSE(gauge::calculate_speedup(100.0, 0.0, 2, result));
+}
+
+TEST(test_speedup, sweep_thread_counts)
+{
+    // One thread is added to a sweep as the reference
+    std::vector<uint32_t> expected = { 1, 2, 4, 8 };
+    EXPECT_EQ(expected, gauge::sweep_thread_counts({ 8, 4, 2, 4 }));
+
+    expected = { 1, 3 };
+    EXPECT_EQ(expected, gauge::sweep_thread_counts({ 3, 1 }));
+
+    // A single count is not a sweep
+    expected = { 4 };
+    EXPECT_EQ(expected, gauge::sweep_thread_counts({ 4 }));
+
+    EXPECT_TRUE(gauge::sweep_thread_counts({ }).empty());
+}
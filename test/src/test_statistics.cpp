@@ -0,0 +1,73 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cstdint>
+#include <vector>
+
+#include <gauge/statistics.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(test_statistics, calculate_statistics)
+{
+    std::vector<uint64_t> values = { 7, 1, 3, 9, 5 };
+
+    gauge::statistics s =
+        gauge::calculate_statistics(values.cbegin(), values.cend());
+
+    EXPECT_EQ(5U, s.m_count);
+    EXPECT_DOUBLE_EQ(5.0, s.m_mean);
+    EXPECT_DOUBLE_EQ(9.0, s.m_max);
+    EXPECT_DOUBLE_EQ(1.0, s.m_min);
+    EXPECT_DOUBLE_EQ(5.0, s.m_median);
+    EXPECT_DOUBLE_EQ(2.0, s.m_mad);
+
+    // Sample variance of 1, 3, 5, 7, 9 is 10
+    EXPECT_NEAR(3.1623, s.m_std_dev, 1e-4);
+    EXPECT_NEAR(0.6325, s.m_cv, 1e-4);
+
+    // t(0.975, 4) = 2.776
+    EXPECT_NEAR(5.0 - 3.926, s.m_mean_ci_low, 1e-3);
+    EXPECT_NEAR(5.0 + 3.926, s.m_mean_ci_high, 1e-3);
+
+    // With few values the median interval covers them all
+    EXPECT_DOUBLE_EQ(1.0, s.m_median_ci_low);
+    EXPECT_DOUBLE_EQ(9.0, s.m_median_ci_high);
+}
+
+TEST(test_statistics, quantile)
+{
+    std::vector<double> values;
+    for (uint32_t i = 100; i > 0; --i)
+        values.push_back(i);
+
+    EXPECT_DOUBLE_EQ(1.0, gauge::quantile(values, 0.0));
+    EXPECT_DOUBLE_EQ(100.0, gauge::quantile(values, 1.0));
+    EXPECT_DOUBLE_EQ(50.5, gauge::quantile(values, 0.5));
+    EXPECT_DOUBLE_EQ(99.01, gauge::quantile(values, 0.99));
+}
+
+TEST(test_statistics, median_confidence_interval)
+{
+    std::vector<double> values;
+    for (uint32_t i = 0; i < 10000; ++i)
+        values.push_back((i * 7919) % 10000);
+
+    gauge::statistics s =
+        gauge::calculate_statistics(values.cbegin(), values.cend());
+
+    EXPECT_DOUBLE_EQ(4999.5, s.m_median);
+    EXPECT_LT(s.m_median_ci_low, s.m_median);
+    EXPECT_GT(s.m_median_ci_high, s.m_median);
+
+    // The interval spans about 1.96 * sqrt(n) ranks
+    EXPECT_NEAR(196.0, s.m_median_ci_high - s.m_median_ci_low, 5.0);
+
+    // A large constant offset does not disturb the variance
+    std::vector<double> shifted = { 1e9 + 1, 1e9 + 2, 1e9 + 3 };
+    gauge::statistics t =
+        gauge::calculate_statistics(shifted.cbegin(), shifted.cend());
+    EXPECT_DOUBLE_EQ(1.0, t.m_std_dev);
+}
@@ -0,0 +1,195 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include <gauge/baseline.hpp>
+#include <gauge/csv_stream_printer.hpp>
+#include <gauge/gauge.hpp>
+#include <gauge/jsonl_printer.hpp>
+
+#include <gtest/gtest.h>
+
+#include "dummy_benchmark.hpp"
+
+namespace
+{
+tables::table make_results(const std::string& benchmark,
+                           const std::string& column)
+{
+    tables::table results;
+    results.add_const_column("benchmark", benchmark);
+    results.add_column(column);
+
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        results.add_row();
+        results.set_value(column, 1.5 + i);
+    }
+
+    return results;
+}
+
+std::string read_file(const std::string& filename)
+{
+    std::ifstream file(filename);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+template<class Printer>
+void set_file(Printer& printer, const std::string& name,
+              const std::string& filename)
+{
+    gauge::po::variables_map options;
+    options.insert(std::make_pair("use_" + name,
+        gauge::po::variable_value(boost::any(true), false)));
+    options.insert(std::make_pair(name + "_file",
+        gauge::po::variable_value(boost::any(filename), false)));
+    printer.set_options(options);
+}
+}
+
+TEST(test_stream_printer, csv_schema_union)
+{
+    const std::string filename = "test_stream.csv";
+
+    gauge::csv_stream_printer printer;
+    set_file(printer, "csv_stream", filename);
+
+    dummy_benchmark info;
+    printer.start();
+    printer.benchmark_result(info, make_results("one", "time"));
+
+    // The results are on disk before the end of the program
+    EXPECT_EQ("benchmark,time\none,1.5\none,2.5\n", read_file(filename));
+
+    printer.benchmark_result(info, make_results("two,2", "cycles"));
+    printer.end();
+
+    EXPECT_EQ("benchmark,time,cycles\n"
+              "one,1.5,\n"
+              "one,2.5,\n"
+              "\"two,2\",,1.5\n"
+              "\"two,2\",,2.5\n", read_file(filename));
+
+    auto rows = gauge::read_result_file(filename);
+    ASSERT_EQ(4U, rows.size());
+    EXPECT_EQ("two,2", rows[3]["benchmark"]);
+
+    std::remove(filename.c_str());
+}
+
+TEST(test_stream_printer, csv_quoted_newline)
+{
+    const std::string filename = "test_stream_newline.csv";
+
+    gauge::csv_stream_printer printer;
+    set_file(printer, "csv_stream", filename);
+
+    dummy_benchmark info;
+    printer.start();
+    printer.benchmark_result(info, make_results("one\n\"two\"", "time"));
+
+    // The record with the newline is padded as a whole when the columns
+    // are widened
+    printer.benchmark_result(info, make_results("three", "cycles"));
+    printer.end();
+
+    EXPECT_EQ("benchmark,time,cycles\n"
+              "\"one\n\"\"two\"\"\",1.5,\n"
+              "\"one\n\"\"two\"\"\",2.5,\n"
+              "three,,1.5\n"
+              "three,,2.5\n", read_file(filename));
+
+    std::remove(filename.c_str());
+}
+
+TEST(test_stream_printer, jsonl)
+{
+    const std::string filename = "test_stream.jsonl";
+
+    gauge::jsonl_printer printer;
+    set_file(printer, "jsonl", filename);
+
+    dummy_benchmark info;
+    printer.start();
+    printer.benchmark_result(info, make_results("one", "time"));
+    printer.benchmark_result(info, make_results("t\"wo", "cycles"));
+    printer.end();
+
+    EXPECT_EQ("{\"benchmark\": \"one\", \"time\": 1.5}\n"
+              "{\"benchmark\": \"one\", \"time\": 2.5}\n"
+              "{\"benchmark\": \"t\\\"wo\", \"cycles\": 1.5}\n"
+              "{\"benchmark\": \"t\\\"wo\", \"cycles\": 2.5}\n",
+              read_file(filename));
+
+    gauge::result_row key = { { "benchmark", "t\"wo" } };
+    auto rows = gauge::read_result_file(filename);
+    std::vector<double> expected = { 1.5, 2.5 };
+    EXPECT_EQ(expected, gauge::baseline_values(rows, key, "cycles"));
+
+    std::remove(filename.c_str());
+}
+
+TEST(test_stream_printer, round_trip)
+{
+    const std::string filename = "test_round_trip.jsonl";
+
+    gauge::jsonl_printer printer;
+    set_file(printer, "jsonl", filename);
+
+    tables::table results;
+    results.add_const_column("benchmark", std::string("one"));
+    results.add_column("time");
+    results.add_row();
+    results.set_value("time", 0.1 + 0.2);
+    results.add_row();
+    results.set_value("time", 1.0 / 3.0);
+
+    dummy_benchmark info;
+    printer.start();
+    printer.benchmark_result(info, results);
+    printer.end();
+
+    // Every double is written with enough digits to be read back exactly
+    gauge::result_row key = { { "benchmark", "one" } };
+    auto rows = gauge::read_result_file(filename);
+    std::vector<double> expected = { 0.1 + 0.2, 1.0 / 3.0 };
+    EXPECT_EQ(expected, gauge::baseline_values(rows, key, "time"));
+
+    std::remove(filename.c_str());
+}
+
+TEST(test_stream_printer, non_finite)
+{
+    const std::string filename = "test_non_finite.jsonl";
+
+    gauge::jsonl_printer printer;
+    set_file(printer, "jsonl", filename);
+
+    tables::table results;
+    results.add_column("time");
+    results.add_row();
+    results.set_value("time", -std::numeric_limits<double>::quiet_NaN());
+    results.add_row();
+    results.set_value("time", -std::numeric_limits<double>::infinity());
+
+    dummy_benchmark info;
+    printer.start();
+    printer.benchmark_result(info, results);
+    printer.end();
+
+    // JSON has no NaN or infinity, whatever their sign
+    EXPECT_EQ("{\"time\": null}\n"
+              "{\"time\": null}\n", read_file(filename));
+
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/gauge.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "run_with_options.hpp"
+
+struct adaptive_benchmark : public gauge::time_benchmark
+{
+    void sleep(std::chrono::microseconds delay)
+    {
+        RUN
+        {
+            std::this_thread::sleep_for(delay);
+        }
+    }
+
+    bool m_slow = false;
+};
+
+BENCHMARK_F_INLINE(adaptive_benchmark, target_rel_ci, stable, 4)
+{
+    sleep(std::chrono::microseconds(2000));
+}
+
+BENCHMARK_F_INLINE(adaptive_benchmark, target_rel_ci, alternating, 4)
+{
+    // Every other run takes three times as long
+    m_slow = !m_slow;
+    sleep(std::chrono::microseconds(m_slow ? 3000 : 1000));
+}
+
+TEST(test_target_rel_ci, stops_at_target)
+{
+    auto results = run_with_options(
+        { "--gauge_filter=target_rel_ci.stable", "--target_rel_ci=0.5",
+          "--min_runs=4", "--max_runs=50" });
+    ASSERT_EQ(1U, results.size());
+
+    // A stable benchmark meets a loose target with the minimum runs
+    EXPECT_EQ(4U, results[0].rows());
+
+    ASSERT_TRUE(results[0].has_column("target_rel_ci"));
+    ASSERT_TRUE(results[0].has_column("rel_ci"));
+    EXPECT_TRUE(results[0].is_constant("target_rel_ci"));
+    EXPECT_TRUE(results[0].is_constant("rel_ci"));
+
+    EXPECT_EQ(0.5, results[0].values_as<double>("target_rel_ci").front());
+
+    double rel_ci = results[0].values_as<double>("rel_ci").front();
+    EXPECT_GE(rel_ci, 0.0);
+    EXPECT_LE(rel_ci, 0.5);
+}
+
+TEST(test_target_rel_ci, stops_at_max_runs)
+{
+    auto results = run_with_options(
+        { "--gauge_filter=target_rel_ci.alternating", "--target_rel_ci=0.001",
+          "--min_runs=4", "--max_runs=9" });
+    ASSERT_EQ(1U, results.size());
+
+    // The runs alternate between 1 and 3 ms so the target is never met
+    EXPECT_EQ(9U, results[0].rows());
+
+    ASSERT_TRUE(results[0].has_column("rel_ci"));
+    EXPECT_EQ(0.001, results[0].values_as<double>("target_rel_ci").front());
+    EXPECT_GT(results[0].values_as<double>("rel_ci").front(), 0.001);
+}
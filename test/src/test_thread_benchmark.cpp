@@ -0,0 +1,136 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gauge/gauge.hpp>
+#include <gauge/spin_barrier.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(test_thread_benchmark, spin_barrier)
+{
+    const uint32_t threads = 4;
+    const uint32_t phases = 3;
+
+    std::atomic<uint32_t> arrived(0);
+    uint32_t completions = 0;
+
+    gauge::spin_barrier barrier(threads, [&] { ++completions; });
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < threads; ++i)
+    {
+        workers.emplace_back([&]
+        {
+            for (uint32_t phase = 0; phase < phases; ++phase)
+            {
+                ++arrived;
+                barrier.wait();
+
+                // Nobody passes the barrier before everybody arrived
+                EXPECT_GE(arrived.load(), (phase + 1) * threads);
+            }
+        });
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    EXPECT_EQ(phases, completions);
+}
+
+struct counting_benchmark : public gauge::thread_benchmark
+{
+    void setup()
+    {
+        m_runs = 0;
+        m_seen = 0;
+    }
+
+    void store_run(tables::table& results)
+    {
+        gauge::thread_benchmark::store_run(results);
+
+        // Every thread ran all the iterations
+        auto iterations = results.values_as<uint64_t>("iterations");
+        EXPECT_EQ(run_iterations() * 3, iterations.back());
+        EXPECT_EQ(iterations.back(), m_runs.load());
+
+        // Every thread got its own index
+        EXPECT_EQ(7U, m_seen.load());
+
+        EXPECT_EQ(3U, results.values_as<uint32_t>("threads").front());
+        EXPECT_LT(results.values_as<uint32_t>("straggler_thread").back(), 3U);
+
+        auto fastest = results.values_as<double>("thread_time_min").back();
+        auto slowest = results.values_as<double>("thread_time_max").back();
+        EXPECT_LE(fastest, slowest);
+        EXPECT_GE(results.values_as<double>("imbalance").back(), 0.0);
+        EXPECT_GE(results.values_as<double>("straggler").back(), 0.0);
+
+        // The thread calling start() only waits for the threads, so
+        // nothing is counted on it
+        EXPECT_FALSE(track_allocations());
+        EXPECT_FALSE(count_topdown());
+        EXPECT_FALSE(results.has_column("frontend_bound"));
+    }
+
+    std::atomic<uint64_t> m_runs;
+    std::atomic<uint32_t> m_seen;
+};
+
+BENCHMARK_THREADS_F(counting_benchmark, threads, count, 3, 3)
+{
+    m_seen |= 1U << thread_index();
+
+    RUN
+    {
+        ++m_runs;
+    }
+}
+
+namespace
+{
+/// Delays the exit of every thread which touches it
+struct slow_exit
+{
+    ~slow_exit()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    bool m_touched = false;
+};
+
+thread_local slow_exit exit_delay;
+}
+
+struct exit_benchmark : public gauge::thread_benchmark
+{
+    void store_run(tables::table& results)
+    {
+        gauge::thread_benchmark::store_run(results);
+
+        // The clock stops when the bodies are done, before the threads
+        // exit and are joined
+        EXPECT_LT(elapsed_seconds(), 0.01);
+    }
+};
+
+BENCHMARK_THREADS_F(exit_benchmark, threads, slow_exit, 3, 2)
+{
+    exit_delay.m_touched = true;
+
+    uint64_t value = 0;
+    RUN
+    {
+        gauge::do_not_optimize(++value);
+    }
+}
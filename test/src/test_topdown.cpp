@@ -0,0 +1,66 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/topdown.hpp>
+
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+TEST(test_topdown, metric_events)
+{
+    std::map<std::string, double> counts =
+    {
+        { "slots", 1000.0 },
+        { "topdown-retiring", 400.0 },
+        { "topdown-bad-spec", 100.0 },
+        { "topdown-fe-bound", 200.0 },
+        { "topdown-be-bound", 300.0 }
+    };
+
+    gauge::topdown result;
+    ASSERT_TRUE(gauge::calculate_topdown(counts, result));
+
+    EXPECT_DOUBLE_EQ(0.4, result.m_retiring);
+    EXPECT_DOUBLE_EQ(0.1, result.m_bad_speculation);
+    EXPECT_DOUBLE_EQ(0.2, result.m_frontend_bound);
+    EXPECT_DOUBLE_EQ(0.3, result.m_backend_bound);
+}
+
+TEST(test_topdown, slot_events)
+{
+    std::map<std::string, double> counts =
+    {
+        { "topdown-total-slots", 1000.0 },
+        { "topdown-slots-issued", 550.0 },
+        { "topdown-slots-retired", 500.0 },
+        { "topdown-fetch-bubbles", 150.0 },
+        { "topdown-recovery-bubbles", 50.0 }
+    };
+
+    gauge::topdown result;
+    ASSERT_TRUE(gauge::calculate_topdown(counts, result));
+
+    EXPECT_DOUBLE_EQ(0.15, result.m_frontend_bound);
+    EXPECT_DOUBLE_EQ(0.1, result.m_bad_speculation);
+    EXPECT_DOUBLE_EQ(0.5, result.m_retiring);
+    EXPECT_DOUBLE_EQ(0.25, result.m_backend_bound);
+}
+
+TEST(test_topdown, missing_events)
+{
+    std::map<std::string, double> counts =
+    {
+        { "instructions", 1000.0 },
+        { "cycles", 500.0 }
+    };
+
+    gauge::topdown result;
+    EXPECT_FALSE(gauge::calculate_topdown(counts, result));
+
+    counts["topdown-total-slots"] = 0.0;
+    EXPECT_FALSE(gauge::calculate_topdown(counts, result));
+}
@@ -0,0 +1,47 @@
+// Copyright (c) 2012 Steinwurf ApS
+// All Rights Reserved
+//
+// Distributed under the "BSD License". See the accompanying LICENSE.rst file.
+
+#include <gauge/gauge.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+struct untimed_benchmark : public gauge::time_benchmark
+{
+    void store_run(tables::table& results)
+    {
+        gauge::time_benchmark::store_run(results);
+
+        // The sleep is excluded from the time but stored on its own
+        ASSERT_TRUE(results.has_column("time_paused"));
+
+        auto time = results.values_as<double>("time");
+        auto paused = results.values_as<double>("time_paused");
+
+        EXPECT_LT(time.back(), 100.0);
+        EXPECT_GE(paused.back(), 100.0 * 0.99);
+    }
+};
+
+BENCHMARK_F_INLINE(untimed_benchmark, untimed, macros, 3)
+{
+    RUN
+    {
+        PAUSE_TIMING;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        RESUME_TIMING;
+    }
+}
+
+BENCHMARK_F_INLINE(untimed_benchmark, untimed, guard, 3)
+{
+    RUN
+    {
+        gauge::untimed guard;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}